@@ -1,285 +1,201 @@
 #include "src/main/main.h"
+#include "src/platform/Window.h"
 
 
-//-----------------------------------------------------------------------------------------------------------------------------------------------------------------------------main loop, key handler
-
-LRESULT CALLBACK WinProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------------------settings
+struct AppSettings
+{
+	int width;
+	int height;
+	int frames; //0 - until window is closed or camera path ends
+	const char *keys; //pressed after init
+	int seed; //-1 - random scene
+	const char *camera_path; //played camera path
+	const char *record_path; //camera keys are saved to it
+	const char *csv_file; //per frame stats
+	const char *trace_file; //profiler output
+};
+
+void print_usage()
 {
-	LONG    lRet = 0;
+	printf("usage: frustum_culling [options]\n");
+	printf("  --size <w>x<h>          window or offscreen surface size (default %dx%d)\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+	printf("  --frames <n>            quit after n frames, 0 - when window is closed (default 0, headless 1000, with --path - path end)\n");
+	printf("  --keys <list>           keys pressed at start, see ReadME: 7,9 - gpu culling without hi-z, F2 - SSE_AABB_SOA...\n");
+	printf("  --path <file>           play camera path with fixed time step instead of mouse & keys, e.g. data/paths/flythrough.txt\n");
+	printf("  --record <file>         save camera path of interactive run\n");
+	printf("  --seed <n>              random scene seed (default - time, 1 with --path)\n");
+	printf("  --csv <file>            write per frame culling & draw time, visible objects & uploaded bytes\n");
+	printf("  --trace <file>          profile cpu & gpu stages, chrome trace of the last frames is written at exit & by 'P' key\n");
+}
 
-	switch (uMsg)
+//single characters, F1..F12, SPACE
+int parse_key(const char *name)
+{
+	if (!strcmp(name, "SPACE"))
+		return KEY_SPACE;
+	if ((name[0] == 'F' || name[0] == 'f') && name[1] >= '1' && name[1] <= '9')
 	{
-	case WM_SIZE:										// If the window is resized
-		if (!g_bFullScreen)								// Do this only if we are NOT in full screen
-		{
-			SizeOpenGLScreen(LOWORD(lParam), HIWORD(lParam));// LoWord=Width, HiWord=Height
-			GetClientRect(hWnd, &g_rRect);				// Get the window rectangle
-		}
-		break;
-
-
-	case WM_KEYDOWN:
-		switch (wParam) {							// Check if we hit a key
-		case VK_ESCAPE:								// If we hit the escape key
-			PostQuitMessage(0);						// Send a QUIT message to the window
-			break;
-		default:
-			process_key(wParam);
-			break;
-		}
-		break;
-
-
-	case WM_DESTROY:									// If the window is destroyed
-		PostQuitMessage(0);								// Send a QUIT Message to the window
-		break;
-
-	default:											// Return by default
-		lRet = (long)DefWindowProc(hWnd, uMsg, wParam, lParam);
-		break;
+		int n = atoi(&name[1]);
+		if (n >= 1 && n <= 12)
+			return KEY_F1 + n - 1;
 	}
-	return lRet;										// Return by default
+	if (name[0] && !name[1])
+		return toupper(name[0]);
+	return -1;
 }
 
-
-WPARAM MainLoop()
+bool parse_settings(int argc, char **argv, AppSettings &settings)
 {
-	MSG msg;
+	settings.width = SCREEN_WIDTH;
+	settings.height = SCREEN_HEIGHT;
+	settings.frames = -1;
+	settings.keys = NULL;
+	settings.seed = -1;
+	settings.camera_path = NULL;
+	settings.record_path = NULL;
+	settings.csv_file = NULL;
+	settings.trace_file = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
 
-	while (1)											// Do our infinite loop
-	{													// Check if there was a message
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+		{
+			print_usage();
+			exit(0);
+		}
+		else if (!value)
 		{
-			if (msg.message == WM_QUIT)					// If the message wasn't to quit
-				break;
-			TranslateMessage(&msg);						// Find out what the message does
-			DispatchMessage(&msg);						// Execute the message
+			fprintf(stderr, "missing value for %s\n", arg);
+			return false;
 		}
-		else											// If there wasn't a message
+		else if (!strcmp(arg, "--size"))
 		{
-			RenderScene();								// Render the scene every frame 
+			if (sscanf(value, "%dx%d", &settings.width, &settings.height) != 2 || settings.width <= 0 || settings.height <= 0)
+			{
+				fprintf(stderr, "wrong size %s\n", value);
+				return false;
+			}
 		}
+		else if (!strcmp(arg, "--frames"))
+			settings.frames = atoi(value);
+		else if (!strcmp(arg, "--keys"))
+			settings.keys = value;
+		else if (!strcmp(arg, "--path"))
+			settings.camera_path = value;
+		else if (!strcmp(arg, "--record"))
+			settings.record_path = value;
+		else if (!strcmp(arg, "--seed"))
+			settings.seed = atoi(value);
+		else if (!strcmp(arg, "--csv"))
+			settings.csv_file = value;
+		else if (!strcmp(arg, "--trace"))
+			settings.trace_file = value;
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", arg);
+			return false;
+		}
+		i++;
 	}
 
-	if (opengl_debug_mode_enabled)
-		CheckDebugLog();
-	DeInit();											// Clean up and free all allocated memory
-
-	ShutDown();
-
-	return(msg.wParam);									// Return from the program
-}
-
-
-//-------------------------------------------------------------------------------------------------------------------------------------app init
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hprev, PSTR cmdline, int ishow);
-
-int main(int argc, char* argv[])
-{
-	HINSTANCE hInst = (HINSTANCE)GetWindowLong(GetActiveWindow(), GWL_HINSTANCE);
-	WinMain(hInst, NULL, NULL, 1);
-	return 0;
-}
-
-void ChangeToFullScreen()
-{
-	DEVMODE dmSettings;									// Device Mode variable
-	memset(&dmSettings, 0, sizeof(dmSettings));			// Makes Sure Memory's Cleared
-	if (!EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &dmSettings))
+	if (settings.camera_path && settings.record_path)
 	{
-		MessageBox(NULL, "Could Not Enum Display Settings", "Error", MB_OK);
-		return;
+		fprintf(stderr, "camera path can`t be played & recorded at once\n");
+		return false;
 	}
+	if (settings.frames < 0)
+		settings.frames = window_is_headless() && !settings.camera_path ? 1000 : 0;
+	if (settings.seed < 0 && settings.camera_path)
+		settings.seed = 1; //the same scene for every run of the path
 
-	dmSettings.dmPelsWidth = SCREEN_WIDTH;				// Selected Screen Width
-	dmSettings.dmPelsHeight = SCREEN_HEIGHT;			// Selected Screen Height
-	int result = ChangeDisplaySettings(&dmSettings, CDS_FULLSCREEN);
-
-	if (result != DISP_CHANGE_SUCCESSFUL)
+	if (settings.keys)
 	{
-		MessageBox(NULL, "Display Mode Not Compatible", "Error", MB_OK);
-		PostQuitMessage(0);
+		char keys[256];
+		strncpy(keys, settings.keys, sizeof(keys) - 1);
+		keys[sizeof(keys) - 1] = '\0';
+		for (char *token = strtok(keys, ","); token; token = strtok(NULL, ","))
+			if (parse_key(token) < 0)
+			{
+				fprintf(stderr, "unknown key %s\n", token);
+				return false;
+			}
 	}
+	return true;
 }
 
-HWND CreateMyWindow(LPSTR strWindowName, int width, int height, DWORD dwStyle, bool bFullScreen, HINSTANCE hInstance)
+void press_keys(const char *list)
 {
-	HWND hWnd;
-	WNDCLASS wndclass;
-
-	memset(&wndclass, 0, sizeof(WNDCLASS));				// Init the size of the class
-	wndclass.style = CS_HREDRAW | CS_VREDRAW;			// Regular drawing capabilities
-	wndclass.lpfnWndProc = WinProc;						// Pass our function pointer as the window procedure
-	wndclass.hInstance = hInstance;						// Assign our hInstance
-	wndclass.hIcon = LoadIcon(NULL, IDI_APPLICATION);	// General icon
-	wndclass.hCursor = LoadCursor(NULL, IDC_ARROW);		// An arrow for the cursor
-	wndclass.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);	// A white window
-	wndclass.lpszClassName = "Engine";			// Assign the class name
-
-	RegisterClass(&wndclass);							// Register the class
-
-	if (bFullScreen && !dwStyle) 						// Check if we wanted full screen mode
-	{													// Set the window properties for full screen mode
-		dwStyle = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
-		ChangeToFullScreen();							// Go to full screen
-		ShowCursor(FALSE);								// Hide the cursor
-	}
-	else if (!dwStyle)									// Assign styles to the window depending on the choice
-		dwStyle = WS_OVERLAPPEDWINDOW | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
-
-	g_hInstance = hInstance;							// Assign our global hInstance to the window's hInstance
-
-	RECT rWindow;
-	rWindow.left = 0;								// Set Left Value To 0
-	rWindow.right = width;							// Set Right Value To Requested Width
-	rWindow.top = 0;								// Set Top Value To 0
-	rWindow.bottom = height;							// Set Bottom Value To Requested Height
-
-	AdjustWindowRect(&rWindow, dwStyle, false);		// Adjust Window To True Requested Size
-
-													// Create the window
-	hWnd = CreateWindow("Engine", strWindowName, dwStyle, 0, 0,
-		rWindow.right - rWindow.left, rWindow.bottom - rWindow.top,
-		NULL, NULL, hInstance, NULL);
-
-	if (!hWnd) return NULL;								// If we could get a handle, return NULL
-
-	ShowWindow(hWnd, SW_SHOWNORMAL);					// Show the window
-	UpdateWindow(hWnd);									// Draw the window
-
-	SetFocus(hWnd);										// Sets Keyboard Focus To The Window	
-
-	return hWnd;
-}
-
-bool bSetupPixelFormat(HDC hdc)
-{
-	int pixelformat, format;
-	PIXELFORMATDESCRIPTOR pfd;
-	memset(&pfd, 0, sizeof(pfd));
-	pfd.nSize = sizeof(pfd);
-	pfd.nVersion = 1;
-	pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-	pfd.iPixelType = PFD_TYPE_RGBA;
-	pfd.cColorBits = 32;
-	pfd.cDepthBits = 24;
-
-	if ((pixelformat = ChoosePixelFormat(hdc, &pfd)) == FALSE)
-	{
-		MessageBox(NULL, "ChoosePixelFormat failed", "Error", MB_OK);
-		return FALSE;
-	}
-
-	if (SetPixelFormat(hdc, pixelformat, &pfd) == FALSE)
-	{
-		MessageBox(NULL, "SetPixelFormat failed", "Error", MB_OK);
-		return FALSE;
-	}
-
-	return TRUE;
+	char keys[256];
+	strncpy(keys, list, sizeof(keys) - 1);
+	keys[sizeof(keys) - 1] = '\0';
+	for (char *token = strtok(keys, ","); token; token = strtok(NULL, ","))
+		process_key(parse_key(token));
 }
 
 
-
-#define WGL_CONTEXT_LAYER_PLANE_ARB             0x2093
-#define WGL_CONTEXT_MAJOR_VERSION_ARB           0x2091
-#define WGL_CONTEXT_MINOR_VERSION_ARB           0x2092
-#define WGL_CONTEXT_CORE_PROFILE_BIT_ARB        0x00000001
-#define WGL_CONTEXT_PROFILE_MASK_ARB            0x9126
-
-void InitializeOpenGL(int width, int height)
+//-----------------------------------------------------------------------------------------------------------------------------------------------------------------------------main loop
+int MainLoop(int max_frames)
 {
-	g_hDC = GetDC(g_hWnd);								// This sets our global HDC
-														// We don't free this hdc until the end of our program
-	if (!bSetupPixelFormat(g_hDC))						// This sets our pixel format/information
-		PostQuitMessage(0);							    // If there's an error, quit
-
-	g_hRC = wglCreateContext(g_hDC);					// This creates a rendering context from our hdc
-	wglMakeCurrent(g_hDC, g_hRC);						// This makes the rendering context we just created the one we want to use
-
-//get max gl version
-	int  major, minor;
-	glGetIntegerv(GL_MAJOR_VERSION, &major);
-	glGetIntegerv(GL_MINOR_VERSION, &minor);
-	//major = 3; minor = 0;
+	int num_frames = 0;
+	int width, height;
+	Timer timer;
+	timer.StartTiming();
 
-	typedef HGLRC(APIENTRYP PFNWGLCREATECONTEXTATTRIBSARBPROC)(HDC, HGLRC, const int *);
-	PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB = NULL;
-	int attributes[] =
+	while (window_process_events(process_key))
 	{
-		WGL_CONTEXT_MAJOR_VERSION_ARB, major,
-		WGL_CONTEXT_MINOR_VERSION_ARB, minor,
-		WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB |
-		WGL_CONTEXT_DEBUG_BIT_ARB,
-		WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-		0
-	};
+		window_get_size(width, height);
+		if (width != window_width || height != window_height)
+			SizeOpenGLScreen(width, height);
 
-	wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC)
-		wglGetProcAddress("wglCreateContextAttribsARB");
-
-	if (NULL == wglCreateContextAttribsARB)
-	{
-		wglDeleteContext(g_hRC);
-		return;
+		RenderScene();
+		num_frames++;
+		if ((max_frames > 0 && num_frames >= max_frames) || is_camera_path_finished())
+			break;
 	}
 
-	HGLRC hRC = wglCreateContextAttribsARB(g_hDC, 0, attributes);
-	if (!hRC)
-	{
-		wglDeleteContext(g_hRC);
-		return;
-	}
-	if (!wglMakeCurrent(g_hDC, hRC))
-	{
-		wglDeleteContext(g_hRC);
-		wglDeleteContext(hRC);
-		return;
-	}
-	wglDeleteContext(g_hRC);
+	double elapsed_ms = timer.TimeElapsedInMS();
+	if (num_frames)
+		printf("%d frames, %.3f ms per frame\n", num_frames, elapsed_ms / num_frames);
+
+	if (opengl_debug_mode_enabled)
+		CheckDebugLog();
+	ShutDown();											// Free gl objects while context is alive
+	window_destroy();
+	return 0;
 }
 
 
-void DeInit()
+//-------------------------------------------------------------------------------------------------------------------------------------app init
+int main(int argc, char* argv[])
 {
-	if (g_hRC)
-	{
-		wglMakeCurrent(NULL, NULL);						// This frees our rendering memory and sets everything back to normal
-		wglDeleteContext(g_hRC);						// Delete our OpenGL Rendering Context	
-	}
-
-	if (g_hDC)
-		ReleaseDC(g_hWnd, g_hDC);						// Release our HDC from memory
-
-	if (g_bFullScreen)									// If we were in full screen:
+	AppSettings settings;
+	if (!parse_settings(argc, argv, settings))
 	{
-		ChangeDisplaySettings(NULL, 0);					// Switch Back To The Desktop
-		ShowCursor(TRUE);								// Show Mouse Pointer
+		print_usage();
+		return 2;
 	}
 
-	UnregisterClass("Engine", g_hInstance);				// Free the window class
-
-	PostQuitMessage(0);									// Post a QUIT message to the window
-}
-
-
-void set_vsync(bool enabled)
-{
-	typedef BOOL(APIENTRY * wglSwapIntervalEXT_Func)(int);
-	wglSwapIntervalEXT_Func wglSwapIntervalEXT = wglSwapIntervalEXT_Func(wglGetProcAddress("wglSwapIntervalEXT"));
-	if (wglSwapIntervalEXT) wglSwapIntervalEXT(enabled ? 1 : 0);
+	set_scene_seed(settings.seed);
+	if (settings.camera_path && !play_camera_path(settings.camera_path))
+		return 1;
+	if (settings.record_path)
+		record_camera_path(settings.record_path);
+	if (settings.csv_file && !open_frame_stats(settings.csv_file))
+		return 1;
+	if (settings.trace_file)
+		enable_profiler(settings.trace_file);
+
+	if (!window_create("Frustum culling", settings.width, settings.height, false))
+		return 1;
+	window_set_vsync(false);
+
+	Init();
+	if (settings.keys)
+		press_keys(settings.keys);
+
+	return MainLoop(settings.frames);
 }
-
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hprev, PSTR cmdline, int ishow)
-{
-	HWND hWnd;
-	g_bFullScreen = false;
-
-	hWnd = CreateMyWindow("Frustum culling", SCREEN_WIDTH, SCREEN_HEIGHT, 0, g_bFullScreen, hInstance);
-	if (hWnd == NULL) return TRUE;
-
-	Init(hWnd);
-	set_vsync(false);
-
-	return (int)MainLoop();
-}
\ No newline at end of file
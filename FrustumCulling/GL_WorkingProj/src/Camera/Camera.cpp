@@ -1,8 +1,6 @@
-#pragma comment(lib, "winmm.lib")
-
-#include "camera.h"
-
-extern HWND g_hWnd;
+#include "Camera.h"
+#include "../Timer/Timer.h"
+#include "../platform/Window.h"
 
 // Our global float that stores the elapsed time between the current and last frame
 double g_FrameInterval = 0.0f;
@@ -17,7 +15,7 @@ void CalculateFrameRate(bool show_framerate)
 	static double frameTime = 0.0f;				// This stores the last frame's time
 
 	// Get the current time in seconds
-    double currentTime = timeGetTime() * 0.001f;				
+    double currentTime = GetTimeInSeconds();				
 
 	// Here we store the elapsed time between the current and last frame,
 	// then keep the current frame in our static variable for the next frame.
@@ -40,7 +38,7 @@ void CalculateFrameRate(bool show_framerate)
 
 		// Set the window title bar to our string
 		if (show_framerate)
-			SetWindowText(g_hWnd, strFrameRate);
+			window_set_title(strFrameRate);
 
 		// Reset the frames per second
         framesPerSecond = 0;
@@ -57,6 +55,7 @@ CCamera::CCamera()
 	kSpeed = 10.f;
 
 	show_framerate = true;
+	user_input = true;
 }
 
 
@@ -83,33 +82,28 @@ void CCamera::SetViewByMouse()
 	static int mouseX = 0;
 	static int mouseY = 0;
 	static bool r_button_pressed = false;
-	if ((GetKeyState(VK_RBUTTON) & 0x80) && !r_button_pressed)
-	{
-		POINT mousePos;
-		GetCursorPos(&mousePos);
-		mouseX = mousePos.x;
-		mouseY = mousePos.y;
-	}
-	r_button_pressed = (GetKeyState(VK_RBUTTON) & 0x80);
+	if (window_is_key_down(KEY_RBUTTON) && !r_button_pressed)
+		window_get_cursor_pos(mouseX, mouseY);
+	r_button_pressed = window_is_key_down(KEY_RBUTTON);
 	if (!r_button_pressed)
 		return;
 
 
-	POINT mousePos;
+	int mousePosX, mousePosY;
 	float angleY = 0.0f; // for looking up or down
 	float angleZ = 0.0f; // to rotate around the Y axis (Left and Right)
 	static float currentRotX = 0.0f;
 	
 	// get the mouse's current X,Y position
-	GetCursorPos(&mousePos);						
-	if( (mousePos.x == mouseX) && (mousePos.y == mouseY) ) return;
+	if (!window_get_cursor_pos(mousePosX, mousePosY)) return;
+	if( (mousePosX == mouseX) && (mousePosY == mouseY) ) return;
 
 	// restore mouse position
-	SetCursorPos(mouseX, mouseY);							
+	window_set_cursor_pos(mouseX, mouseY);
 
 //roate camera view
-	angleY = (float)( (mousePos.x - mouseX) ) / 200.0f;
-	angleZ = (float)( (mousePos.y - mouseY) ) / 200.0f;
+	angleY = (float)( (mousePosX - mouseX) ) / 200.0f;
+	angleZ = (float)( (mousePosY - mouseY) ) / 200.0f;
 
 	static float lastRotX = 0.0f; 
  	lastRotX = currentRotX; // We store off the currentRotX and will use it in when the angle is capped
@@ -191,19 +185,19 @@ void CCamera::CheckForMovement()
 	// Once we have the frame interval, we find the current speed
 	float speed = kSpeed * g_FrameInterval;
 
-	if(GetKeyState('W') & 0x80) {				
+	if(window_is_key_down('W')) {				
 		MoveCamera(speed);				
 	}
 
-	if(GetKeyState('S') & 0x80) {			
+	if(window_is_key_down('S')) {			
 		MoveCamera(-speed);				
 	}
 
-	if(GetKeyState('A') & 0x80) {			
+	if(window_is_key_down('A')) {			
 		StrafeCamera(-speed);
 	}
 
-	if(GetKeyState('D') & 0x80) {			
+	if(window_is_key_down('D')) {			
 		StrafeCamera(speed);
 	}	
 }
@@ -214,11 +208,14 @@ void CCamera::Update()
 	// Calculate our frame rate and set our frame interval for time-based movement
 	CalculateFrameRate(show_framerate);
 
-	// Move the camera's view by the mouse
-	SetViewByMouse();
+	if (user_input)
+	{
+		// Move the camera's view by the mouse
+		SetViewByMouse();
 
-	// This checks to see if the keyboard was pressed
-	CheckForMovement();
+		// This checks to see if the keyboard was pressed
+		CheckForMovement();
+	}
 
 	// Initialize a variable for the cross product result
 	vec3 vCross = (m_vView - m_vPosition) ^ m_vUpVector;
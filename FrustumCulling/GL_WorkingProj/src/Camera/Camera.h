@@ -1,14 +1,11 @@
 #ifndef _CAMERA_H
 #define _CAMERA_H
 
-#include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <gl\gl.h>
-#include <gl\glu.h>
 
-#include "..\math\mathlib.h"
+#include "../math/mathlib.h"
 
 
 // This is our camera class
@@ -48,6 +45,7 @@ public:
 	void Update();
 
 	bool show_framerate;
+	bool user_input; // Mouse & keys move the camera, it's off while camera is played by camera path
 
 private:
 	vec3 m_vPosition; // The camera's position
@@ -0,0 +1,130 @@
+#include "CameraPath.h"
+#include <stdio.h>
+#include <string.h>
+
+
+CameraPath::CameraPath()
+{
+}
+
+CameraPath::~CameraPath()
+{
+}
+
+bool CameraPath::load(const char *file_name)
+{
+	clear();
+	FILE *f = fopen(file_name, "r");
+	if (!f)
+	{
+		fprintf(stderr, "can`t open \"%s\" file\n", file_name);
+		return false;
+	}
+
+	char line[256];
+	int line_number = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), f))
+	{
+		line_number++;
+		char *comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		CameraPathKey key;
+		int num_values = sscanf(line, "%f %f %f %f %f %f %f", &key.time, &key.position.x, &key.position.y, &key.position.z, &key.view.x, &key.view.y, &key.view.z);
+		if (num_values <= 0)
+			continue; //empty line
+
+		if (num_values != 7 || (!keys.empty() && key.time <= keys.back().time))
+		{
+			fprintf(stderr, "%s(%d): wrong camera key, expected increasing time & 6 coordinates\n", file_name, line_number);
+			ok = false;
+		}
+		else
+			keys.push_back(key);
+	}
+	fclose(f);
+
+	if (ok && keys.empty())
+	{
+		fprintf(stderr, "%s: camera path has no keys\n", file_name);
+		ok = false;
+	}
+	if (!ok)
+		clear();
+	return ok;
+}
+
+bool CameraPath::save(const char *file_name) const
+{
+	FILE *f = fopen(file_name, "w");
+	if (!f)
+	{
+		fprintf(stderr, "can`t open \"%s\" file\n", file_name);
+		return false;
+	}
+
+	fprintf(f, "#time position view\n");
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		const CameraPathKey &key = keys[i];
+		fprintf(f, "%.3f %.4f %.4f %.4f %.4f %.4f %.4f\n", key.time, key.position.x, key.position.y, key.position.z, key.view.x, key.view.y, key.view.z);
+	}
+	fclose(f);
+	return true;
+}
+
+void CameraPath::clear()
+{
+	keys.clear();
+}
+
+void CameraPath::add_key(float time, const vec3 &position, const vec3 &view)
+{
+	CameraPathKey key;
+	key.time = time;
+	key.position = position;
+	key.view = view;
+	keys.push_back(key);
+}
+
+//uniform catmull-rom: passes through p1 at t = 0 & p2 at t = 1
+static vec3 catmull_rom(const vec3 &p0, const vec3 &p1, const vec3 &p2, const vec3 &p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return (p1 * 2.f + (p2 - p0) * t + (p0 * 2.f - p1 * 5.f + p2 * 4.f - p3) * t2 + (p1 * 3.f - p0 - p2 * 3.f + p3) * t3) * 0.5f;
+}
+
+void CameraPath::evaluate(float time, vec3 &position, vec3 &view) const
+{
+	int num_keys = (int)keys.size();
+	if (!num_keys)
+		return;
+	if (time <= keys[0].time || num_keys == 1)
+	{
+		position = keys[0].position;
+		view = keys[0].view;
+		return;
+	}
+	if (time >= keys[num_keys - 1].time)
+	{
+		position = keys[num_keys - 1].position;
+		view = keys[num_keys - 1].view;
+		return;
+	}
+
+	//segment i..i+1 contains time, its neighbours are clamped at path ends
+	int i = 0;
+	while (keys[i + 1].time <= time)
+		i++;
+	const CameraPathKey &k0 = keys[i > 0 ? i - 1 : 0];
+	const CameraPathKey &k1 = keys[i];
+	const CameraPathKey &k2 = keys[i + 1];
+	const CameraPathKey &k3 = keys[i + 2 < num_keys ? i + 2 : num_keys - 1];
+
+	float t = (time - k1.time) / (k2.time - k1.time);
+	position = catmull_rom(k0.position, k1.position, k2.position, k3.position, t);
+	view = catmull_rom(k0.view, k1.view, k2.view, k3.view, t);
+}
@@ -0,0 +1,39 @@
+#ifndef _CAMERA_PATH_H
+#define _CAMERA_PATH_H
+
+#include <vector>
+#include "../math/mathlib.h"
+
+//camera keys (time, position, view point) for reproducible profiling runs. Keys are recorded from the camera or written by hand,
+//camera between them moves by catmull-rom spline, so a few keys give smooth flythrough.
+//text file: one key per line "time px py pz vx vy vz", '#' starts comment
+struct CameraPathKey
+{
+	float time; //seconds from path start, keys are sorted by it
+	vec3 position;
+	vec3 view;
+};
+
+class CameraPath
+{
+public:
+	CameraPath();
+	~CameraPath();
+
+	bool load(const char *file_name);
+	bool save(const char *file_name) const;
+	void clear();
+
+	void add_key(float time, const vec3 &position, const vec3 &view); //time should be greater than time of the last key
+
+	//camera at path time, clamped to the first & the last keys
+	void evaluate(float time, vec3 &position, vec3 &view) const;
+
+	int get_num_keys() const { return (int)keys.size(); }
+	float get_duration() const { return keys.empty() ? 0.f : keys.back().time; }
+
+private:
+	std::vector<CameraPathKey> keys;
+};
+
+#endif
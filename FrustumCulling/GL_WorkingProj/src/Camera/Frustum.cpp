@@ -1,4 +1,3 @@
-#include <windows.h>
 #include "Frustum.h"
 
 enum FrustumSide
@@ -30,29 +29,13 @@ void normalizePlane(vec4 &frustum_plane)
 
 void CFrustum::CalculateFrustum(mat4 &view_matrix, mat4 &proj_matrix)
 {
-	float   *proj = &proj_matrix.mat[0];
-	float   *modl = &view_matrix.mat[0];
-	float   clip[16]; //clipping planes
-
-	clip[0] = modl[0] * proj[0] + modl[1] * proj[4] + modl[2] * proj[8] + modl[3] * proj[12];
-	clip[1] = modl[0] * proj[1] + modl[1] * proj[5] + modl[2] * proj[9] + modl[3] * proj[13];
-	clip[2] = modl[0] * proj[2] + modl[1] * proj[6] + modl[2] * proj[10] + modl[3] * proj[14];
-	clip[3] = modl[0] * proj[3] + modl[1] * proj[7] + modl[2] * proj[11] + modl[3] * proj[15];
-
-	clip[4] = modl[4] * proj[0] + modl[5] * proj[4] + modl[6] * proj[8] + modl[7] * proj[12];
-	clip[5] = modl[4] * proj[1] + modl[5] * proj[5] + modl[6] * proj[9] + modl[7] * proj[13];
-	clip[6] = modl[4] * proj[2] + modl[5] * proj[6] + modl[6] * proj[10] + modl[7] * proj[14];
-	clip[7] = modl[4] * proj[3] + modl[5] * proj[7] + modl[6] * proj[11] + modl[7] * proj[15];
-
-	clip[8] = modl[8] * proj[0] + modl[9] * proj[4] + modl[10] * proj[8] + modl[11] * proj[12];
-	clip[9] = modl[8] * proj[1] + modl[9] * proj[5] + modl[10] * proj[9] + modl[11] * proj[13];
-	clip[10] = modl[8] * proj[2] + modl[9] * proj[6] + modl[10] * proj[10] + modl[11] * proj[14];
-	clip[11] = modl[8] * proj[3] + modl[9] * proj[7] + modl[10] * proj[11] + modl[11] * proj[15];
+	CalculateFrustum(proj_matrix * view_matrix);
+}
 
-	clip[12] = modl[12] * proj[0] + modl[13] * proj[4] + modl[14] * proj[8] + modl[15] * proj[12];
-	clip[13] = modl[12] * proj[1] + modl[13] * proj[5] + modl[14] * proj[9] + modl[15] * proj[13];
-	clip[14] = modl[12] * proj[2] + modl[13] * proj[6] + modl[14] * proj[10] + modl[15] * proj[14];
-	clip[15] = modl[12] * proj[3] + modl[13] * proj[7] + modl[14] * proj[11] + modl[15] * proj[15];
+//planes are sums & differences of clip matrix rows: -w <= x <= w -> (row3 + row0) * p >= 0, (row3 - row0) * p >= 0
+void CFrustum::CalculateFrustum(const mat4 &view_proj_matrix)
+{
+	const float *clip = &view_proj_matrix.mat[0];
 
 	frustum_planes[RIGHT][A] = clip[3] - clip[0];
 	frustum_planes[RIGHT][B] = clip[7] - clip[4];
@@ -89,4 +72,7 @@ void CFrustum::CalculateFrustum(mat4 &view_matrix, mat4 &proj_matrix)
 	frustum_planes[FRONT][C] = clip[11] + clip[10];
 	frustum_planes[FRONT][D] = clip[15] + clip[14];
 	normalizePlane(frustum_planes[FRONT]);
+
+	for (int i = 0; i < 6; i++)
+		plane_octants[i] = plane_octant(frustum_planes[i]);
 }
\ No newline at end of file
@@ -1,12 +1,18 @@
 #ifndef _FRUSTUM_H
 #define _FRUSTUM_H
 
-#include <windows.h>
-#include <gl\gl.h>
-#include <gl\glext.h>
-#include "..\glext\glext.h"
-#include "..\math\mathlib.h"
+#include "../math/mathlib.h"
 
+//plane octant - bits of plane normal components which are not negative: x - 1, y - 2, z - 4.
+//aabb corner farthest along the normal (positive vertex) takes max coordinates on axes with set bits & min coordinates on others
+const int PLANE_OCTANT_X = 1;
+const int PLANE_OCTANT_Y = 2;
+const int PLANE_OCTANT_Z = 4;
+
+inline int plane_octant(const vec4 &plane)
+{
+	return (plane.x >= 0.f ? PLANE_OCTANT_X : 0) | (plane.y >= 0.f ? PLANE_OCTANT_Y : 0) | (plane.z >= 0.f ? PLANE_OCTANT_Z : 0);
+}
 
 class CFrustum 
 {
@@ -15,8 +21,10 @@ public:
 	~CFrustum(){};
 
 	void CalculateFrustum(mat4 &view_matrix, mat4 &proj_matrix);
+	void CalculateFrustum(const mat4 &view_proj_matrix); //proj_matrix * view_matrix
 
 	vec4 frustum_planes[6];
+	int plane_octants[6]; //once per frame, aabb kernels select positive vertex without min/max products comparison
 };
 
 #endif
\ No newline at end of file
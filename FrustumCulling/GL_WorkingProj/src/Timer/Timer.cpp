@@ -1,4 +1,10 @@
-#include "timer.h"
+#include "Timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 Timer::Timer(void)
 {
@@ -8,35 +14,46 @@ Timer::~Timer(void)
 {
 }
 
-static UINT64 freq; //timer frequency
+static uint64_t freq; //timer frequency
 
 
 void InitTimeOperation()
 {
+#ifdef _WIN32
  LARGE_INTEGER s;
  QueryPerformanceFrequency(&s);
  freq=s.QuadPart;
+#else
+ freq=1000000000; //clock_gettime works in nanoseconds
+#endif
 }
 
-UINT64 Time()
+uint64_t Time()
 {
+#ifdef _WIN32
  LARGE_INTEGER s;
  QueryPerformanceCounter(&s);
  return s.QuadPart;
+#else
+ timespec s;
+ clock_gettime(CLOCK_MONOTONIC, &s);
+ return uint64_t(s.tv_sec)*1000000000 + s.tv_nsec;
+#endif
 }
   
-UINT64 GetTicksTime()
+uint64_t GetTicksTime()
 {
- LARGE_INTEGER s;
- QueryPerformanceCounter(&s);
- return ((s.QuadPart)*1000000/freq);
+ return (Time()*1000000/freq);
+}
+
+double GetTimeInSeconds()
+{
+ return double(Time()) / double(freq);
 }
 
 void Timer::StartTiming()
 {
-	LARGE_INTEGER s;
-	QueryPerformanceCounter(&s);
-	StartTime=s.QuadPart;
+	StartTime=Time();
 }
 
 //in seconds
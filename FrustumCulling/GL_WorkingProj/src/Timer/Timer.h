@@ -1,5 +1,5 @@
 #pragma once
-#include <windows.h>
+#include <stdint.h>
 
 class Timer
 {
@@ -12,9 +12,11 @@ public:
 	double TimeElapsedInMS();
 
 private:
-	UINT64 StartTime;
+	uint64_t StartTime;
 	double ElapsedTime;
 
 };
 
-void InitTimeOperation();
\ No newline at end of file
+void InitTimeOperation();
+uint64_t GetTicksTime(); //microseconds
+double GetTimeInSeconds(); //since some point in the past, InitTimeOperation() should be called before
\ No newline at end of file
@@ -0,0 +1,1317 @@
+//headless culling benchmark
+//runs culling kernels without window or gl context, so regressions in culling hot path may be caught on build servers
+//
+//example:
+//	culling_bench --modes SSE_SPHERES,SSE_AABB --counts 1000,100000,10000000 --visibility 0.1,0.9 --path orbit --csv res.csv
+//	culling_bench --modes SSE_OBB --isa sse,avx2,avx512 --validate
+//	culling_bench --modes SSE_AABB_SOA --counts 100000 --compact copy,fused
+//	culling_bench --modes SSE_SPHERES_SOA,SSE_AABB_CE --views 5 --validate
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+
+#include "../culling/Culling.h"
+#include "../culling/BoundsSoA.h"
+#include "../culling/BVH.h"
+#include "../culling/UniformGrid.h"
+#include "../culling/CoherentCulling.h"
+#include "../culling/OcclusionCulling.h"
+#include "../Camera/Frustum.h"
+#include "../Timer/Timer.h"
+#include "../jobs/JobSystem.h"
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------settings
+//same scene as in demo
+const float half_box_size = 0.05f;
+const vec3 box_max = vec3(half_box_size, half_box_size, half_box_size);
+const vec3 box_min = -vec3(half_box_size, half_box_size, half_box_size);
+const vec3 box_half_size = vec3(half_box_size, half_box_size, half_box_size);
+const float bounding_radius = sqrtf(3.f) * half_box_size;
+
+const float zNear = 0.1f;
+const float zFar = 100.f;
+const float fov = 45.f;
+const float aspect = 16.f / 9.f;
+
+//borderline objects may get different results in kernels with fma, validation ignores objects which change visibility with bounds scaled by 1 +- eps
+const float validation_bounds_eps = 1e-4f;
+
+//moving objects are shifted by random offset up to moving_step per frame, validation moves them for several frames before culling
+const float moving_step = 0.1f;
+const int validation_moving_frames = 10;
+const int validation_temporal_frames = 30; //temporal modes are compared on the last frame of camera path part
+
+//extra views of multiview modes are cascades of directional light shadow: camera frustum up to shadow_distance is split to slices,
+//each slice is covered by orthographic light frustum which is extended towards the light by shadow_distance to catch shadow casters
+const vec3 light_dir = vec3(-0.4f, -0.8f, -0.45f);
+const float shadow_distance = 50.f;
+const float cascade_split_lambda = 0.5f; //practical split scheme: mix of logarithmic & uniform splits
+
+//SSE_AABB_OCCLUSION: walls standing among objects & the nearest visible objects are occluders
+const int occlusion_width = 256;
+const int occlusion_height = 144;
+const int num_occluder_walls = 32;
+const float wall_length = 4.f;
+const float wall_height = 1.5f;
+const float wall_thickness = 0.2f;
+const int max_object_occluders = 64;
+const float min_occluder_size = 8.f; //pixels of occlusion buffer
+
+enum CAMERA_PATH
+{
+	PATH_STATIC, //camera doesn't move, visibility ratio is exact
+	PATH_ORBIT, //camera moves around area center
+	PATH_FLY, //camera flies forward along view direction
+
+	NUM_CAMERA_PATHS
+};
+const char *camera_path_names[NUM_CAMERA_PATHS] = { "static", "orbit", "fly" };
+
+//how visible instances data are collected after culling
+enum COMPACT_MODE
+{
+	COMPACT_OFF, //only culling
+	COMPACT_COPY, //cull all objects, gather visible instances to intermediate array & copy it to output buffer
+	COMPACT_FUSED, //cull & compact blocks of objects straight to output buffer
+
+	NUM_COMPACT_MODES
+};
+const char *compact_mode_names[NUM_COMPACT_MODES] = { "off", "copy", "fused" };
+const int culling_chunk_size = 1024; //objects culled & compacted at once, multiple of CULLING_OBJECTS_ALIGNMENT
+const int instance_size = 2; //vec4 per instance: pos + color, as in the demo
+
+struct BenchSettings
+{
+	std::vector<int> modes;
+	std::vector<int> simd_levels; //SSE_* modes are measured with every instruction set from the list
+	std::vector<int> counts;
+	std::vector<float> visibility;
+	std::vector<int> paths;
+	std::vector<int> compact_modes;
+	std::vector<int> threads;
+	float area_size;
+	int frames;
+	int warmup_frames;
+	double max_seconds;
+	unsigned seed;
+	int moving_objects; //per frame
+	int views; //main camera & views - 1 shadow cascades, culled in one pass by multiview modes
+	bool validate;
+	const char *csv_file;
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------random
+//own generator, scene should be the same on all platforms for the same seed
+static unsigned rnd_state = 1;
+inline float bench_rnd01()
+{
+	rnd_state = rnd_state * 1664525u + 1013904223u;
+	return float(rnd_state >> 8) / float(1 << 24);
+}
+inline float bench_rnd(float from, float to) { return from + (to - from) * bench_rnd01(); }
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------camera
+struct BenchCamera
+{
+	mat4 view_matrix, proj_matrix;
+	CullingContext views[MAX_CULLING_VIEWS]; //view projection matrices & frustum planes, views[0] - main camera, others - shadow cascades
+	int num_views;
+};
+
+//splits of camera frustum, cascade i covers [split(i), split(i + 1)]
+float cascade_split(int i, int num_cascades)
+{
+	float t = float(i) / float(num_cascades);
+	float log_split = zNear * powf(shadow_distance / zNear, t);
+	float uniform_split = zNear + (shadow_distance - zNear) * t;
+	return log_split * cascade_split_lambda + uniform_split * (1.f - cascade_split_lambda);
+}
+
+void setup_cascades(BenchCamera &cam)
+{
+	int num_cascades = cam.num_views - 1;
+	mat4 camera_to_world = cam.view_matrix.inverse();
+	float tan_y = tanf(fov * PI / 360.f);
+	float tan_x = tan_y * aspect;
+	vec3 dir = light_dir;
+	dir.normalize();
+
+	for (int c = 0; c < num_cascades; c++)
+	{
+		//slice corners & center in world space
+		vec3 corners[8];
+		vec3 center = vec3(0.f, 0.f, 0.f);
+		int i;
+		for (i = 0; i < 8; i++)
+		{
+			float d = cascade_split(c + ((i & 4) ? 1 : 0), num_cascades);
+			corners[i] = camera_to_world * vec3((i & 1) ? tan_x * d : -tan_x * d, (i & 2) ? tan_y * d : -tan_y * d, -d);
+			center += corners[i] * 0.125f;
+		}
+
+		//light space bounds of the slice
+		mat4 light_view, light_proj;
+		light_view.look_at(center - dir * shadow_distance, center, vec3(0.f, 1.f, 0.f));
+		vec3 bounds_min = light_view * corners[0];
+		vec3 bounds_max = bounds_min;
+		for (i = 1; i < 8; i++)
+		{
+			vec3 p = light_view * corners[i];
+			bounds_min = vec3(std::min(bounds_min.x, p.x), std::min(bounds_min.y, p.y), std::min(bounds_min.z, p.z));
+			bounds_max = vec3(std::max(bounds_max.x, p.x), std::max(bounds_max.y, p.y), std::max(bounds_max.z, p.z));
+		}
+
+		//light looks along -z
+		light_proj.OrthographicProjection(-bounds_max.z - shadow_distance, -bounds_min.z, bounds_min.x, bounds_max.x, bounds_max.y, bounds_min.y);
+		cam.views[c + 1].set(light_proj * light_view);
+	}
+}
+
+void setup_camera(BenchCamera &cam, CAMERA_PATH path, int frame, int num_views = 1)
+{
+	//first frame is the same for all paths - demo start position
+	vec3 pos = vec3(10.f, 10.f, 10.f);
+	vec3 view = vec3(0.f, 0.f, 0.f);
+
+	switch (path)
+	{
+	case PATH_STATIC:
+		break;
+	case PATH_ORBIT:
+	{
+		float angle = float(frame) * 0.01f;
+		float r = sqrtf(pos.x * pos.x + pos.z * pos.z);
+		pos = vec3(cosf(angle + PI * 0.25f) * r, pos.y, sinf(angle + PI * 0.25f) * r);
+		break;
+	}
+	case PATH_FLY:
+	{
+		vec3 dir = view - pos;
+		dir.y = 0.f;
+		dir.normalize();
+		pos += dir * (float(frame) * 0.05f);
+		view += dir * (float(frame) * 0.05f);
+		break;
+	}
+	default:
+		break;
+	}
+
+	cam.view_matrix.look_at(pos, view, vec3(0.f, 1.f, 0.f));
+	cam.proj_matrix.perspective(fov, aspect, zNear, zFar);
+	cam.views[0].set(cam.proj_matrix * cam.view_matrix);
+	cam.num_views = num_views;
+	setup_cascades(cam);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------scene
+inline bool sphere_visible(const vec3 &pos, float r, const vec4 *frustum_planes)
+{
+	for (int i = 0; i < 6; i++)
+		if (frustum_planes[i].x * pos.x + frustum_planes[i].y * pos.y + frustum_planes[i].z * pos.z + frustum_planes[i].w <= -r)
+			return false;
+	return true;
+}
+
+//objects are placed on the ground plane like in demo
+//visible_ratio part of them is placed inside first frame frustum, other - outside
+void generate_positions(vec3 *positions, int num_objects, float visible_ratio, float area_size, BenchCamera &cam)
+{
+	const int max_attempts = 1000;
+	for (int i = 0; i < num_objects; i++)
+	{
+		bool want_visible = bench_rnd01() < visible_ratio;
+		vec3 pos;
+		for (int attempt = 0; attempt < max_attempts; attempt++)
+		{
+			pos = vec3(bench_rnd(-1.f, 1.f) * area_size, half_box_size * 0.95f, bench_rnd(-1.f, 1.f) * area_size);
+			if (sphere_visible(pos, bounding_radius, &cam.views[0].planes[0]) == want_visible)
+				break;
+		}
+		positions[i] = pos;
+	}
+}
+
+//multiview modes cull all views of BenchCamera in one pass over bounds, other modes cull main camera only
+bool is_multiview_mode(int mode)
+{
+	return mode == SSE_SPHERES_SOA || mode == SSE_AABB_CE;
+}
+
+//scene data required by the culling mode, allocated only for the mode we measure, 10M objects with all representations do not fit in memory well
+struct BenchScene
+{
+	BenchScene() : mode(0), num_objects(0), num_views(1), bounds_scale(1.f), sphere_data(NULL), aabb_data(NULL), transforms(NULL), visibility(NULL),
+		instances(NULL), gathered_instances(NULL), out_instances(NULL)
+	{
+		for (int k = 0; k < MAX_CULLING_VIEWS; k++)
+			view_visibility[k] = NULL;
+	}
+	~BenchScene() { clear(); }
+
+	//bounds_scale - scale of objects bounding volumes, used for validation only
+	//in_num_views - views of multiview modes, other modes cull only main camera
+	void init(int in_mode, vec3 *positions, int in_num_objects, float in_bounds_scale = 1.f, int compact_mode = COMPACT_OFF, int in_num_views = 1)
+	{
+		clear();
+		mode = in_mode;
+		num_objects = in_num_objects;
+		num_views = is_multiview_mode(mode) ? in_num_views : 1;
+		bounds_scale = in_bounds_scale;
+		cur_positions.assign(positions, positions + num_objects);
+		num_plane_tests = 0;
+		int padded_objects = (num_objects + CULLING_OBJECTS_ALIGNMENT - 1) / CULLING_OBJECTS_ALIGNMENT * CULLING_OBJECTS_ALIGNMENT;
+
+		//padding objects are placed far away
+		const vec3 far_pos = vec3(1e6f, 1e6f, 1e6f);
+
+		visibility = new_sse<uint32_t>(visibility_words(padded_objects));
+		memset(&visibility[0], 0, sizeof(uint32_t) * visibility_words(padded_objects));
+		view_visibility[0] = visibility;
+		for (int k = 1; k < num_views; k++)
+		{
+			view_visibility[k] = new_sse<uint32_t>(visibility_words(padded_objects));
+			memset(&view_visibility[k][0], 0, sizeof(uint32_t) * visibility_words(padded_objects));
+		}
+
+		int i;
+		if (compact_mode != COMPACT_OFF)
+		{
+			instances = new_sse<vec4>(padded_objects * instance_size);
+			for (i = 0; i < padded_objects; i++)
+			{
+				instances[i * instance_size + 0] = vec4(i < num_objects ? positions[i] : far_pos, bounding_radius);
+				instances[i * instance_size + 1] = vec4(bench_rnd01(), bench_rnd01(), bench_rnd01(), 1.f);
+			}
+			out_instances = new_sse<vec4>(padded_objects * instance_size);
+			if (compact_mode == COMPACT_COPY)
+				gathered_instances = new_sse<vec4>(padded_objects * instance_size);
+		}
+
+		switch (mode)
+		{
+		case SIMPLE_SPHERES:
+		case SSE_SPHERES:
+			sphere_data = new_sse_array<BSphere>(padded_objects);
+			for (i = 0; i < padded_objects; i++)
+			{
+				sphere_data[i].pos = i < num_objects ? positions[i] : far_pos;
+				sphere_data[i].r = bounding_radius * bounds_scale;
+			}
+			break;
+
+		case SIMPLE_AABB:
+		case SSE_AABB:
+		case SSE_AABB_BVH:
+		case SSE_AABB_GRID:
+			aabb_data = new_sse_array<AABB>(padded_objects);
+			for (i = 0; i < padded_objects; i++)
+			{
+				vec3 pos = i < num_objects ? positions[i] : far_pos;
+				aabb_data[i].box_min = vec4(pos - box_half_size * bounds_scale, 1.f);
+				aabb_data[i].box_max = vec4(pos + box_half_size * bounds_scale, 1.f);
+			}
+			if (mode == SSE_AABB_BVH)
+				bvh.build(aabb_data, num_objects);
+			if (mode == SSE_AABB_GRID)
+				grid.build(aabb_data, num_objects);
+			break;
+
+		case SIMPLE_OBB:
+		case SSE_OBB:
+			transforms = new_sse_array<AffineTransform>(padded_objects);
+			for (i = 0; i < padded_objects; i++)
+				transforms[i].set_translation(i < num_objects ? positions[i] : far_pos);
+			break;
+
+		case SSE_SPHERES_SOA:
+		case SSE_AABB_SOA:
+		case SSE_AABB_CE:
+		case SSE_OBB_SOA:
+		case SSE_SPHERES_COHERENT:
+		case SSE_AABB_OCCLUSION:
+		{
+			bounds.init(num_objects, mode == SSE_AABB_SOA ? BOUNDS_SOA_AABB : mode == SSE_AABB_CE || mode == SSE_AABB_OCCLUSION ? BOUNDS_SOA_AABB_CENTER_EXTENT :
+				mode == SSE_OBB_SOA ? BOUNDS_SOA_OBB : BOUNDS_SOA_SPHERES);
+			AffineTransform transform;
+			BSphere sphere;
+			AABB aabb;
+			for (i = 0; i < num_objects; i++)
+			{
+				sphere.pos = positions[i];
+				sphere.r = bounding_radius * bounds_scale;
+				aabb.box_min = vec4(positions[i] - box_half_size * bounds_scale, 1.f);
+				aabb.box_max = vec4(positions[i] + box_half_size * bounds_scale, 1.f);
+				bounds.add(sphere, aabb);
+				transform.set_translation(positions[i]);
+				bounds.update_obb(i, transform);
+			}
+			if (mode == SSE_SPHERES_COHERENT)
+			{
+				coherent.init(num_objects);
+				centers_min = centers_max = num_objects ? positions[0] : vec3(0.f, 0.f, 0.f);
+				for (i = 0; i < num_objects; i++)
+					grow_centers_bounds(positions[i]);
+			}
+			if (mode == SSE_AABB_OCCLUSION)
+				init_occlusion(positions);
+			break;
+		}
+		}
+	}
+
+	//walls are placed over objects area by own generator, so other modes get the same random numbers
+	void init_occlusion(vec3 *positions)
+	{
+		occlusion.init(occlusion_width, occlusion_height);
+		occluders.resize(max_object_occluders);
+
+		vec3 area_min = num_objects ? positions[0] : vec3(0.f, 0.f, 0.f);
+		vec3 area_max = area_min;
+		for (int i = 0; i < num_objects; i++)
+		{
+			area_min = vec3(std::min(area_min.x, positions[i].x), std::min(area_min.y, positions[i].y), std::min(area_min.z, positions[i].z));
+			area_max = vec3(std::max(area_max.x, positions[i].x), std::max(area_max.y, positions[i].y), std::max(area_max.z, positions[i].z));
+		}
+
+		uint32_t state = 12345u;
+		for (int i = 0; i < num_occluder_walls; i++)
+		{
+			float t[2];
+			for (int c = 0; c < 2; c++)
+			{
+				state = state * 1664525u + 1013904223u;
+				t[c] = float(state >> 8) / float(1 << 24);
+			}
+			wall_centers.push_back(vec3(area_min.x + (area_max.x - area_min.x) * t[0], 0.5f * wall_height, area_min.z + (area_max.z - area_min.z) * t[1]));
+			wall_extents.push_back(i & 1 ? vec3(0.5f * wall_thickness, 0.5f * wall_height, 0.5f * wall_length) : vec3(0.5f * wall_length, 0.5f * wall_height, 0.5f * wall_thickness));
+		}
+	}
+
+	void grow_centers_bounds(const vec3 &pos)
+	{
+		centers_min = vec3(std::min(centers_min.x, pos.x), std::min(centers_min.y, pos.y), std::min(centers_min.z, pos.z));
+		centers_max = vec3(std::max(centers_max.x, pos.x), std::max(centers_max.y, pos.y), std::max(centers_max.z, pos.z));
+	}
+
+	void clear()
+	{
+		int padded_objects = (num_objects + CULLING_OBJECTS_ALIGNMENT - 1) / CULLING_OBJECTS_ALIGNMENT * CULLING_OBJECTS_ALIGNMENT;
+		if (sphere_data) { delete_sse_array(sphere_data, padded_objects); sphere_data = NULL; }
+		if (aabb_data) { delete_sse_array(aabb_data, padded_objects); aabb_data = NULL; }
+		if (transforms) { delete_sse_array(transforms, padded_objects); transforms = NULL; }
+		if (visibility) { delete_sse(visibility); visibility = NULL; }
+		for (int k = 1; k < num_views; k++)
+			if (view_visibility[k]) { delete_sse(view_visibility[k]); view_visibility[k] = NULL; }
+		view_visibility[0] = NULL;
+		if (instances) { delete_sse(instances); instances = NULL; }
+		if (gathered_instances) { delete_sse(gathered_instances); gathered_instances = NULL; }
+		if (out_instances) { delete_sse(out_instances); out_instances = NULL; }
+		bounds.clear();
+		bvh.clear();
+		grid.clear();
+		coherent.clear();
+		occlusion.clear();
+		occluders.clear();
+		wall_centers.clear();
+		wall_extents.clear();
+		cur_positions.clear();
+		num_objects = 0;
+		num_views = 1;
+	}
+
+	//updates all data of the mode, ids of BoundsSoA objects are equal to slots because objects are never removed
+	void move_object(int i, const vec3 &pos)
+	{
+		cur_positions[i] = pos;
+
+		BSphere sphere;
+		sphere.pos = pos;
+		sphere.r = bounding_radius * bounds_scale;
+		AABB aabb;
+		aabb.box_min = vec4(pos - box_half_size * bounds_scale, 1.f);
+		aabb.box_max = vec4(pos + box_half_size * bounds_scale, 1.f);
+		AffineTransform transform;
+		transform.set_translation(pos);
+
+		if (sphere_data)
+			sphere_data[i] = sphere;
+		if (aabb_data)
+			aabb_data[i] = aabb;
+		if (transforms)
+			transforms[i] = transform;
+		if (mode == SSE_SPHERES_SOA || mode == SSE_AABB_SOA || mode == SSE_AABB_CE || mode == SSE_OBB_SOA || mode == SSE_SPHERES_COHERENT || mode == SSE_AABB_OCCLUSION)
+		{
+			bounds.update_sphere(i, sphere);
+			bounds.update_aabb(i, aabb);
+			bounds.update_obb(i, transform);
+		}
+		if (mode == SSE_SPHERES_COHERENT)
+		{
+			coherent.invalidate(i);
+			grow_centers_bounds(pos);
+		}
+		if (mode == SSE_AABB_BVH)
+			bvh.update_object(i, aabb);
+		if (mode == SSE_AABB_GRID)
+			grid.update_object(i, aabb);
+		if (instances)
+			instances[i * instance_size + 0] = vec4(pos, bounding_radius);
+	}
+
+	int mode;
+	int num_objects;
+	int num_views;
+	float bounds_scale;
+	BSphere *sphere_data;
+	AABB *aabb_data;
+	AffineTransform *transforms;
+	BoundsSoA bounds;
+	BVH bvh;
+	UniformGrid grid;
+	CoherentCulling coherent;
+	vec3 centers_min, centers_max; //bounds of spheres centers for coherent culling
+	OcclusionCulling occlusion;
+	std::vector<int> occluders; //objects picked as occluders
+	std::vector<vec3> wall_centers, wall_extents;
+	std::atomic<long long> num_plane_tests; //coherent culling, summed by chunks
+	uint32_t *visibility;
+	uint32_t *view_visibility[MAX_CULLING_VIEWS]; //multiview modes, view_visibility[0] is visibility
+
+	//compaction, instance_size vec4 per object
+	vec4 *instances;
+	vec4 *gathered_instances; //intermediate array of COMPACT_COPY
+	vec4 *out_instances; //stands for mapped gpu buffer
+	std::vector<int> chunk_visible_objects; //multithreaded compaction, prefix sum gives output offsets of chunks
+	std::vector<vec3> cur_positions;
+};
+
+//memory which kernel reads & writes per object, result is one bit
+const double visibility_bytes = 1.0 / 8.0;
+double bytes_per_object(int mode)
+{
+	switch (mode)
+	{
+	case SIMPLE_SPHERES:
+	case SSE_SPHERES:
+		return sizeof(BSphere) + visibility_bytes;
+	case SIMPLE_AABB:
+	case SSE_AABB:
+		return sizeof(AABB) + visibility_bytes;
+	case SIMPLE_OBB:
+	case SSE_OBB:
+		return sizeof(AffineTransform) + visibility_bytes;
+	case SSE_SPHERES_SOA:
+		return sizeof(float) * 4 + visibility_bytes;
+	case SSE_SPHERES_COHERENT:
+		return sizeof(float) + visibility_bytes * 2; //lower bound, expiration is read for all objects, spheres only for tested ones
+	case SSE_AABB_SOA:
+	case SSE_AABB_CE:
+		return sizeof(float) * 6 + visibility_bytes;
+	case SSE_AABB_OCCLUSION:
+		return sizeof(float) * 6 + visibility_bytes; //lower bound, visible objects are read again by occlusion test
+	case SSE_OBB_SOA:
+		return sizeof(float) * OBB_SOA_COMPONENTS + visibility_bytes;
+	case SSE_AABB_BVH:
+	case SSE_AABB_GRID:
+		return sizeof(float) * 6 + visibility_bytes; //upper bound, objects are read only in cells & leaves near the frustum border
+	}
+	return 0;
+}
+
+//hierarchical modes (spatial structures) cull all objects at once, not by ranges
+bool is_hierarchical_mode(int mode)
+{
+	return mode == SSE_AABB_BVH || mode == SSE_AABB_GRID;
+}
+
+//occlusion culling picks occluders among all objects which are visible in frustum, so it's whole scene mode too
+bool is_whole_scene_mode(int mode)
+{
+	return is_hierarchical_mode(mode) || mode == SSE_AABB_OCCLUSION;
+}
+
+//frustum culling of all objects, then walls & the nearest visible objects are rasterized and visible objects are tested against them
+void cull_scene_occlusion(BenchScene &scene, const CullingContext &ctx)
+{
+	AABBCenterExtentSoA boxes = scene.bounds.get_aabb_center_extents(0);
+	simd_culling_aabb_center_extent(boxes, scene.num_objects, scene.visibility, ctx);
+
+	scene.occlusion.begin_frame(ctx);
+	size_t i;
+	for (i = 0; i < scene.wall_centers.size(); i++)
+		scene.occlusion.add_occluder(scene.wall_centers[i], scene.wall_extents[i]);
+	int num_occluders = scene.occlusion.select_occluders(boxes, scene.num_objects, scene.visibility, max_object_occluders, min_occluder_size, &scene.occluders[0]);
+	for (int k = 0; k < num_occluders; k++)
+	{
+		int object = scene.occluders[k];
+		scene.occlusion.add_occluder(vec3(boxes.center_x[object], boxes.center_y[object], boxes.center_z[object]),
+			vec3(boxes.extent_x[object], boxes.extent_y[object], boxes.extent_z[object]));
+	}
+	scene.occlusion.update_hiz();
+	scene.occlusion.cull(boxes, scene.num_objects, scene.visibility);
+}
+
+//culls [first, first + num) objects, first should be multiple of CULLING_OBJECTS_ALIGNMENT
+void cull_scene_range(int mode, BenchScene &scene, BenchCamera &cam, int first, int num)
+{
+	const CullingContext &ctx = cam.views[0];
+	uint32_t *visibility = &scene.visibility[first / VISIBILITY_WORD_BITS];
+	uint32_t *views_visibility[MAX_CULLING_VIEWS];
+	for (int k = 0; k < scene.num_views; k++)
+		views_visibility[k] = &scene.view_visibility[k][first / VISIBILITY_WORD_BITS];
+	switch (mode)
+	{
+	case SIMPLE_SPHERES:
+		simple_culling_spheres(&scene.sphere_data[first], num, visibility, ctx);
+		break;
+	case SIMPLE_AABB:
+		simple_culling_aabb(&scene.aabb_data[first], num, visibility, ctx);
+		break;
+	case SIMPLE_OBB:
+		simple_culling_obb(&scene.transforms[first], num, visibility, box_min * scene.bounds_scale, box_max * scene.bounds_scale, ctx);
+		break;
+
+	case SSE_SPHERES:
+		simd_culling_spheres(&scene.sphere_data[first], num, visibility, ctx);
+		break;
+	case SSE_AABB:
+		simd_culling_aabb(&scene.aabb_data[first], num, visibility, ctx);
+		break;
+	case SSE_OBB:
+		simd_culling_obb(&scene.transforms[first], num, visibility, box_min * scene.bounds_scale, box_max * scene.bounds_scale, ctx);
+		break;
+
+	case SSE_SPHERES_SOA:
+		if (scene.num_views > 1)
+			simd_culling_spheres_soa_multiview(scene.bounds.get_spheres(first), num, views_visibility, cam.views, scene.num_views);
+		else
+			simd_culling_spheres_soa(scene.bounds.get_spheres(first), num, visibility, ctx);
+		break;
+	case SSE_AABB_SOA:
+		simd_culling_aabb_soa(scene.bounds.get_aabbs(first), num, visibility, ctx);
+		break;
+	case SSE_AABB_CE:
+		if (scene.num_views > 1)
+			simd_culling_aabb_center_extent_multiview(scene.bounds.get_aabb_center_extents(first), num, views_visibility, cam.views, scene.num_views);
+		else
+			simd_culling_aabb_center_extent(scene.bounds.get_aabb_center_extents(first), num, visibility, ctx);
+		break;
+	case SSE_OBB_SOA:
+		simd_culling_obb_soa(scene.bounds.get_obbs(first), num, visibility, box_min * scene.bounds_scale, box_max * scene.bounds_scale, ctx);
+		break;
+
+	case SSE_AABB_BVH:
+		scene.bvh.cull(scene.visibility, ctx); //whole scene
+		break;
+	case SSE_AABB_GRID:
+		scene.grid.cull(scene.visibility, ctx); //whole scene
+		break;
+	case SSE_AABB_OCCLUSION:
+		cull_scene_occlusion(scene, ctx); //whole scene
+		break;
+
+	case SSE_SPHERES_COHERENT:
+		scene.num_plane_tests += scene.coherent.cull(scene.bounds.get_spheres(first), first, num, visibility, ctx);
+		break;
+	}
+}
+
+//once per frame, before culling of ranges
+void begin_scene_frame(int mode, BenchScene &scene, BenchCamera &cam)
+{
+	if (mode == SSE_SPHERES_COHERENT)
+		scene.coherent.begin_frame(cam.views[0], scene.centers_min, scene.centers_max);
+}
+
+void cull_scene(int mode, BenchScene &scene, BenchCamera &cam)
+{
+	begin_scene_frame(mode, scene, cam);
+	cull_scene_range(mode, scene, cam, 0, scene.num_objects);
+}
+
+//multithreading, chunks are distributed by job system
+JobSystem job_system;
+
+struct BenchJob
+{
+	int mode;
+	int compact_mode;
+	BenchScene *scene;
+	BenchCamera *cam;
+};
+
+void cull_chunk_job(void *data, int first, int num, int worker_index)
+{
+	BenchJob *job = (BenchJob*)data;
+	cull_scene_range(job->mode, *job->scene, *job->cam, first, num);
+	if (job->compact_mode == COMPACT_FUSED)
+		job->scene->chunk_visible_objects[first / culling_chunk_size] = count_visible_objects(&job->scene->visibility[first / VISIBILITY_WORD_BITS], num);
+}
+
+void compact_chunk_job(void *data, int first, int num, int worker_index)
+{
+	BenchScene &scene = *((BenchJob*)data)->scene;
+	int output_offset = scene.chunk_visible_objects[first / culling_chunk_size];
+	compact_visible_instances(&scene.visibility[first / VISIBILITY_WORD_BITS], num, &scene.instances[first * instance_size], instance_size,
+		&scene.out_instances[output_offset * instance_size]);
+}
+
+//two phases: workers cull chunks & count visible objects, then copy visible instances of chunks to offsets given by prefix sum
+int cull_and_compact_scene_mt(int mode, int compact_mode, BenchScene &scene, BenchCamera &cam)
+{
+	BenchJob job = { mode, compact_mode, &scene, &cam };
+	scene.chunk_visible_objects.resize((scene.num_objects + culling_chunk_size - 1) / culling_chunk_size);
+	job_system.parallel_for(scene.num_objects, culling_chunk_size, cull_chunk_job, &job);
+
+	int num_visible = 0;
+	if (compact_mode == COMPACT_COPY)
+	{
+		num_visible = compact_visible_instances(scene.visibility, scene.num_objects, scene.instances, instance_size, scene.gathered_instances);
+		memcpy((void*)&scene.out_instances[0], &scene.gathered_instances[0], sizeof(vec4) * num_visible * instance_size);
+	}
+	else if (compact_mode == COMPACT_FUSED)
+	{
+		for (size_t i = 0; i < scene.chunk_visible_objects.size(); i++)
+		{
+			int chunk_visible = scene.chunk_visible_objects[i];
+			scene.chunk_visible_objects[i] = num_visible;
+			num_visible += chunk_visible;
+		}
+		job_system.parallel_for(scene.num_objects, culling_chunk_size, compact_chunk_job, &job);
+	}
+	return num_visible;
+}
+
+//culling with collecting of visible instances to scene.out_instances, returns number of visible instances
+int cull_and_compact_scene(int mode, int compact_mode, BenchScene &scene, BenchCamera &cam)
+{
+	begin_scene_frame(mode, scene, cam);
+
+	//hierarchy & occlusion are culled at once, then visible objects are written straight to the output
+	if (is_whole_scene_mode(mode))
+	{
+		cull_scene_range(mode, scene, cam, 0, scene.num_objects);
+		if (compact_mode == COMPACT_OFF)
+			return 0;
+		vec4 *out = compact_mode == COMPACT_COPY ? scene.gathered_instances : scene.out_instances;
+		int num_visible = compact_visible_instances(scene.visibility, scene.num_objects, scene.instances, instance_size, out);
+		if (compact_mode == COMPACT_COPY)
+			memcpy((void*)&scene.out_instances[0], &scene.gathered_instances[0], sizeof(vec4) * num_visible * instance_size);
+		return num_visible;
+	}
+
+	if (job_system.get_num_workers() > 1)
+		return cull_and_compact_scene_mt(mode, compact_mode, scene, cam);
+
+	int num_visible = 0;
+	if (compact_mode == COMPACT_COPY)
+	{
+		cull_scene_range(mode, scene, cam, 0, scene.num_objects);
+		num_visible = compact_visible_instances(scene.visibility, scene.num_objects, scene.instances, instance_size, scene.gathered_instances);
+		memcpy((void*)&scene.out_instances[0], &scene.gathered_instances[0], sizeof(vec4) * num_visible * instance_size);
+	}
+	else if (compact_mode == COMPACT_FUSED)
+	{
+		for (int first = 0; first < scene.num_objects; first += culling_chunk_size)
+		{
+			int num = std::min(culling_chunk_size, scene.num_objects - first);
+			cull_scene_range(mode, scene, cam, first, num);
+			num_visible += compact_visible_instances(&scene.visibility[first / VISIBILITY_WORD_BITS], num, &scene.instances[first * instance_size], instance_size,
+				&scene.out_instances[num_visible * instance_size]);
+		}
+	} else
+		cull_scene_range(mode, scene, cam, 0, scene.num_objects);
+	return num_visible;
+}
+
+//moved objects & offsets depend on frame only, so all modes see the same scene. Hierarchy is refitted after moves
+void move_objects(BenchScene &scene, int num_moving, int frame)
+{
+	if (num_moving <= 0)
+		return;
+
+	uint32_t state = uint32_t(frame) * 2654435761u + 1u;
+	for (int k = 0; k < num_moving; k++)
+	{
+		state = state * 1664525u + 1013904223u;
+		int i = int((state >> 8) % uint32_t(scene.num_objects));
+		vec3 offset;
+		for (int c = 0; c < 3; c++)
+		{
+			state = state * 1664525u + 1013904223u;
+			offset[c] = (float((state >> 8) & 0xffff) / 65535.f * 2.f - 1.f) * moving_step;
+		}
+		scene.move_object(i, scene.cur_positions[i] + offset);
+	}
+
+	if (scene.mode == SSE_AABB_BVH)
+		scene.bvh.refit(job_system.get_num_workers() > 1 ? &job_system : NULL);
+}
+
+int count_visible(BenchScene &scene)
+{
+	return count_visible_objects(scene.visibility, scene.num_objects);
+}
+
+//simple c++ kernel of the same bounding volume type, used as reference
+int reference_mode(int mode)
+{
+	switch (mode)
+	{
+	case SSE_SPHERES: return SIMPLE_SPHERES;
+	case SSE_AABB: return SIMPLE_AABB;
+	case SSE_SPHERES_SOA: return SIMPLE_SPHERES;
+	case SSE_AABB_SOA: return SIMPLE_AABB;
+	case SSE_AABB_CE: return SIMPLE_AABB;
+	case SSE_OBB_SOA: return SIMPLE_OBB;
+	case SSE_OBB: return SIMPLE_OBB;
+	case SSE_AABB_BVH: return SIMPLE_AABB;
+	case SSE_AABB_GRID: return SIMPLE_AABB;
+	case SSE_SPHERES_COHERENT: return SIMPLE_SPHERES;
+	case SSE_AABB_OCCLUSION: return SIMPLE_AABB;
+	}
+	return mode;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------measurements
+struct BenchResult
+{
+	double ns_per_object;
+	double objects_per_sec;
+	double avg_ms;
+	double p50_ms;
+	double p99_ms;
+	double mb_per_frame;
+	double gb_per_sec;
+	float visible_ratio;
+	int num_frames;
+	double plane_tests_per_object; //coherent culling, -1 for other modes
+	int mismatches; //-1 if not validated
+};
+
+double percentile(std::vector<double> &sorted_values, double p)
+{
+	if (sorted_values.empty())
+		return 0.0;
+	size_t index = size_t(ceil(p * double(sorted_values.size()))) ;
+	index = index > 0 ? index - 1 : 0;
+	return sorted_values[std::min(index, sorted_values.size() - 1)];
+}
+
+BenchResult run_benchmark(int mode, int compact_mode, BenchScene &scene, CAMERA_PATH path, BenchSettings &settings)
+{
+	BenchResult res;
+	BenchCamera cam;
+	Timer timer, total_timer;
+	std::vector<double> frame_times;
+	frame_times.reserve(settings.frames);
+
+	int frame;
+	for (frame = 0; frame < settings.warmup_frames; frame++)
+	{
+		setup_camera(cam, path, 0, scene.num_views);
+		cull_and_compact_scene(mode, compact_mode, scene, cam);
+	}
+
+	scene.num_plane_tests = 0;
+	total_timer.StartTiming();
+	for (frame = 0; frame < settings.frames; frame++)
+	{
+		setup_camera(cam, path, frame, scene.num_views);
+
+		timer.StartTiming();
+		move_objects(scene, settings.moving_objects, frame);
+		cull_and_compact_scene(mode, compact_mode, scene, cam);
+		frame_times.push_back(timer.TimeElapsedInMS());
+
+		//slow modes with large object counts should not take forever, but we need several frames for percentiles
+		if (frame >= 4 && total_timer.TimeElapsedInMS() > settings.max_seconds * 1000.0)
+		{
+			frame++;
+			break;
+		}
+	}
+	res.num_frames = frame;
+	res.visible_ratio = float(count_visible(scene)) / float(scene.num_objects);
+
+	double total_ms = 0.0;
+	for (size_t i = 0; i < frame_times.size(); i++)
+		total_ms += frame_times[i];
+	std::sort(frame_times.begin(), frame_times.end());
+
+	res.avg_ms = total_ms / double(frame_times.size());
+	res.p50_ms = percentile(frame_times, 0.5);
+	res.p99_ms = percentile(frame_times, 0.99);
+	res.ns_per_object = res.avg_ms * 1e6 / double(scene.num_objects);
+	res.objects_per_sec = double(scene.num_objects) / (res.avg_ms * 1e-3);
+	res.mb_per_frame = (double(bytes_per_object(mode)) + visibility_bytes * double(scene.num_views - 1)) * double(scene.num_objects) / (1024.0 * 1024.0);
+	if (compact_mode != COMPACT_OFF)
+	{
+		//visible instances are read & written once, copy mode reads & writes them twice
+		double instances_mb = double(sizeof(vec4) * instance_size) * double(count_visible(scene)) / (1024.0 * 1024.0);
+		res.mb_per_frame += instances_mb * (compact_mode == COMPACT_COPY ? 4.0 : 2.0);
+	}
+	res.gb_per_sec = res.mb_per_frame / 1024.0 / (res.avg_ms * 1e-3);
+	res.plane_tests_per_object = mode == SSE_SPHERES_COHERENT ? double(scene.num_plane_tests) / (double(scene.num_objects) * double(res.num_frames)) : -1.0;
+	res.mismatches = -1;
+	return res;
+}
+
+//compacted instances should be instances of visible objects in objects order
+int validate_compaction(int mode, int compact_mode, vec3 *positions, int num_objects, BenchCamera &cam)
+{
+	BenchScene scene;
+	scene.init(mode, positions, num_objects, 1.f, compact_mode);
+	int num_visible = cull_and_compact_scene(mode, compact_mode, scene, cam);
+
+	std::vector<int> visible_objects(num_objects);
+	int num_expected = get_visible_objects(scene.visibility, num_objects, &visible_objects[0]);
+	if (num_visible != num_expected)
+		return abs(num_visible - num_expected);
+
+	int mismatches = 0;
+	for (int i = 0; i < num_visible; i++)
+		mismatches += memcmp(&scene.out_instances[i * instance_size], &scene.instances[visible_objects[i] * instance_size], sizeof(vec4) * instance_size) != 0;
+	return mismatches;
+}
+
+//temporal modes reuse results of previous frames
+bool is_temporal_mode(int mode)
+{
+	return mode == SSE_SPHERES_COHERENT;
+}
+
+//occlusion culling may only remove objects which are visible in frustum
+bool visibility_differs(int mode, bool ref_visible, bool visible)
+{
+	return mode == SSE_AABB_OCCLUSION ? visible && !ref_visible : visible != ref_visible;
+}
+
+//extra views of multiview modes should be the same as single view kernel gives for each view
+int validate_views(int mode, BenchScene &scene, BenchCamera &cam)
+{
+	int mismatches = 0;
+	std::vector<uint32_t> visibility(visibility_words(scene.num_objects + CULLING_OBJECTS_ALIGNMENT));
+	for (int k = 1; k < scene.num_views; k++)
+	{
+		if (mode == SSE_SPHERES_SOA)
+			simd_culling_spheres_soa(scene.bounds.get_spheres(0), scene.num_objects, &visibility[0], cam.views[k]);
+		else
+			simd_culling_aabb_center_extent(scene.bounds.get_aabb_center_extents(0), scene.num_objects, &visibility[0], cam.views[k]);
+		for (int i = 0; i < scene.num_objects; i++)
+			mismatches += is_visible(&visibility[0], i) != is_visible(scene.view_visibility[k], i);
+	}
+	return mismatches;
+}
+
+//compare sse kernel results with simple c++ kernel on the first frame, after objects moves if they move.
+//temporal modes cull several frames of camera path & are compared on the last one
+int validate(int mode, int compact_mode, vec3 *positions, int num_objects, CAMERA_PATH path, int num_moving, int num_views)
+{
+	int last_frame = is_temporal_mode(mode) ? validation_temporal_frames - 1 : 0;
+	BenchCamera cam;
+	setup_camera(cam, path, last_frame, num_views);
+
+	int compaction_mismatches = compact_mode != COMPACT_OFF ? validate_compaction(mode, compact_mode, positions, num_objects, cam) : 0;
+	if (reference_mode(mode) == mode)
+		return compaction_mismatches;
+
+	int frame;
+	BenchScene ref_scene;
+	ref_scene.init(reference_mode(mode), positions, num_objects);
+	for (frame = 0; num_moving > 0 && frame < validation_moving_frames; frame++)
+		move_objects(ref_scene, num_moving, frame);
+	cull_scene(reference_mode(mode), ref_scene, cam);
+
+	BenchScene scene;
+	scene.init(mode, positions, num_objects, 1.f, COMPACT_OFF, num_views);
+	for (frame = 0; frame < std::max(num_moving > 0 ? validation_moving_frames : 0, last_frame); frame++)
+	{
+		if (num_moving > 0 && frame < validation_moving_frames)
+			move_objects(scene, num_moving, frame);
+		if (frame < last_frame)
+		{
+			BenchCamera frame_cam;
+			setup_camera(frame_cam, path, frame, num_views);
+			cull_and_compact_scene(mode, COMPACT_OFF, scene, frame_cam);
+		}
+	}
+	cull_and_compact_scene(mode, COMPACT_OFF, scene, cam);
+	compaction_mismatches += validate_views(mode, scene, cam);
+
+	int i;
+	for (i = 0; i < num_objects; i++)
+		if (visibility_differs(mode, is_visible(ref_scene.visibility, i), is_visible(scene.visibility, i)))
+			break;
+	if (i == num_objects)
+		return compaction_mismatches;
+
+	//there are differences, check if they are on the frustum border
+	BenchScene smaller_scene, bigger_scene;
+	smaller_scene.init(reference_mode(mode), positions, num_objects, 1.f - validation_bounds_eps);
+	bigger_scene.init(reference_mode(mode), positions, num_objects, 1.f + validation_bounds_eps);
+	for (frame = 0; num_moving > 0 && frame < validation_moving_frames; frame++)
+	{
+		move_objects(smaller_scene, num_moving, frame);
+		move_objects(bigger_scene, num_moving, frame);
+	}
+	cull_scene(reference_mode(mode), smaller_scene, cam);
+	cull_scene(reference_mode(mode), bigger_scene, cam);
+
+	int mismatches = 0;
+	for (; i < num_objects; i++)
+	{
+		bool borderline = is_visible(smaller_scene.visibility, i) != is_visible(bigger_scene.visibility, i);
+		mismatches += !borderline && visibility_differs(mode, is_visible(ref_scene.visibility, i), is_visible(scene.visibility, i));
+	}
+	return mismatches + compaction_mismatches;
+}
+
+//sse modes use instruction set selected by set_simd_level, simple c++ modes don't depend on it, bvh, grid & coherent culling tests are always sse.
+//occlusion mode uses simd frustum culling kernel, occlusion tests are always sse
+bool is_simd_mode(int mode)
+{
+	return reference_mode(mode) != mode && !is_hierarchical_mode(mode) && !is_temporal_mode(mode);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------settings parsing
+template <typename T, typename F>
+void parse_list(const char *str, std::vector<T> &out, F convert)
+{
+	out.clear();
+	char buf[1024];
+	strncpy(buf, str, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+	for (char *token = strtok(buf, ","); token; token = strtok(NULL, ","))
+		convert(token, out);
+}
+
+void print_usage()
+{
+	printf("usage: culling_bench [options]\n");
+	printf("  --modes <all|list>      culling modes, e.g. SSE_SPHERES,SSE_AABB (default all)\n");
+	printf("  --isa <all|list>        instruction sets for SSE_* modes: sse, avx2, avx512 (default all supported by cpu)\n");
+	printf("  --counts <list>         objects counts (default 1000,10000,100000,1000000)\n");
+	printf("  --visibility <list>     part of objects visible on first frame (default 0.1,0.5,0.9)\n");
+	printf("  --path <all|list>       camera paths: static, orbit, fly (default static)\n");
+	printf("  --area <size>           half size of the area (default 20)\n");
+	printf("  --frames <n>            measured frames per run (default 100)\n");
+	printf("  --warmup <n>            not measured frames before run (default 5)\n");
+	printf("  --max-seconds <s>       time limit per run, at least 5 frames are measured (default 2)\n");
+	printf("  --seed <n>              random seed (default 1)\n");
+	printf("  --compact <all|list>    collecting of visible instances after culling: off, copy, fused (default off)\n");
+	printf("  --threads <list>        worker threads, 0 - all hardware threads (default 1)\n");
+	printf("  --moving <n>            objects moved per frame, bvh is refitted, grid cells grow (default 0)\n");
+	printf("  --views <n>             views culled in one pass by SSE_SPHERES_SOA & SSE_AABB_CE: camera & n - 1 shadow cascades, up to %d (default 1)\n", MAX_CULLING_VIEWS);
+	printf("  --validate              compare sse kernels results with simple c++ kernels\n");
+	printf("  --csv <file>            write results to csv file\n");
+}
+
+bool parse_settings(int argc, char **argv, BenchSettings &settings)
+{
+	int i;
+	for (i = 0; i < NUM_CULLING_MODES; i++)
+		settings.modes.push_back(i);
+	for (i = 0; i < NUM_SIMD_LEVELS; i++)
+		if (simd_level_supported(SIMD_LEVEL(i)))
+			settings.simd_levels.push_back(i);
+	settings.counts.push_back(1000);
+	settings.counts.push_back(10000);
+	settings.counts.push_back(100000);
+	settings.counts.push_back(1000000);
+	settings.visibility.push_back(0.1f);
+	settings.visibility.push_back(0.5f);
+	settings.visibility.push_back(0.9f);
+	settings.paths.push_back(PATH_STATIC);
+	settings.compact_modes.push_back(COMPACT_OFF);
+	settings.threads.push_back(1);
+	settings.area_size = 20.f;
+	settings.frames = 100;
+	settings.warmup_frames = 5;
+	settings.max_seconds = 2.0;
+	settings.seed = 1;
+	settings.moving_objects = 0;
+	settings.views = 1;
+	settings.validate = false;
+	settings.csv_file = NULL;
+
+	for (i = 1; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		bool has_value = true;
+
+		if (!strcmp(arg, "--validate"))
+		{
+			settings.validate = true;
+			has_value = false;
+		}
+		else if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+		{
+			print_usage();
+			exit(0);
+		}
+		else if (!value)
+		{
+			fprintf(stderr, "missing value for %s\n", arg);
+			return false;
+		}
+		else if (!strcmp(arg, "--modes"))
+		{
+			if (strcmp(value, "all"))
+			{
+				bool ok = true;
+				parse_list(value, settings.modes, [&ok](const char *token, std::vector<int> &out)
+				{
+					for (int m = 0; m < NUM_CULLING_MODES; m++)
+						if (!strcmp(token, culling_mode_names[m]))
+						{
+							out.push_back(m);
+							return;
+						}
+					fprintf(stderr, "unknown culling mode %s\n", token);
+					ok = false;
+				});
+				if (!ok)
+					return false;
+			}
+		}
+		else if (!strcmp(arg, "--isa"))
+		{
+			if (strcmp(value, "all"))
+			{
+				bool ok = true;
+				parse_list(value, settings.simd_levels, [&ok](const char *token, std::vector<int> &out)
+				{
+					for (int l = 0; l < NUM_SIMD_LEVELS; l++)
+						if (!strcmp(token, simd_level_names[l]))
+						{
+							if (simd_level_supported(SIMD_LEVEL(l)))
+								out.push_back(l);
+							else
+							{
+								fprintf(stderr, "instruction set %s is not supported by cpu\n", token);
+								ok = false;
+							}
+							return;
+						}
+					fprintf(stderr, "unknown instruction set %s\n", token);
+					ok = false;
+				});
+				if (!ok)
+					return false;
+			}
+		}
+		else if (!strcmp(arg, "--path"))
+		{
+			settings.paths.clear();
+			if (!strcmp(value, "all"))
+			{
+				for (int p = 0; p < NUM_CAMERA_PATHS; p++)
+					settings.paths.push_back(p);
+			} else
+			{
+				bool ok = true;
+				parse_list(value, settings.paths, [&ok](const char *token, std::vector<int> &out)
+				{
+					for (int p = 0; p < NUM_CAMERA_PATHS; p++)
+						if (!strcmp(token, camera_path_names[p]))
+						{
+							out.push_back(p);
+							return;
+						}
+					fprintf(stderr, "unknown camera path %s\n", token);
+					ok = false;
+				});
+				if (!ok)
+					return false;
+			}
+		}
+		else if (!strcmp(arg, "--compact"))
+		{
+			settings.compact_modes.clear();
+			if (!strcmp(value, "all"))
+			{
+				for (int c = 0; c < NUM_COMPACT_MODES; c++)
+					settings.compact_modes.push_back(c);
+			} else
+			{
+				bool ok = true;
+				parse_list(value, settings.compact_modes, [&ok](const char *token, std::vector<int> &out)
+				{
+					for (int c = 0; c < NUM_COMPACT_MODES; c++)
+						if (!strcmp(token, compact_mode_names[c]))
+						{
+							out.push_back(c);
+							return;
+						}
+					fprintf(stderr, "unknown compact mode %s\n", token);
+					ok = false;
+				});
+				if (!ok)
+					return false;
+			}
+		}
+		else if (!strcmp(arg, "--threads"))
+			parse_list(value, settings.threads, [](const char *token, std::vector<int> &out) { out.push_back(atoi(token)); });
+		else if (!strcmp(arg, "--moving"))
+			settings.moving_objects = atoi(value);
+		else if (!strcmp(arg, "--views"))
+			settings.views = atoi(value);
+		else if (!strcmp(arg, "--counts"))
+			parse_list(value, settings.counts, [](const char *token, std::vector<int> &out) { out.push_back(atoi(token)); });
+		else if (!strcmp(arg, "--visibility"))
+			parse_list(value, settings.visibility, [](const char *token, std::vector<float> &out) { out.push_back(float(atof(token))); });
+		else if (!strcmp(arg, "--area"))
+			settings.area_size = float(atof(value));
+		else if (!strcmp(arg, "--frames"))
+			settings.frames = atoi(value);
+		else if (!strcmp(arg, "--warmup"))
+			settings.warmup_frames = atoi(value);
+		else if (!strcmp(arg, "--max-seconds"))
+			settings.max_seconds = atof(value);
+		else if (!strcmp(arg, "--seed"))
+			settings.seed = unsigned(atoi(value));
+		else if (!strcmp(arg, "--csv"))
+			settings.csv_file = value;
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", arg);
+			return false;
+		}
+
+		if (has_value)
+			i++;
+	}
+
+	for (i = 0; i < int(settings.counts.size()); i++)
+		if (settings.counts[i] <= 0)
+		{
+			fprintf(stderr, "objects count should be positive\n");
+			return false;
+		}
+	if (settings.views < 1 || settings.views > MAX_CULLING_VIEWS)
+	{
+		fprintf(stderr, "views count should be in [1, %d]\n", MAX_CULLING_VIEWS);
+		return false;
+	}
+	if (settings.frames <= 0)
+		settings.frames = 1;
+	return true;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------main
+int main(int argc, char **argv)
+{
+	BenchSettings settings;
+	if (!parse_settings(argc, argv, settings))
+	{
+		print_usage();
+		return 2;
+	}
+
+	InitTimeOperation();
+
+	FILE *csv = NULL;
+	if (settings.csv_file)
+	{
+		csv = fopen(settings.csv_file, "w");
+		if (!csv)
+		{
+			fprintf(stderr, "can`t open \"%s\" file\n", settings.csv_file);
+			return 2;
+		}
+		fprintf(csv, "mode,isa,compact,threads,moving,views,objects,path,visibility,visible,frames,ns_per_object,objects_per_sec,avg_ms,p50_ms,p99_ms,mb_per_frame,gb_per_sec,plane_tests_per_object,mismatches\n");
+	}
+
+	if (settings.moving_objects > 0)
+		printf("%d objects move every frame\n", settings.moving_objects);
+	if (settings.views > 1)
+		printf("%d views (camera & %d shadow cascades) are culled in one pass by multiview modes\n", settings.views, settings.views - 1);
+	printf("%-20s %-6s %-7s %3s %10s %-7s %5s %6s %8s %10s %9s %9s %9s %9s %8s %7s\n",
+		"mode", "isa", "compact", "thr", "objects", "path", "vis", "vis%", "ns/obj", "Mobj/s", "avg ms", "p50 ms", "p99 ms", "MB/frame", "GB/s", "tests");
+
+	int total_mismatches = 0;
+	size_t c, v, p, m, l, k, t;
+	for (c = 0; c < settings.counts.size(); c++)
+	for (v = 0; v < settings.visibility.size(); v++)
+	for (p = 0; p < settings.paths.size(); p++)
+	{
+		int num_objects = settings.counts[c];
+		CAMERA_PATH path = CAMERA_PATH(settings.paths[p]);
+
+		//all modes see the same objects
+		BenchCamera cam;
+		setup_camera(cam, path, 0);
+		rnd_state = settings.seed;
+		std::vector<vec3> positions(num_objects);
+		generate_positions(&positions[0], num_objects, settings.visibility[v], settings.area_size, cam);
+
+		for (m = 0; m < settings.modes.size(); m++)
+		for (l = 0; l < settings.simd_levels.size(); l++)
+		for (k = 0; k < settings.compact_modes.size(); k++)
+		for (t = 0; t < settings.threads.size(); t++)
+		{
+			int mode = settings.modes[m];
+
+			//simple modes are measured once
+			if (!is_simd_mode(mode) && l > 0)
+				break;
+			int compact_mode = settings.compact_modes[k];
+			job_system.init(settings.threads[t]);
+			set_simd_level(SIMD_LEVEL(settings.simd_levels[l]));
+			const char *isa_name = is_simd_mode(mode) ? simd_level_names[get_simd_level()] : "-";
+
+			BenchScene scene;
+			scene.init(mode, &positions[0], num_objects, 1.f, compact_mode, settings.views);
+			BenchResult res = run_benchmark(mode, compact_mode, scene, path, settings);
+			scene.clear();
+
+			if (settings.validate)
+			{
+				res.mismatches = validate(mode, compact_mode, &positions[0], num_objects, path, settings.moving_objects, settings.views);
+				total_mismatches += res.mismatches;
+			}
+
+			printf("%-20s %-6s %-7s %3d %10d %-7s %5.2f %6.2f %8.3f %10.2f %9.4f %9.4f %9.4f %9.2f %8.2f",
+				culling_mode_names[mode], isa_name, compact_mode_names[compact_mode], job_system.get_num_workers(), num_objects, camera_path_names[path], settings.visibility[v], res.visible_ratio * 100.f,
+				res.ns_per_object, res.objects_per_sec * 1e-6, res.avg_ms, res.p50_ms, res.p99_ms, res.mb_per_frame, res.gb_per_sec);
+			if (res.plane_tests_per_object >= 0.0)
+				printf(" %7.3f", res.plane_tests_per_object);
+			else
+				printf(" %7s", "-");
+			if (res.mismatches > 0)
+				printf("  MISMATCHES: %d", res.mismatches);
+			printf("\n");
+			fflush(stdout);
+
+			if (csv)
+				fprintf(csv, "%s,%s,%s,%d,%d,%d,%d,%s,%.3f,%.5f,%d,%.4f,%.1f,%.5f,%.5f,%.5f,%.3f,%.3f,%.4f,%d\n",
+					culling_mode_names[mode], isa_name, compact_mode_names[compact_mode], job_system.get_num_workers(), settings.moving_objects, is_multiview_mode(mode) ? settings.views : 1, num_objects, camera_path_names[path], settings.visibility[v], res.visible_ratio, res.num_frames,
+					res.ns_per_object, res.objects_per_sec, res.avg_ms, res.p50_ms, res.p99_ms, res.mb_per_frame, res.gb_per_sec, res.plane_tests_per_object, res.mismatches);
+		}
+	}
+
+	job_system.shutdown();
+	if (csv)
+		fclose(csv);
+
+	if (settings.validate && total_mismatches > 0)
+	{
+		fprintf(stderr, "validation failed: %d objects have different visibility\n", total_mismatches);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,446 @@
+#include "BVH.h"
+#include "../jobs/JobSystem.h"
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
+//depth of tree with median splits is log4(objects), 64 entries are enough for any int objects count
+const int BVH_STACK_SIZE = 64;
+
+//nodes of one level refitted by a job
+const int BVH_REFIT_CHUNK_SIZE = 64;
+
+
+BVH::BVH() : num_objects(0), num_nodes(0), nodes_capacity(0), nodes(NULL), num_dirty_nodes(0), cost(0.0), build_cost(0.0),
+	rebuild_threshold(BVH_DEFAULT_REBUILD_THRESHOLD)
+{
+	for (int i = 0; i < 6; i++)
+		leaf_arrays[i] = NULL;
+}
+
+BVH::~BVH()
+{
+	clear();
+}
+
+void BVH::clear()
+{
+	if (nodes)
+	{
+		delete_sse_array(nodes, nodes_capacity);
+		nodes = NULL;
+	}
+	for (int i = 0; i < 6; i++)
+		if (leaf_arrays[i])
+		{
+			delete_sse(leaf_arrays[i]);
+			leaf_arrays[i] = NULL;
+		}
+
+	num_objects = 0;
+	num_nodes = 0;
+	nodes_capacity = 0;
+	object_indices.clear();
+	object_positions.clear();
+	leaf_refs.clear();
+
+	node_parents.clear();
+	node_depths.clear();
+	node_dirty.clear();
+	node_costs.clear();
+	node_cost_deltas.clear();
+	dirty_levels.clear();
+	num_dirty_nodes = 0;
+	cost = 0.0;
+	build_cost = 0.0;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------build
+void BVH::build(const AABB *aabbs, int in_num_objects)
+{
+	clear();
+	if (!aabbs || in_num_objects <= 0)
+		return;
+
+	num_objects = in_num_objects;
+	object_indices.resize(num_objects);
+	leaf_refs.resize(num_objects);
+	int i;
+	for (i = 0; i < num_objects; i++)
+		object_indices[i] = i;
+
+	build_node(aabbs, 0, num_objects, -1, 0);
+
+	object_positions.resize(num_objects);
+	for (i = 0; i < num_objects; i++)
+		object_positions[object_indices[i]] = i;
+
+	//refit data
+	int max_depth = 0;
+	node_dirty.assign(num_nodes, 0);
+	node_costs.assign(num_nodes, 0.0);
+	node_cost_deltas.assign(num_nodes, 0.0);
+	for (i = 0; i < num_nodes; i++)
+	{
+		for (int j = 0; j < BVH_WIDTH; j++)
+			node_costs[i] += calc_slot_cost(nodes[i], j);
+		cost += node_costs[i];
+		max_depth = std::max(max_depth, node_depths[i]);
+	}
+	dirty_levels.resize(max_depth + 1);
+	double root_area = calc_root_area();
+	build_cost = root_area > 0.0 ? cost / root_area : 0.0;
+
+	//leaves load 4 objects at once, padding objects are never counted as visible
+	int padded_objects = num_objects + 4;
+	for (i = 0; i < 6; i++)
+	{
+		leaf_arrays[i] = new_sse<float>(padded_objects);
+		memset(&leaf_arrays[i][0], 0, sizeof(float) * padded_objects);
+	}
+	for (i = 0; i < num_objects; i++)
+	{
+		const AABB &box = aabbs[object_indices[i]];
+		leaf_arrays[0][i] = box.box_min.x;
+		leaf_arrays[1][i] = box.box_min.y;
+		leaf_arrays[2][i] = box.box_min.z;
+		leaf_arrays[3][i] = box.box_max.x;
+		leaf_arrays[4][i] = box.box_max.y;
+		leaf_arrays[5][i] = box.box_max.z;
+	}
+}
+
+int BVH::add_node(int parent_ref, int depth)
+{
+	if (num_nodes == nodes_capacity)
+	{
+		int new_capacity = nodes_capacity ? nodes_capacity * 2 : 64;
+		BVHNode *new_nodes = new_sse_array<BVHNode>(new_capacity);
+		if (nodes)
+		{
+			memcpy(new_nodes, nodes, sizeof(BVHNode) * num_nodes);
+			delete_sse_array(nodes, nodes_capacity);
+		}
+		nodes = new_nodes;
+		nodes_capacity = new_capacity;
+	}
+	node_parents.push_back(parent_ref);
+	node_depths.push_back(depth);
+	return num_nodes++;
+}
+
+int BVH::build_node(const AABB *aabbs, int first, int count, int parent_ref, int depth)
+{
+	//nodes array may be reallocated by children, so node is accessed by index
+	int node_index = add_node(parent_ref, depth);
+
+	//split the largest child until node has 4 children or all of them fit in leaves
+	BuildRange children[BVH_WIDTH];
+	int num_children = 1;
+	children[0].first = first;
+	children[0].count = count;
+	calc_range_bounds(aabbs, children[0]);
+	while (num_children < BVH_WIDTH)
+	{
+		int largest = 0;
+		for (int i = 1; i < num_children; i++)
+			if (children[i].count > children[largest].count)
+				largest = i;
+		if (children[largest].count <= BVH_MAX_LEAF_OBJECTS)
+			break;
+
+		BuildRange range = children[largest];
+		split_range(aabbs, range, children[largest], children[num_children]);
+		num_children++;
+	}
+
+	int child_nodes[BVH_WIDTH];
+	int i;
+	for (i = 0; i < num_children; i++)
+	{
+		int child_ref = node_index * BVH_WIDTH + i;
+		if (children[i].count > BVH_MAX_LEAF_OBJECTS)
+			child_nodes[i] = build_node(aabbs, children[i].first, children[i].count, child_ref, depth + 1);
+		else
+		{
+			child_nodes[i] = -1;
+			for (int j = 0; j < children[i].count; j++)
+				leaf_refs[children[i].first + j] = child_ref;
+		}
+	}
+
+	BVHNode &node = nodes[node_index];
+	for (i = 0; i < BVH_WIDTH; i++)
+	{
+		bool used = i < num_children;
+		node.min_x[i] = used ? children[i].box_min.x : 0.f;
+		node.min_y[i] = used ? children[i].box_min.y : 0.f;
+		node.min_z[i] = used ? children[i].box_min.z : 0.f;
+		node.max_x[i] = used ? children[i].box_max.x : 0.f;
+		node.max_y[i] = used ? children[i].box_max.y : 0.f;
+		node.max_z[i] = used ? children[i].box_max.z : 0.f;
+		node.child[i] = used ? child_nodes[i] : -1;
+		node.first_object[i] = used ? children[i].first : 0;
+		node.num_objects[i] = used ? children[i].count : 0;
+	}
+	return node_index;
+}
+
+//median split by the longest axis of range bounds
+void BVH::split_range(const AABB *aabbs, BuildRange &range, BuildRange &left, BuildRange &right)
+{
+	vec3 size = range.box_max - range.box_min;
+	int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+
+	int *indices = &object_indices[range.first];
+	int half = range.count / 2;
+	std::nth_element(indices, indices + half, indices + range.count, [aabbs, axis](int a, int b)
+	{
+		return aabbs[a].box_min[axis] + aabbs[a].box_max[axis] < aabbs[b].box_min[axis] + aabbs[b].box_max[axis];
+	});
+
+	left.first = range.first;
+	left.count = half;
+	right.first = range.first + half;
+	right.count = range.count - half;
+	calc_range_bounds(aabbs, left);
+	calc_range_bounds(aabbs, right);
+}
+
+void BVH::calc_range_bounds(const AABB *aabbs, BuildRange &range)
+{
+	const AABB &first_box = aabbs[object_indices[range.first]];
+	range.box_min = vec3(first_box.box_min.x, first_box.box_min.y, first_box.box_min.z);
+	range.box_max = vec3(first_box.box_max.x, first_box.box_max.y, first_box.box_max.z);
+	for (int i = 1; i < range.count; i++)
+	{
+		const AABB &box = aabbs[object_indices[range.first + i]];
+		range.box_min.x = std::min(range.box_min.x, box.box_min.x);
+		range.box_min.y = std::min(range.box_min.y, box.box_min.y);
+		range.box_min.z = std::min(range.box_min.z, box.box_min.z);
+		range.box_max.x = std::max(range.box_max.x, box.box_max.x);
+		range.box_max.y = std::max(range.box_max.y, box.box_max.y);
+		range.box_max.z = std::max(range.box_max.z, box.box_max.z);
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------refit
+struct BVHRefitJob
+{
+	BVH *bvh;
+	const int *nodes;
+};
+
+void BVH::update_object(int object, const AABB &aabb)
+{
+	if (object < 0 || object >= num_objects)
+		return;
+
+	int pos = object_positions[object];
+	leaf_arrays[0][pos] = aabb.box_min.x;
+	leaf_arrays[1][pos] = aabb.box_min.y;
+	leaf_arrays[2][pos] = aabb.box_min.z;
+	leaf_arrays[3][pos] = aabb.box_max.x;
+	leaf_arrays[4][pos] = aabb.box_max.y;
+	leaf_arrays[5][pos] = aabb.box_max.z;
+	mark_dirty(leaf_refs[pos] / BVH_WIDTH);
+}
+
+void BVH::mark_dirty(int node_index)
+{
+	if (node_dirty[node_index])
+		return;
+	node_dirty[node_index] = 1;
+	dirty_levels[node_depths[node_index]].push_back(node_index);
+	num_dirty_nodes++;
+}
+
+double BVH::calc_slot_cost(const BVHNode &node, int slot) const
+{
+	if (!node.num_objects[slot])
+		return 0.0;
+	double dx = node.max_x[slot] - node.min_x[slot];
+	double dy = node.max_y[slot] - node.min_y[slot];
+	double dz = node.max_z[slot] - node.min_z[slot];
+	double area = 2.0 * (dx * dy + dy * dz + dz * dx);
+	return node.child[slot] < 0 ? area * node.num_objects[slot] : area;
+}
+
+double BVH::calc_root_area() const
+{
+	if (!num_nodes)
+		return 0.0;
+	const BVHNode &root = nodes[0];
+	float box_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float box_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int i = 0; i < BVH_WIDTH; i++)
+		if (root.num_objects[i])
+		{
+			box_min[0] = std::min(box_min[0], root.min_x[i]); box_max[0] = std::max(box_max[0], root.max_x[i]);
+			box_min[1] = std::min(box_min[1], root.min_y[i]); box_max[1] = std::max(box_max[1], root.max_y[i]);
+			box_min[2] = std::min(box_min[2], root.min_z[i]); box_max[2] = std::max(box_max[2], root.max_z[i]);
+		}
+	double dx = box_max[0] - box_min[0], dy = box_max[1] - box_min[1], dz = box_max[2] - box_min[2];
+	return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+float BVH::get_cost_ratio() const
+{
+	double root_area = calc_root_area();
+	if (build_cost <= 0.0 || root_area <= 0.0)
+		return 1.f;
+	return float(cost / root_area / build_cost);
+}
+
+//bounds of node children are unions of their objects or child nodes children, children are refitted before
+void BVH::refit_node(int node_index)
+{
+	BVHNode &node = nodes[node_index];
+	double new_cost = 0.0;
+	for (int i = 0; i < BVH_WIDTH; i++)
+	{
+		if (!node.num_objects[i])
+			continue;
+
+		float box_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float box_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		if (node.child[i] < 0)
+		{
+			for (int j = node.first_object[i]; j < node.first_object[i] + node.num_objects[i]; j++)
+			{
+				box_min[0] = std::min(box_min[0], leaf_arrays[0][j]); box_max[0] = std::max(box_max[0], leaf_arrays[3][j]);
+				box_min[1] = std::min(box_min[1], leaf_arrays[1][j]); box_max[1] = std::max(box_max[1], leaf_arrays[4][j]);
+				box_min[2] = std::min(box_min[2], leaf_arrays[2][j]); box_max[2] = std::max(box_max[2], leaf_arrays[5][j]);
+			}
+		} else
+		{
+			const BVHNode &child = nodes[node.child[i]];
+			for (int j = 0; j < BVH_WIDTH; j++)
+				if (child.num_objects[j])
+				{
+					box_min[0] = std::min(box_min[0], child.min_x[j]); box_max[0] = std::max(box_max[0], child.max_x[j]);
+					box_min[1] = std::min(box_min[1], child.min_y[j]); box_max[1] = std::max(box_max[1], child.max_y[j]);
+					box_min[2] = std::min(box_min[2], child.min_z[j]); box_max[2] = std::max(box_max[2], child.max_z[j]);
+				}
+		}
+
+		node.min_x[i] = box_min[0]; node.min_y[i] = box_min[1]; node.min_z[i] = box_min[2];
+		node.max_x[i] = box_max[0]; node.max_y[i] = box_max[1]; node.max_z[i] = box_max[2];
+		new_cost += calc_slot_cost(node, i);
+	}
+	node_cost_deltas[node_index] = new_cost - node_costs[node_index];
+	node_costs[node_index] = new_cost;
+}
+
+void BVH::refit_job(void *data, int first, int num, int worker_index)
+{
+	BVHRefitJob *job = (BVHRefitJob*)data;
+	for (int i = first; i < first + num; i++)
+		job->bvh->refit_node(job->nodes[i]);
+}
+
+bool BVH::refit(JobSystem *job_system)
+{
+	if (!num_dirty_nodes)
+		return false;
+
+	//nodes of one level don't depend on each other, the deepest level goes first
+	for (int depth = int(dirty_levels.size()) - 1; depth >= 0; depth--)
+	{
+		std::vector<int> &level = dirty_levels[depth];
+		if (level.empty())
+			continue;
+
+		BVHRefitJob job = { this, &level[0] };
+		if (job_system)
+			job_system->parallel_for(int(level.size()), BVH_REFIT_CHUNK_SIZE, refit_job, &job);
+		else
+			refit_job(&job, 0, int(level.size()), 0);
+
+		//parents are refitted with the next level
+		for (size_t i = 0; i < level.size(); i++)
+		{
+			int node_index = level[i];
+			node_dirty[node_index] = 0;
+			cost += node_cost_deltas[node_index];
+			if (node_parents[node_index] >= 0)
+				mark_dirty(node_parents[node_index] / BVH_WIDTH);
+		}
+		level.clear();
+	}
+	num_dirty_nodes = 0;
+
+	if (get_cost_ratio() > rebuild_threshold)
+	{
+		rebuild();
+		return true;
+	}
+	return false;
+}
+
+void BVH::rebuild()
+{
+	if (!num_objects)
+		return;
+
+	//current bounds are stored in leaves only
+	int n = num_objects;
+	AABB *aabbs = new_sse_array<AABB>(n);
+	for (int i = 0; i < n; i++)
+	{
+		AABB &box = aabbs[object_indices[i]];
+		box.box_min = vec4(leaf_arrays[0][i], leaf_arrays[1][i], leaf_arrays[2][i], 1.f);
+		box.box_max = vec4(leaf_arrays[3][i], leaf_arrays[4][i], leaf_arrays[5][i], 1.f);
+	}
+	build(aabbs, n);
+	delete_sse_array(aabbs, n);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------culling
+void BVH::cull(uint32_t *visibility, const CullingContext &ctx) const
+{
+	if (!num_objects)
+		return;
+	memset(&visibility[0], 0, sizeof(uint32_t) * visibility_words(num_objects));
+
+	//node & planes which its children may intersect, planes which parent is fully inside of are skipped
+	struct StackEntry
+	{
+		int node;
+		int plane_mask;
+	};
+	StackEntry stack[BVH_STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size].node = 0;
+	stack[stack_size].plane_mask = (1 << 6) - 1;
+	stack_size++;
+
+	int straddle[6];
+	while (stack_size)
+	{
+		StackEntry entry = stack[--stack_size];
+		const BVHNode &node = nodes[entry.node];
+		int outside = sse_test_boxes(node.min_x, node.min_y, node.min_z, node.max_x, node.max_y, node.max_z, ctx, entry.plane_mask, straddle);
+
+		for (int i = 0; i < BVH_WIDTH; i++)
+		{
+			if (!node.num_objects[i] || (outside & (1 << i)))
+				continue;
+
+			int child_plane_mask = box_plane_mask(straddle, i);
+			if (!child_plane_mask)
+				accept_indexed_objects(visibility, &object_indices[0], node.first_object[i], node.num_objects[i]);
+			else if (node.child[i] < 0)
+				cull_indexed_objects(visibility, &object_indices[0], leaf_arrays, ctx, child_plane_mask, node.first_object[i], node.num_objects[i]);
+			else
+			{
+				stack[stack_size].node = node.child[i];
+				stack[stack_size].plane_mask = child_plane_mask;
+				stack_size++;
+			}
+		}
+	}
+}
@@ -0,0 +1,107 @@
+#ifndef _BVH_H
+#define _BVH_H
+
+#include <vector>
+#include "Culling.h"
+
+//4-wide bounding volume hierarchy over objects aabbs
+//node keeps bounds of its 4 children as structure of arrays, so one sse operation tests all children against a frustum plane.
+//child which is fully inside the frustum accepts its whole subtree without per-object tests, fully outside child rejects it,
+//planes which child is inside of are not tested in its subtree. Culling touches only nodes near the visible part of the scene.
+//objects of every subtree are contiguous in leaf order, leaves test their objects by 4 with the same sse code.
+//results are exactly the same as aabb kernels give: p-vertex distance of object <= distance of node, n-vertex >= node one
+//
+//moving objects: update_object() changes object bounds & marks its leaf, refit() recalculates bounds of marked nodes bottom up,
+//level by level in parallel. Refit keeps the tree topology, so its quality degrades when objects move far. Quality is measured by
+//surface area heuristic cost, refit() rebuilds the tree when the cost grows more than rebuild_threshold times since the last build
+
+const int BVH_WIDTH = 4;
+const int BVH_MAX_LEAF_OBJECTS = 8;
+const float BVH_DEFAULT_REBUILD_THRESHOLD = 1.5f;
+
+class JobSystem;
+
+struct ALIGN_SSE BVHNode
+{
+	float min_x[BVH_WIDTH];
+	float min_y[BVH_WIDTH];
+	float min_z[BVH_WIDTH];
+	float max_x[BVH_WIDTH];
+	float max_y[BVH_WIDTH];
+	float max_z[BVH_WIDTH];
+	int child[BVH_WIDTH]; //child node index, -1 for leaf
+	int first_object[BVH_WIDTH]; //first object of child's subtree in leaf order
+	int num_objects[BVH_WIDTH]; //0 for empty child slot
+};
+
+class BVH
+{
+public:
+	BVH();
+	~BVH();
+
+	void build(const AABB *aabbs, int num_objects);
+	void clear();
+
+	//sets bits of visible objects, indices are the same as in aabbs array passed to build. visibility should have visibility_words(num_objects) words
+	void cull(uint32_t *visibility, const CullingContext &ctx) const;
+
+	//moving objects, should be called from one thread. Culling results are valid after refit()
+	void update_object(int object, const AABB &aabb);
+	bool refit(JobSystem *job_system = NULL); //returns true if the tree was rebuilt
+	void rebuild();
+
+	void set_rebuild_threshold(float threshold) { rebuild_threshold = threshold; }
+	float get_cost_ratio() const; //current cost / cost after the last build
+
+	int get_num_objects() const { return num_objects; }
+	int get_num_nodes() const { return num_nodes; }
+
+private:
+	//objects range in leaf order with its bounds
+	struct BuildRange
+	{
+		int first;
+		int count;
+		vec3 box_min;
+		vec3 box_max;
+	};
+
+	int build_node(const AABB *aabbs, int first, int count, int parent_ref, int depth);
+	void split_range(const AABB *aabbs, BuildRange &range, BuildRange &left, BuildRange &right);
+	void calc_range_bounds(const AABB *aabbs, BuildRange &range);
+	int add_node(int parent_ref, int depth);
+
+	//refit
+	static void refit_job(void *data, int first, int num, int worker_index);
+	void refit_node(int node_index);
+	void mark_dirty(int node_index);
+	double calc_slot_cost(const BVHNode &node, int slot) const;
+	double calc_root_area() const;
+
+	int num_objects;
+	int num_nodes;
+	int nodes_capacity;
+	BVHNode *nodes; //root is node 0
+
+	std::vector<int> object_indices; //leaf order -> object index
+	std::vector<int> object_positions; //object index -> leaf order
+	std::vector<int> leaf_refs; //leaf order -> node * BVH_WIDTH + slot of the leaf
+	float *leaf_arrays[6]; //objects bounds in leaf order: min x, y, z, max x, y, z, padded for 4 objects loads
+
+	//refit
+	std::vector<int> node_parents; //parent node * BVH_WIDTH + slot, -1 for root
+	std::vector<int> node_depths;
+	std::vector<char> node_dirty;
+	std::vector<double> node_costs; //sah cost of node children
+	std::vector<double> node_cost_deltas; //cost change by the last refit_node
+	std::vector< std::vector<int> > dirty_levels; //dirty nodes by depth
+	int num_dirty_nodes;
+
+	//sah cost: sum of children areas, leaves are weighted by objects count
+	double cost;
+	double build_cost; //cost divided by root area after the last build
+	float rebuild_threshold;
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "BoundsSoA.h"
+#include <string.h>
+
+
+BoundsSoA::BoundsSoA() : types(0), num_objects(0), capacity(0)
+{
+	for (int i = 0; i < get_num_arrays(); i++)
+		get_array(i) = NULL;
+}
+
+BoundsSoA::~BoundsSoA()
+{
+	clear();
+}
+
+void BoundsSoA::init(int max_objects, int in_types)
+{
+	clear();
+	types = in_types;
+	reserve(max_objects);
+}
+
+void BoundsSoA::clear()
+{
+	for (int i = 0; i < get_num_arrays(); i++)
+		if (get_array(i))
+		{
+			delete_sse(get_array(i));
+			get_array(i) = NULL;
+		}
+
+	num_objects = 0;
+	capacity = 0;
+	id_to_slot.clear();
+	slot_to_id.clear();
+	free_ids.clear();
+}
+
+float *&BoundsSoA::get_array(int index)
+{
+	if (index < NUM_SPHERE_COMPONENTS)
+		return sphere_arrays[index];
+	index -= NUM_SPHERE_COMPONENTS;
+	if (index < NUM_AABB_COMPONENTS)
+		return aabb_arrays[index];
+	index -= NUM_AABB_COMPONENTS;
+	if (index < NUM_AABB_CENTER_EXTENT_COMPONENTS)
+		return aabb_center_extent_arrays[index];
+	return obb_arrays[index - NUM_AABB_CENTER_EXTENT_COMPONENTS];
+}
+
+int BoundsSoA::get_array_type(int index) const
+{
+	if (index < NUM_SPHERE_COMPONENTS)
+		return BOUNDS_SOA_SPHERES;
+	if (index < NUM_SPHERE_COMPONENTS + NUM_AABB_COMPONENTS)
+		return BOUNDS_SOA_AABB;
+	if (index < NUM_SPHERE_COMPONENTS + NUM_AABB_COMPONENTS + NUM_AABB_CENTER_EXTENT_COMPONENTS)
+		return BOUNDS_SOA_AABB_CENTER_EXTENT;
+	return BOUNDS_SOA_OBB;
+}
+
+void BoundsSoA::reserve(int new_capacity)
+{
+	new_capacity = (new_capacity + CULLING_OBJECTS_ALIGNMENT - 1) / CULLING_OBJECTS_ALIGNMENT * CULLING_OBJECTS_ALIGNMENT;
+	if (new_capacity < CULLING_OBJECTS_ALIGNMENT)
+		new_capacity = CULLING_OBJECTS_ALIGNMENT;
+	if (new_capacity <= capacity)
+		return;
+
+	//reallocate arrays of stored types, new slots are zeroed so padding objects have valid values
+	for (int i = 0; i < get_num_arrays(); i++)
+	{
+		if (!(types & get_array_type(i)))
+			continue;
+
+		float *&arr = get_array(i);
+		float *new_arr = new_sse<float>(new_capacity);
+		if (arr)
+		{
+			memcpy(new_arr, arr, sizeof(float) * capacity);
+			delete_sse(arr);
+		}
+		memset(&new_arr[capacity], 0, sizeof(float) * (new_capacity - capacity));
+		arr = new_arr;
+	}
+
+	capacity = new_capacity;
+	slot_to_id.reserve(capacity);
+}
+
+void BoundsSoA::copy_slot(int dest, int src)
+{
+	for (int i = 0; i < get_num_arrays(); i++)
+		if (get_array(i))
+			get_array(i)[dest] = get_array(i)[src];
+}
+
+void BoundsSoA::clear_slot(int slot)
+{
+	for (int i = 0; i < get_num_arrays(); i++)
+		if (get_array(i))
+			get_array(i)[slot] = 0.f;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------objects
+int BoundsSoA::add(const BSphere &sphere, const AABB &aabb)
+{
+	if (num_objects == capacity)
+		reserve(capacity * 2);
+
+	int id;
+	if (!free_ids.empty())
+	{
+		id = free_ids.back();
+		free_ids.pop_back();
+	} else
+	{
+		id = int(id_to_slot.size());
+		id_to_slot.push_back(-1);
+	}
+
+	int slot = num_objects++;
+	id_to_slot[id] = slot;
+	slot_to_id.push_back(id);
+
+	update_sphere(id, sphere);
+	update_aabb(id, aabb);
+	return id;
+}
+
+void BoundsSoA::remove(int id)
+{
+	int slot = get_slot(id);
+	if (slot < 0)
+		return;
+
+	//move last object to the hole
+	int last_slot = num_objects - 1;
+	if (slot != last_slot)
+	{
+		copy_slot(slot, last_slot);
+		int last_id = slot_to_id[last_slot];
+		slot_to_id[slot] = last_id;
+		id_to_slot[last_id] = slot;
+	}
+	clear_slot(last_slot);
+	slot_to_id.pop_back();
+	num_objects--;
+
+	id_to_slot[id] = -1;
+	free_ids.push_back(id);
+}
+
+void BoundsSoA::update_sphere(int id, const BSphere &sphere)
+{
+	int slot = get_slot(id);
+	if (slot < 0 || !(types & BOUNDS_SOA_SPHERES))
+		return;
+
+	sphere_arrays[0][slot] = sphere.pos.x;
+	sphere_arrays[1][slot] = sphere.pos.y;
+	sphere_arrays[2][slot] = sphere.pos.z;
+	sphere_arrays[3][slot] = sphere.r;
+}
+
+void BoundsSoA::update_aabb(int id, const AABB &aabb)
+{
+	int slot = get_slot(id);
+	if (slot < 0)
+		return;
+
+	if (types & BOUNDS_SOA_AABB)
+	{
+		aabb_arrays[0][slot] = aabb.box_min.x;
+		aabb_arrays[1][slot] = aabb.box_min.y;
+		aabb_arrays[2][slot] = aabb.box_min.z;
+		aabb_arrays[3][slot] = aabb.box_max.x;
+		aabb_arrays[4][slot] = aabb.box_max.y;
+		aabb_arrays[5][slot] = aabb.box_max.z;
+	}
+
+	if (types & BOUNDS_SOA_AABB_CENTER_EXTENT)
+	{
+		aabb_center_extent_arrays[0][slot] = (aabb.box_min.x + aabb.box_max.x) * 0.5f;
+		aabb_center_extent_arrays[1][slot] = (aabb.box_min.y + aabb.box_max.y) * 0.5f;
+		aabb_center_extent_arrays[2][slot] = (aabb.box_min.z + aabb.box_max.z) * 0.5f;
+		aabb_center_extent_arrays[3][slot] = (aabb.box_max.x - aabb.box_min.x) * 0.5f;
+		aabb_center_extent_arrays[4][slot] = (aabb.box_max.y - aabb.box_min.y) * 0.5f;
+		aabb_center_extent_arrays[5][slot] = (aabb.box_max.z - aabb.box_min.z) * 0.5f;
+	}
+}
+
+void BoundsSoA::update_obb(int id, const AffineTransform &transform)
+{
+	int slot = get_slot(id);
+	if (slot < 0 || !(types & BOUNDS_SOA_OBB))
+		return;
+
+	for (int col = 0; col < 4; col++)
+		for (int row = 0; row < 3; row++)
+			obb_arrays[col * 3 + row][slot] = transform.rows[row][col];
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------views
+SpheresSoA BoundsSoA::get_spheres(int first_slot) const
+{
+	SpheresSoA res = { NULL, NULL, NULL, NULL };
+	if (types & BOUNDS_SOA_SPHERES)
+	{
+		res.pos_x = &sphere_arrays[0][first_slot];
+		res.pos_y = &sphere_arrays[1][first_slot];
+		res.pos_z = &sphere_arrays[2][first_slot];
+		res.radius = &sphere_arrays[3][first_slot];
+	}
+	return res;
+}
+
+AABBSoA BoundsSoA::get_aabbs(int first_slot) const
+{
+	AABBSoA res = { NULL, NULL, NULL, NULL, NULL, NULL };
+	if (types & BOUNDS_SOA_AABB)
+	{
+		res.min_x = &aabb_arrays[0][first_slot];
+		res.min_y = &aabb_arrays[1][first_slot];
+		res.min_z = &aabb_arrays[2][first_slot];
+		res.max_x = &aabb_arrays[3][first_slot];
+		res.max_y = &aabb_arrays[4][first_slot];
+		res.max_z = &aabb_arrays[5][first_slot];
+	}
+	return res;
+}
+
+AABBCenterExtentSoA BoundsSoA::get_aabb_center_extents(int first_slot) const
+{
+	AABBCenterExtentSoA res = { NULL, NULL, NULL, NULL, NULL, NULL };
+	if (types & BOUNDS_SOA_AABB_CENTER_EXTENT)
+	{
+		res.center_x = &aabb_center_extent_arrays[0][first_slot];
+		res.center_y = &aabb_center_extent_arrays[1][first_slot];
+		res.center_z = &aabb_center_extent_arrays[2][first_slot];
+		res.extent_x = &aabb_center_extent_arrays[3][first_slot];
+		res.extent_y = &aabb_center_extent_arrays[4][first_slot];
+		res.extent_z = &aabb_center_extent_arrays[5][first_slot];
+	}
+	return res;
+}
+
+OBBSoA BoundsSoA::get_obbs(int first_slot) const
+{
+	OBBSoA res;
+	for (int i = 0; i < NUM_OBB_COMPONENTS; i++)
+		res.m[i] = (types & BOUNDS_SOA_OBB) ? &obb_arrays[i][first_slot] : NULL;
+	return res;
+}
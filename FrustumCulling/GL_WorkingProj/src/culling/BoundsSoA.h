@@ -0,0 +1,73 @@
+#ifndef _BOUNDS_SOA_H
+#define _BOUNDS_SOA_H
+
+#include <vector>
+#include "Culling.h"
+
+//bounding volumes stored as structure of arrays: separate x, y, z, r arrays for spheres, min/max component arrays for aabbs
+//and center/half extent component arrays for the same aabbs, obbs are stored as affine object matrices by element
+//objects are addressed by id, which doesn't change while object exists. Internally objects are packed without holes:
+//remove() moves the last object to the free slot, so culling kernels always process [0, size()) range.
+//culling results are written by slot, use get_object_id(slot) to map them back to objects
+
+enum BOUNDS_SOA_TYPE
+{
+	BOUNDS_SOA_SPHERES = 1 << 0,
+	BOUNDS_SOA_AABB = 1 << 1,
+	BOUNDS_SOA_AABB_CENTER_EXTENT = 1 << 2, //filled by update_aabb() from min/max
+	BOUNDS_SOA_OBB = 1 << 3, //filled by update_obb(), zero matrices after add()
+	BOUNDS_SOA_ALL = BOUNDS_SOA_SPHERES | BOUNDS_SOA_AABB | BOUNDS_SOA_AABB_CENTER_EXTENT | BOUNDS_SOA_OBB
+};
+
+class BoundsSoA
+{
+public:
+	BoundsSoA();
+	~BoundsSoA();
+
+	//types - which bounding volumes are stored, other types are ignored by add/update
+	void init(int max_objects, int types = BOUNDS_SOA_ALL);
+	void clear();
+
+	int add(const BSphere &sphere, const AABB &aabb); //returns object id
+	void remove(int id);
+	void update_sphere(int id, const BSphere &sphere);
+	void update_aabb(int id, const AABB &aabb);
+	void update_obb(int id, const AffineTransform &transform);
+
+	int size() const { return num_objects; }
+	int padded_size() const { return (num_objects + CULLING_OBJECTS_ALIGNMENT - 1) / CULLING_OBJECTS_ALIGNMENT * CULLING_OBJECTS_ALIGNMENT; }
+	int get_slot(int id) const { return id >= 0 && id < int(id_to_slot.size()) ? id_to_slot[id] : -1; }
+	int get_object_id(int slot) const { return slot_to_id[slot]; }
+
+	//views for culling kernels, first_slot should be multiple of CULLING_OBJECTS_ALIGNMENT
+	SpheresSoA get_spheres(int first_slot = 0) const;
+	AABBSoA get_aabbs(int first_slot = 0) const;
+	AABBCenterExtentSoA get_aabb_center_extents(int first_slot = 0) const;
+	OBBSoA get_obbs(int first_slot = 0) const;
+
+private:
+	enum { NUM_SPHERE_COMPONENTS = 4, NUM_AABB_COMPONENTS = 6, NUM_AABB_CENTER_EXTENT_COMPONENTS = 6, NUM_OBB_COMPONENTS = OBB_SOA_COMPONENTS };
+
+	void reserve(int new_capacity);
+	void copy_slot(int dest, int src);
+	void clear_slot(int slot);
+	int get_num_arrays() const { return NUM_SPHERE_COMPONENTS + NUM_AABB_COMPONENTS + NUM_AABB_CENTER_EXTENT_COMPONENTS + NUM_OBB_COMPONENTS; }
+	float *&get_array(int index);
+	int get_array_type(int index) const;
+
+	int types;
+	int num_objects;
+	int capacity; //multiple of CULLING_OBJECTS_ALIGNMENT, padding slots are zeroed
+
+	float *sphere_arrays[NUM_SPHERE_COMPONENTS]; //pos x, y, z, radius
+	float *aabb_arrays[NUM_AABB_COMPONENTS]; //min x, y, z, max x, y, z
+	float *aabb_center_extent_arrays[NUM_AABB_CENTER_EXTENT_COMPONENTS]; //center x, y, z, half extent x, y, z
+	float *obb_arrays[NUM_OBB_COMPONENTS]; //see OBBSoA
+
+	std::vector<int> id_to_slot; //-1 for removed objects
+	std::vector<int> slot_to_id;
+	std::vector<int> free_ids;
+};
+
+#endif
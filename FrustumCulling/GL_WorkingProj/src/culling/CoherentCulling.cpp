@@ -0,0 +1,188 @@
+#include "CoherentCulling.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+
+CoherentCulling::CoherentCulling() : max_objects(0), padded_objects(0), expiration(NULL), last_plane(NULL), cached_visibility(NULL),
+	has_planes(false), drift(0.f), frame_drift(0.f), margin(0.f)
+{
+	memset(&planes[0], 0, sizeof(planes));
+}
+
+CoherentCulling::~CoherentCulling()
+{
+	clear();
+}
+
+void CoherentCulling::init(int in_max_objects)
+{
+	clear();
+	if (in_max_objects <= 0)
+		return;
+
+	max_objects = in_max_objects;
+	padded_objects = (max_objects + CULLING_OBJECTS_ALIGNMENT - 1) / CULLING_OBJECTS_ALIGNMENT * CULLING_OBJECTS_ALIGNMENT;
+	expiration = new_sse<float>(padded_objects);
+	last_plane = new_sse<uint8_t>(padded_objects);
+	cached_visibility = new_sse<uint32_t>(visibility_words(padded_objects));
+	memset(&last_plane[0], 0, sizeof(uint8_t) * padded_objects);
+	memset(&cached_visibility[0], 0, sizeof(uint32_t) * visibility_words(padded_objects));
+	invalidate_all();
+}
+
+void CoherentCulling::clear()
+{
+	if (expiration) { delete_sse(expiration); expiration = NULL; }
+	if (last_plane) { delete_sse(last_plane); last_plane = NULL; }
+	if (cached_visibility) { delete_sse(cached_visibility); cached_visibility = NULL; }
+	max_objects = 0;
+	padded_objects = 0;
+	memset(&planes[0], 0, sizeof(planes));
+	has_planes = false;
+	drift = 0.f;
+	frame_drift = 0.f;
+	margin = 0.f;
+}
+
+void CoherentCulling::invalidate(int object)
+{
+	if (object < 0 || object >= max_objects)
+		return;
+	expiration[object] = -1.f; //drift is never negative
+}
+
+void CoherentCulling::invalidate_all()
+{
+	for (int i = 0; i < padded_objects; i++)
+		expiration[i] = -1.f;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------frame
+void CoherentCulling::begin_frame(const CullingContext &ctx, const vec3 &scene_min, const vec3 &scene_max)
+{
+	//plane distance change is linear function of position, so its maximum over the scene box is at one of box corners.
+	//the first frame has no previous planes, all results are invalidated then & drift starts from 0
+	float max_delta = 0.f;
+	float max_distance_term = 0.f;
+	for (int i = 0; i < 6; i++)
+	{
+		const vec4 &plane = ctx.planes[i];
+		float dx = plane.x - planes[i].x, dy = plane.y - planes[i].y, dz = plane.z - planes[i].z, dw = plane.w - planes[i].w;
+		for (int c = 0; c < 8; c++)
+		{
+			float x = (c & 1) ? scene_max.x : scene_min.x;
+			float y = (c & 2) ? scene_max.y : scene_min.y;
+			float z = (c & 4) ? scene_max.z : scene_min.z;
+			if (has_planes)
+				max_delta = std::max(max_delta, fabsf(dx * x + dy * y + dz * z + dw));
+			max_distance_term = std::max(max_distance_term, fabsf(plane.x * x) + fabsf(plane.y * y) + fabsf(plane.z * z) + fabsf(plane.w));
+		}
+		planes[i] = plane;
+	}
+
+	frame_drift = max_delta;
+	if (!has_planes || drift + frame_drift > COHERENT_CULLING_MAX_DRIFT)
+	{
+		drift = 0.f;
+		invalidate_all();
+	} else
+		drift += frame_drift;
+	has_planes = true;
+
+	//distances are sums of several products, drift is sum of many frames - both are conservative by a few ulps
+	margin = 16.f * FLT_EPSILON * (max_distance_term + drift + frame_drift);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------culling
+//distances are calculated in the same order as sse kernel does, so results are the same
+int CoherentCulling::cull(const SpheresSoA &spheres, int first, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	if (first < 0 || first + num_objects > max_objects)
+		return 0;
+
+	__m128 zero_v = _mm_setzero_ps();
+	__m128 drift_v = _mm_set1_ps(drift);
+	__m128 expiration_base_v = _mm_set1_ps(drift - margin);
+	const __m128 *planes_x = ctx.planes_x, *planes_y = ctx.planes_y, *planes_z = ctx.planes_z, *planes_w = ctx.planes_w;
+	__m128 plane_indices[6];
+	int i, j, k;
+	for (j = 0; j < 6; j++)
+		plane_indices[j] = _mm_set1_ps(float(j));
+
+	int num_plane_tests = 0;
+	for (int word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_index = (first + word_first) / VISIBILITY_WORD_BITS;
+		uint32_t word = cached_visibility[word_index];
+		int word_objects = std::min(VISIBILITY_WORD_BITS, num_objects - word_first);
+
+		//4 objects per step, group is tested again if result of any of its objects expired
+		for (j = 0; j < word_objects; j += 4)
+		{
+			i = word_first + j;
+			float *expiration_ptr = &expiration[first + i];
+			if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_load_ps(expiration_ptr), drift_v)) == 0xf)
+				continue;
+
+			__m128 pos_x = _mm_load_ps(&spheres.pos_x[i]);
+			__m128 pos_y = _mm_load_ps(&spheres.pos_y[i]);
+			__m128 pos_z = _mm_load_ps(&spheres.pos_z[i]);
+			__m128 neg_radius = _mm_sub_ps(zero_v, _mm_load_ps(&spheres.radius[i]));
+
+			//the last separating planes of invisible objects, usually they reject them again
+			uint8_t *last_plane_ptr = &last_plane[first + i];
+			__m128 distance_to_plane, separation;
+			if (!((word >> j) & 0xf))
+			{
+				const vec4 &p0 = ctx.planes[last_plane_ptr[0]], &p1 = ctx.planes[last_plane_ptr[1]], &p2 = ctx.planes[last_plane_ptr[2]], &p3 = ctx.planes[last_plane_ptr[3]];
+				distance_to_plane = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(pos_x, _mm_setr_ps(p0.x, p1.x, p2.x, p3.x)), _mm_mul_ps(pos_y, _mm_setr_ps(p0.y, p1.y, p2.y, p3.y))),
+					_mm_add_ps(_mm_mul_ps(pos_z, _mm_setr_ps(p0.z, p1.z, p2.z, p3.z)), _mm_setr_ps(p0.w, p1.w, p2.w, p3.w)));
+				separation = _mm_sub_ps(neg_radius, distance_to_plane);
+				num_plane_tests += 4;
+				if (_mm_movemask_ps(_mm_cmpge_ps(separation, zero_v)) == 0xf)
+				{
+					_mm_store_ps(expiration_ptr, _mm_add_ps(expiration_base_v, separation));
+					continue;
+				}
+			}
+
+			//all planes: visible objects slack is distance to the nearest plane, invisible ones slack is distance behind the farthest separating plane.
+			//plane with the largest separation is remembered for both, for visible objects it's the nearest plane - the most probable to reject them
+			__m128 outside = zero_v;
+			__m128 min_slack = _mm_set1_ps(FLT_MAX);
+			__m128 max_separation = _mm_set1_ps(-FLT_MAX);
+			__m128 separating_plane = zero_v;
+			for (k = 0; k < 6; k++)
+			{
+				distance_to_plane = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pos_x, planes_x[k]), _mm_mul_ps(pos_y, planes_y[k])), _mm_add_ps(_mm_mul_ps(pos_z, planes_z[k]), planes_w[k]));
+				outside = _mm_or_ps(outside, _mm_cmple_ps(distance_to_plane, neg_radius));
+				separation = _mm_sub_ps(neg_radius, distance_to_plane);
+				__m128 farther = _mm_cmpgt_ps(separation, max_separation);
+				max_separation = _mm_max_ps(max_separation, separation);
+				separating_plane = _mm_or_ps(_mm_and_ps(farther, plane_indices[k]), _mm_andnot_ps(farther, separating_plane));
+				min_slack = _mm_min_ps(min_slack, _mm_sub_ps(distance_to_plane, neg_radius));
+			}
+			num_plane_tests += 4 * 6;
+
+			__m128 slack = _mm_or_ps(_mm_and_ps(outside, max_separation), _mm_andnot_ps(outside, min_slack));
+			_mm_store_ps(expiration_ptr, _mm_add_ps(expiration_base_v, slack));
+
+			//plane indices to 4 bytes
+			__m128i separating_plane_i = _mm_cvttps_epi32(separating_plane);
+			separating_plane_i = _mm_packus_epi16(_mm_packs_epi32(separating_plane_i, separating_plane_i), separating_plane_i);
+			uint32_t separating_plane_bytes = uint32_t(_mm_cvtsi128_si32(separating_plane_i));
+			memcpy(last_plane_ptr, &separating_plane_bytes, sizeof(uint32_t));
+
+			word = (word & ~(0xfu << j)) | (uint32_t(~_mm_movemask_ps(outside) & 0xf) << j);
+		}
+
+		cached_visibility[word_index] = word;
+		visibility[word_first / VISIBILITY_WORD_BITS] = word;
+	}
+	return num_plane_tests;
+}
@@ -0,0 +1,51 @@
+#ifndef _COHERENT_CULLING_H
+#define _COHERENT_CULLING_H
+
+#include "Culling.h"
+
+//spheres culling which uses temporal coherence: camera moves a little between frames, so most objects keep their visibility.
+//when object is tested, its slack is remembered - how far its sphere is from changing the result:
+//visible object - distance to the nearest plane, invisible one - distance behind the plane which rejected it.
+//every frame planes move by at most drift over the scene (planes difference at scene box corners), drift is accumulated,
+//objects are not tested until accumulated drift since their test reaches their slack - one compare per object.
+//invisible objects test the plane which rejected them last time first ("last separating plane"), usually it rejects them again.
+//results are the same as sse_culling_spheres_soa gives
+
+//accumulated drift is reset & all objects are tested again when it becomes large, so float precision of expiration values stays good
+const float COHERENT_CULLING_MAX_DRIFT = 256.f;
+
+class CoherentCulling
+{
+public:
+	CoherentCulling();
+	~CoherentCulling();
+
+	void init(int max_objects); //all objects are tested on the first frame
+	void clear();
+
+	//once per frame before cull(), scene_min & scene_max - bounds of all spheres centers
+	void begin_frame(const CullingContext &ctx, const vec3 &scene_min, const vec3 &scene_max);
+
+	//culls objects [first, first + num_objects), may be called for different ranges in parallel.
+	//first should be multiple of CULLING_OBJECTS_ALIGNMENT, spheres & visibility point to the first object as for kernels,
+	//ctx - the same context as begin_frame() got. Returns number of plane tests
+	int cull(const SpheresSoA &spheres, int first, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+
+	void invalidate(int object); //object moved or changed its radius, it's tested on the next frame
+	void invalidate_all();
+
+private:
+	int max_objects;
+	int padded_objects;
+	float *expiration; //accumulated drift which makes object result unreliable, object is tested when drift reaches it
+	uint8_t *last_plane; //plane which rejected object last time, for visible object - the nearest plane
+	uint32_t *cached_visibility;
+
+	vec4 planes[6]; //of the previous begin_frame()
+	bool has_planes;
+	float drift; //accumulated since the last reset
+	float frame_drift;
+	float margin; //float rounding of distances & drift
+};
+
+#endif
@@ -0,0 +1,839 @@
+#include "Culling.h"
+#include "../platform/CpuFeatures.h"
+
+
+const char *culling_mode_names[NUM_CULLING_MODES] =
+{
+	"SIMPLE_SPHERES",
+	"SIMPLE_AABB",
+	"SIMPLE_OBB",
+
+	"SSE_SPHERES",
+	"SSE_AABB",
+	"SSE_OBB",
+
+	"SSE_SPHERES_SOA",
+	"SSE_AABB_SOA",
+	"SSE_AABB_CE",
+	"SSE_OBB_SOA",
+
+	"SSE_AABB_BVH",
+	"SSE_AABB_GRID",
+	"SSE_SPHERES_COHERENT",
+
+	"SSE_AABB_OCCLUSION"
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------context
+void CullingContext::set(const mat4 &view_proj_matrix)
+{
+	view_proj = view_proj_matrix;
+	sse_view_proj.set(view_proj);
+
+	CFrustum frustum;
+	frustum.CalculateFrustum(view_proj);
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] = frustum.frustum_planes[i];
+		plane_octants[i] = frustum.plane_octants[i];
+		planes_x[i] = _mm_set1_ps(planes[i].x);
+		planes_y[i] = _mm_set1_ps(planes[i].y);
+		planes_z[i] = _mm_set1_ps(planes[i].z);
+		planes_w[i] = _mm_set1_ps(planes[i].w);
+		abs_planes_x[i] = _mm_set1_ps(fabsf(planes[i].x));
+		abs_planes_y[i] = _mm_set1_ps(fabsf(planes[i].y));
+		abs_planes_z[i] = _mm_set1_ps(fabsf(planes[i].z));
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------visibility
+int count_visible_objects(const uint32_t *visibility, int num_objects)
+{
+	int num_full_words = num_objects / VISIBILITY_WORD_BITS;
+	int num_tail_bits = num_objects % VISIBILITY_WORD_BITS;
+	int num_visible = 0;
+	for (int i = 0; i < num_full_words; i++)
+		num_visible += count_bits(visibility[i]);
+	if (num_tail_bits)
+		num_visible += count_bits(visibility[num_full_words] & ((1u << num_tail_bits) - 1));
+	return num_visible;
+}
+
+int get_visible_objects(const uint32_t *visibility, int num_objects, int *visible_objects)
+{
+	int num_words = visibility_words(num_objects);
+	int num_visible = 0;
+	for (int i = 0; i < num_words; i++)
+	{
+		uint32_t word = visibility[i];
+		if (i == num_words - 1 && num_objects % VISIBILITY_WORD_BITS)
+			word &= (1u << (num_objects % VISIBILITY_WORD_BITS)) - 1; //skip padding objects
+
+		//walk set bits only
+		while (word)
+		{
+			visible_objects[num_visible++] = i * VISIBILITY_WORD_BITS + count_trailing_zeros(word);
+			word &= word - 1;
+		}
+	}
+	return num_visible;
+}
+
+int compact_visible_instances(const uint32_t *visibility, int num_objects, const vec4 *instances, int instance_size, vec4 *out)
+{
+	int num_words = visibility_words(num_objects);
+	const float *src = &instances[0].x;
+	float *dest = &out[0].x;
+	int num_visible = 0;
+	for (int i = 0; i < num_words; i++)
+	{
+		uint32_t word = visibility[i];
+		if (i == num_words - 1 && num_objects % VISIBILITY_WORD_BITS)
+			word &= (1u << (num_objects % VISIBILITY_WORD_BITS)) - 1; //skip padding objects
+
+		while (word)
+		{
+			int object = i * VISIBILITY_WORD_BITS + count_trailing_zeros(word);
+			word &= word - 1;
+
+			//out is written sequentially, it is fine for write combined gpu memory
+			const float *obj_src = &src[object * instance_size * 4];
+			for (int j = 0; j < instance_size; j++)
+				_mm_storeu_ps(&dest[j * 4], _mm_loadu_ps(&obj_src[j * 4]));
+			dest += instance_size * 4;
+			num_visible++;
+		}
+	}
+	return num_visible;
+}
+
+int compact_visible_packed_instances(const uint32_t *visibility, int num_objects, const PackedInstance *instances, PackedInstance *out)
+{
+	int num_words = visibility_words(num_objects);
+	int num_visible = 0;
+	for (int i = 0; i < num_words; i++)
+	{
+		uint32_t word = visibility[i];
+		if (i == num_words - 1 && num_objects % VISIBILITY_WORD_BITS)
+			word &= (1u << (num_objects % VISIBILITY_WORD_BITS)) - 1; //skip padding objects
+
+		while (word)
+		{
+			int object = i * VISIBILITY_WORD_BITS + count_trailing_zeros(word);
+			word &= word - 1;
+			out[num_visible++] = instances[object];
+		}
+	}
+	return num_visible;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------simple culling
+
+__forceinline bool SphereInFrustum(vec3 &pos, float &radius, const vec4 *frustum_planes)
+{
+	bool res = true;
+	//test all 6 frustum planes
+	for (int i = 0; i < 6; i++)
+	{
+		//calculate distance from sphere center to plane.
+		//if distance larger then sphere radius - sphere is outside frustum
+		if (frustum_planes[i].x * pos.x + frustum_planes[i].y * pos.y + frustum_planes[i].z * pos.z + frustum_planes[i].w <= -radius)
+			res = false;
+			//return false; //with flag works faster
+	}
+	return res;
+	//return true;
+}
+
+
+__forceinline bool RightParallelepipedInFrustum(vec4 &Min, vec4 &Max, const vec4 *frustum_planes, const int *plane_octants)
+{
+	bool inside = true;
+	//test all 6 frustum planes
+	for (int i = 0; i<6; i++)
+	{
+		//take positive vertex - box corner farthest along plane normal, its corner is selected by plane octant.
+		//if even this vertex is behind the plane - whole box is behind it & outside frustum
+		int octant = plane_octants[i];
+		float d = ((octant & PLANE_OCTANT_X) ? Max.x : Min.x) * frustum_planes[i].x
+				+ ((octant & PLANE_OCTANT_Y) ? Max.y : Min.y) * frustum_planes[i].y
+				+ ((octant & PLANE_OCTANT_Z) ? Max.z : Min.z) * frustum_planes[i].z
+				+ frustum_planes[i].w;
+		inside &= d > 0;
+		//return false; //with flag works faster
+	}
+	return inside;
+}
+
+
+
+__forceinline bool RightParallelepipedInFrustum2(vec4 &Min, vec4 &Max, vec4 *frustum_planes)
+{
+	//this is just example of basic idea - how BOX culling works, both AABB and OBB
+		//Min & Max are 2 world space box points. For AABB-drustum culling
+		//We may use transformed (by object matrix) to world space 8 box points. Replace Min & Max in equations and we get OBB-frustum.
+
+	//test all 6 frustum planes
+	for (int i = 0; i<6; i++)
+	{
+		//try to find such plane for which all 8 box points behind it
+			//test all 8 box points against frustum plane
+			//calculate distance from point to plane
+			//if point infront of the plane (dist > 0) - this is not separating plane
+		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
+			continue;
+		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
+			continue;
+
+		return false;
+	}
+	return true;
+}
+
+__forceinline bool OBBInFrustum(const vec3 &Min, const vec3 &Max, mat4 &obj_transform_mat, const mat4 &cam_modelview_proj_mat)
+{
+	//transform all 8 box points to clip space
+	//clip space because we easily can test points outside required unit cube
+		//NOTE: for DirectX we should test z coordinate from 0 to w (-w..w - for OpenGL), look for transformations / clipping box differences
+
+	//matrix to transfrom points to clip space
+	mat4 to_clip_space_mat = cam_modelview_proj_mat * obj_transform_mat;
+
+	//transform all 8 box points to clip space
+	vec4 obb_points[8];
+	obb_points[0] = to_clip_space_mat * vec4(Min[0], Max[1], Min[2], 1.f);
+	obb_points[1] = to_clip_space_mat * vec4(Min[0], Max[1], Max[2], 1.f);
+	obb_points[2] = to_clip_space_mat * vec4(Max[0], Max[1], Max[2], 1.f);
+	obb_points[3] = to_clip_space_mat * vec4(Max[0], Max[1], Min[2], 1.f);
+	obb_points[4] = to_clip_space_mat * vec4(Max[0], Min[1], Min[2], 1.f);
+	obb_points[5] = to_clip_space_mat * vec4(Max[0], Min[1], Max[2], 1.f);
+	obb_points[6] = to_clip_space_mat * vec4(Min[0], Min[1], Max[2], 1.f);
+	obb_points[7] = to_clip_space_mat * vec4(Min[0], Min[1], Min[2], 1.f);
+
+	bool outside = false, outside_positive_plane, outside_negative_plane;
+	//we have 6 frustum planes, which in clip space is unit cube (for GL) with -1..1 range
+	for (int i = 0; i < 3; i++) //3 because we test positive & negative plane at once
+	{
+		//if all 8 points outside one of the plane
+		//actually it is vertex normalization xyz / w, then compare if all 8points coordinates < -1 or > 1
+
+		outside_positive_plane =
+			obb_points[0][i] > obb_points[0].w &&
+			obb_points[1][i] > obb_points[1].w &&
+			obb_points[2][i] > obb_points[2].w &&
+			obb_points[3][i] > obb_points[3].w &&
+			obb_points[4][i] > obb_points[4].w &&
+			obb_points[5][i] > obb_points[5].w &&
+			obb_points[6][i] > obb_points[6].w &&
+			obb_points[7][i] > obb_points[7].w;
+
+		outside_negative_plane =
+			 obb_points[0][i] < -obb_points[0].w &&
+			 obb_points[1][i] < -obb_points[1].w &&
+			 obb_points[2][i] < -obb_points[2].w &&
+			 obb_points[3][i] < -obb_points[3].w &&
+			 obb_points[4][i] < -obb_points[4].w &&
+			 obb_points[5][i] < -obb_points[5].w &&
+			 obb_points[6][i] < -obb_points[6].w &&
+			 obb_points[7][i] < -obb_points[7].w;
+
+		outside = outside || outside_positive_plane || outside_negative_plane;
+		//if (outside_positive_plane || outside_negative_plane)
+			//return false;
+	}
+	return !outside;
+	//return true;
+}
+
+
+
+
+void simple_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	VisibilityWriter visible(visibility);
+	for (int i = 0; i < num_objects; i++)
+		visible.add(SphereInFrustum(sphere_data[i].pos, sphere_data[i].r, &ctx.planes[0]), 1);
+	visible.flush();
+}
+
+void simple_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	VisibilityWriter visible(visibility);
+	for (int i = 0; i < num_objects; i++)
+		visible.add(RightParallelepipedInFrustum(aabb_data[i].box_min, aabb_data[i].box_max, &ctx.planes[0], &ctx.plane_octants[0]), 1);
+	visible.flush();
+}
+
+void simple_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	VisibilityWriter visible(visibility);
+	for (int i = 0; i < num_objects; i++)
+	{
+		mat4 obj_mat = transforms[i].get_mat4();
+		visible.add(OBBInFrustum(box_min, box_max, obj_mat, ctx.view_proj), 1);
+	}
+	visible.flush();
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------sse culling
+
+void sse_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	float *sphere_data_ptr = reinterpret_cast<float*>(&sphere_data[0]);
+	VisibilityWriter visible(visibility);
+
+	//to optimize calculations we gather xyzw elements in separate vectors
+	__m128 zero_v = _mm_setzero_ps();
+	const __m128 *frustum_planes_x = ctx.planes_x;
+	const __m128 *frustum_planes_y = ctx.planes_y;
+	const __m128 *frustum_planes_z = ctx.planes_z;
+	const __m128 *frustum_planes_d = ctx.planes_w;
+	int i, j;
+
+	//we process 4 objects per step
+	for (i = 0; i < num_objects; i += 4)
+	{
+		//load bounding sphere data
+		__m128 spheres_pos_x = _mm_load_ps(sphere_data_ptr);
+		__m128 spheres_pos_y = _mm_load_ps(sphere_data_ptr + 4);
+		__m128 spheres_pos_z = _mm_load_ps(sphere_data_ptr + 8);
+		__m128 spheres_radius = _mm_load_ps(sphere_data_ptr + 12);
+		sphere_data_ptr += 16;
+
+		//but for our calculations we need transpose data, to collect x, y, z and w coordinates in separate vectors
+		_MM_TRANSPOSE4_PS(spheres_pos_x, spheres_pos_y, spheres_pos_z, spheres_radius);
+
+		__m128 spheres_neg_radius = _mm_sub_ps(zero_v, spheres_radius);  // negate all elements
+																		 //http://fastcpp.blogspot.ru/2011/03/changing-sign-of-float-values-using-sse.html
+
+		__m128 intersection_res = _mm_setzero_ps();
+
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//1. calc distance to plane dot(sphere_pos.xyz, plane.xyz) + plane.w
+			//2. if distance < sphere radius, then sphere outside frustum
+			__m128 dot_x = _mm_mul_ps(spheres_pos_x, frustum_planes_x[j]);
+			__m128 dot_y = _mm_mul_ps(spheres_pos_y, frustum_planes_y[j]);
+			__m128 dot_z = _mm_mul_ps(spheres_pos_z, frustum_planes_z[j]);
+
+			__m128 sum_xy = _mm_add_ps(dot_x, dot_y);
+			__m128 sum_zw = _mm_add_ps(dot_z, frustum_planes_d[j]);
+			__m128 distance_to_plane = _mm_add_ps(sum_xy, sum_zw);
+
+			__m128 plane_res = _mm_cmple_ps(distance_to_plane, spheres_neg_radius); //dist < -sphere_r ?
+			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - sphere behind the plane & outside frustum
+		}
+
+		//store result, one bit per object. sign bits of the mask are set for culled objects
+		visible.add(~_mm_movemask_ps(intersection_res) & 0xf, 4);
+	}
+	visible.flush();
+}
+
+
+void sse_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	float *aabb_data_ptr = reinterpret_cast<float*>(&aabb_data[0]);
+	VisibilityWriter visible(visibility);
+
+	//to optimize calculations we gather xyzw elements in separate vectors
+	__m128 zero_v = _mm_setzero_ps();
+	const __m128 *frustum_planes_x = ctx.planes_x;
+	const __m128 *frustum_planes_y = ctx.planes_y;
+	const __m128 *frustum_planes_z = ctx.planes_z;
+	const __m128 *frustum_planes_d = ctx.planes_w;
+	int i, j;
+	int vertex_x[6], vertex_y[6], vertex_z[6];
+	get_positive_vertices(ctx.plane_octants, vertex_x, vertex_y, vertex_z);
+
+	__m128 zero = _mm_setzero_ps();
+	//we process 4 objects per step
+	for (i = 0; i < num_objects; i += 4)
+	{
+		//load objects data
+		//load aabb min
+		__m128 aabb_min_x = _mm_load_ps(aabb_data_ptr);
+		__m128 aabb_min_y = _mm_load_ps(aabb_data_ptr + 8);
+		__m128 aabb_min_z = _mm_load_ps(aabb_data_ptr + 16);
+		__m128 aabb_min_w = _mm_load_ps(aabb_data_ptr + 24);
+
+		//load aabb max
+		__m128 aabb_max_x = _mm_load_ps(aabb_data_ptr + 4);
+		__m128 aabb_max_y = _mm_load_ps(aabb_data_ptr + 12);
+		__m128 aabb_max_z = _mm_load_ps(aabb_data_ptr + 20);
+		__m128 aabb_max_w = _mm_load_ps(aabb_data_ptr + 28);
+
+		aabb_data_ptr += 32;
+
+		//for now we have points in vectors aabb_min_x..w, but for calculations we need to xxxx yyyy zzzz vectors representation - just transpose data
+		_MM_TRANSPOSE4_PS(aabb_min_x, aabb_min_y, aabb_min_z, aabb_min_w);
+		_MM_TRANSPOSE4_PS(aabb_max_x, aabb_max_y, aabb_max_z, aabb_max_w);
+		__m128 box[6] = { aabb_min_x, aabb_min_y, aabb_min_z, aabb_max_x, aabb_max_y, aabb_max_z };
+
+		__m128 intersection_res = _mm_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//this code is similar to what we make in simple culling
+				//take positive vertex (box corner farthest along plane normal) and check if it behind the plane. if yes - object outside frustum
+
+			//we have 8 box points, but only positive vertex is tested. Plane octant is the same for all 4 objects, so it selects the same min/max components
+			__m128 res_x = _mm_mul_ps(box[vertex_x[j]], frustum_planes_x[j]);
+			__m128 res_y = _mm_mul_ps(box[vertex_y[j]], frustum_planes_y[j]);
+			__m128 res_z = _mm_mul_ps(box[vertex_z[j]], frustum_planes_z[j]);
+
+			//dist to plane = dot(aabb_point.xyz, plane.xyz) + plane.w
+			__m128 sum_xy = _mm_add_ps(res_x, res_y);
+			__m128 sum_zw = _mm_add_ps(res_z, frustum_planes_d[j]);
+			__m128 distance_to_plane = _mm_add_ps(sum_xy, sum_zw);
+
+			__m128 plane_res = _mm_cmple_ps(distance_to_plane, zero); //dist from positive vertex to plane < 0 ?
+			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - aabb behind the plane & outside frustum
+		}
+
+		//store result, one bit per object. sign bits of the mask are set for culled objects
+		visible.add(~_mm_movemask_ps(intersection_res) & 0xf, 4);
+	}
+	visible.flush();
+}
+
+
+void sse_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	mat4_sse sse_clip_space_mat;
+
+//box points in local space
+	__m128 obb_points_sse[8];
+	obb_points_sse[0] = _mm_set_ps(1.f, box_min[2], box_max[1], box_min[0]);
+	obb_points_sse[1] = _mm_set_ps(1.f, box_max[2], box_max[1], box_min[0]);
+	obb_points_sse[2] = _mm_set_ps(1.f, box_max[2], box_max[1], box_max[0]);
+	obb_points_sse[3] = _mm_set_ps(1.f, box_min[2], box_max[1], box_max[0]);
+	obb_points_sse[4] = _mm_set_ps(1.f, box_min[2], box_min[1], box_max[0]);
+	obb_points_sse[5] = _mm_set_ps(1.f, box_max[2], box_min[1], box_max[0]);
+	obb_points_sse[6] = _mm_set_ps(1.f, box_max[2], box_min[1], box_min[0]);
+	obb_points_sse[7] = _mm_set_ps(1.f, box_min[2], box_min[1], box_min[0]);
+
+	VisibilityWriter visible(visibility);
+	__m128 zero_v = _mm_setzero_ps();
+	int i, j;
+
+	//process one object per step
+	for (i = 0; i < num_objects; i++)
+	{
+	//clip space matrix = camera_view_proj * obj_mat
+		sse_mat4_mul_affine(sse_clip_space_mat, ctx.sse_view_proj, transforms[i]);
+
+		//initially assume that planes are separating
+		//if any axis is separating - we get 0 in certain outside_* place
+		__m128 outside_positive_plane = _mm_set1_ps(-1.f); //NOTE: there should be negative value..
+		__m128 outside_negative_plane = _mm_set1_ps(-1.f); //because _mm_movemask_ps (while storing result) cares abount 'most significant bits' (it is sign of float value)
+
+		//for all 8 box points
+		for (j = 0; j < 8; j++)
+		{
+		//transform point to clip space
+			__m128 obb_transformed_point = sse_mat4_mul_vec4(sse_clip_space_mat, obb_points_sse[j]);
+
+		//gather w & -w
+			__m128 wwww = _mm_shuffle_ps(obb_transformed_point, obb_transformed_point, _MM_SHUFFLE(3, 3, 3, 3)); //get w
+			__m128 wwww_neg = _mm_sub_ps(zero_v, wwww);  // negate all elements
+
+		//box_point.xyz > box_point.w || box_point.xyz < -box_point.w ?
+		//similar to point normalization: point.xyz /= point.w; And compare: point.xyz > 1 && point.xyz < -1
+			__m128 outside_pos_plane = _mm_cmpge_ps(obb_transformed_point, wwww);
+			__m128 outside_neg_plane = _mm_cmple_ps(obb_transformed_point, wwww_neg);
+
+		//if at least 1 of 8 points in front of the plane - we get 0 in outside_* flag
+			outside_positive_plane = _mm_and_ps(outside_positive_plane, outside_pos_plane);
+			outside_negative_plane = _mm_and_ps(outside_negative_plane, outside_neg_plane);
+		}
+
+		//all 8 points xyz < -1 or > 1 ?
+		__m128 outside = _mm_or_ps(outside_positive_plane, outside_negative_plane);
+
+		//store result, if any of 3 axes is separating (i.e. outside != 0) - object outside frustum
+		//so, object inside frustum only if outside == 0 (there are no separating axes)
+		visible.add((_mm_movemask_ps(outside) & 0x7) == 0, 1); //& 0x7 mask, because we interested only in 3 axes
+	}
+	visible.flush();
+}
+
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------SSE SoA
+//the same tests as sse_culling_spheres/sse_culling_aabb, but components are already in xxxx yyyy zzzz form
+
+void sse_culling_spheres_soa(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	VisibilityWriter visible(visibility);
+	__m128 zero_v = _mm_setzero_ps();
+	const __m128 *frustum_planes_x = ctx.planes_x;
+	const __m128 *frustum_planes_y = ctx.planes_y;
+	const __m128 *frustum_planes_z = ctx.planes_z;
+	const __m128 *frustum_planes_d = ctx.planes_w;
+	int i, j;
+
+	//we process 4 objects per step
+	for (i = 0; i < num_objects; i += 4)
+	{
+		__m128 spheres_pos_x = _mm_load_ps(&sphere_data.pos_x[i]);
+		__m128 spheres_pos_y = _mm_load_ps(&sphere_data.pos_y[i]);
+		__m128 spheres_pos_z = _mm_load_ps(&sphere_data.pos_z[i]);
+		__m128 spheres_neg_radius = _mm_sub_ps(zero_v, _mm_load_ps(&sphere_data.radius[i]));
+
+		__m128 intersection_res = _mm_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//distance to plane = dot(sphere_pos.xyz, plane.xyz) + plane.w
+			__m128 dot_x = _mm_mul_ps(spheres_pos_x, frustum_planes_x[j]);
+			__m128 dot_y = _mm_mul_ps(spheres_pos_y, frustum_planes_y[j]);
+			__m128 dot_z = _mm_mul_ps(spheres_pos_z, frustum_planes_z[j]);
+			__m128 distance_to_plane = _mm_add_ps(_mm_add_ps(dot_x, dot_y), _mm_add_ps(dot_z, frustum_planes_d[j]));
+
+			__m128 plane_res = _mm_cmple_ps(distance_to_plane, spheres_neg_radius); //dist < -sphere_r ?
+			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - sphere behind the plane & outside frustum
+		}
+
+		visible.add(~_mm_movemask_ps(intersection_res) & 0xf, 4);
+	}
+	visible.flush();
+}
+
+
+void sse_culling_aabb_soa(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	VisibilityWriter visible(visibility);
+	const __m128 *frustum_planes_x = ctx.planes_x;
+	const __m128 *frustum_planes_y = ctx.planes_y;
+	const __m128 *frustum_planes_z = ctx.planes_z;
+	const __m128 *frustum_planes_d = ctx.planes_w;
+	int i, j;
+	const float *vertex_x[6], *vertex_y[6], *vertex_z[6];
+	get_positive_vertices(aabb_data, ctx.plane_octants, vertex_x, vertex_y, vertex_z);
+
+	__m128 zero = _mm_setzero_ps();
+	//we process 4 objects per step
+	for (i = 0; i < num_objects; i += 4)
+	{
+		__m128 intersection_res = _mm_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//positive vertex (box corner farthest along plane normal) behind the plane - object outside frustum
+			__m128 res_x = _mm_mul_ps(_mm_load_ps(&vertex_x[j][i]), frustum_planes_x[j]);
+			__m128 res_y = _mm_mul_ps(_mm_load_ps(&vertex_y[j][i]), frustum_planes_y[j]);
+			__m128 res_z = _mm_mul_ps(_mm_load_ps(&vertex_z[j][i]), frustum_planes_z[j]);
+
+			__m128 distance_to_plane = _mm_add_ps(_mm_add_ps(res_x, res_y), _mm_add_ps(res_z, frustum_planes_d[j]));
+
+			__m128 plane_res = _mm_cmple_ps(distance_to_plane, zero); //dist from positive vertex to plane < 0 ?
+			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - aabb behind the plane & outside frustum
+		}
+
+		visible.add(~_mm_movemask_ps(intersection_res) & 0xf, 4);
+	}
+	visible.flush();
+}
+
+
+//center/extent form: 3 products for center & 3 for extent per plane, no min/max selection. Results differ from min/max kernels only by rounding
+void sse_culling_aabb_center_extent(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	VisibilityWriter visible(visibility);
+	const __m128 *frustum_planes_x = ctx.planes_x;
+	const __m128 *frustum_planes_y = ctx.planes_y;
+	const __m128 *frustum_planes_z = ctx.planes_z;
+	const __m128 *frustum_planes_d = ctx.planes_w;
+	const __m128 *abs_planes_x = ctx.abs_planes_x;
+	const __m128 *abs_planes_y = ctx.abs_planes_y;
+	const __m128 *abs_planes_z = ctx.abs_planes_z;
+	int i, j;
+
+	__m128 zero = _mm_setzero_ps();
+	//we process 4 objects per step
+	for (i = 0; i < num_objects; i += 4)
+	{
+		__m128 center_x = _mm_load_ps(&aabb_data.center_x[i]);
+		__m128 center_y = _mm_load_ps(&aabb_data.center_y[i]);
+		__m128 center_z = _mm_load_ps(&aabb_data.center_z[i]);
+		__m128 extent_x = _mm_load_ps(&aabb_data.extent_x[i]);
+		__m128 extent_y = _mm_load_ps(&aabb_data.extent_y[i]);
+		__m128 extent_z = _mm_load_ps(&aabb_data.extent_z[i]);
+
+		__m128 intersection_res = _mm_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//distance from center + extent projected on plane normal (box radius along normal) = distance of positive vertex
+			__m128 center_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(center_x, frustum_planes_x[j]), _mm_mul_ps(center_y, frustum_planes_y[j])),
+				_mm_add_ps(_mm_mul_ps(center_z, frustum_planes_z[j]), frustum_planes_d[j]));
+			__m128 extent_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extent_x, abs_planes_x[j]), _mm_mul_ps(extent_y, abs_planes_y[j])), _mm_mul_ps(extent_z, abs_planes_z[j]));
+
+			__m128 plane_res = _mm_cmple_ps(_mm_add_ps(center_distance, extent_distance), zero); //center dist + projected radius < 0 ?
+			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - aabb behind the plane & outside frustum
+		}
+
+		visible.add(~_mm_movemask_ps(intersection_res) & 0xf, 4);
+	}
+	visible.flush();
+}
+
+
+//obbs by 4: instead of transforming 8 box points to clip space, box center & axes are tested against world space planes
+//like aabb with center & extent. Results differ from sse_culling_obb only by rounding
+void sse_culling_obb_soa(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	const __m128 *frustum_planes_x = ctx.planes_x;
+	const __m128 *frustum_planes_y = ctx.planes_y;
+	const __m128 *frustum_planes_z = ctx.planes_z;
+	const __m128 *frustum_planes_d = ctx.planes_w;
+	int i, j;
+	VisibilityWriter visible(visibility);
+
+	//local box is the same for all objects
+	__m128 local_center_x = _mm_set1_ps((box_min.x + box_max.x) * 0.5f);
+	__m128 local_center_y = _mm_set1_ps((box_min.y + box_max.y) * 0.5f);
+	__m128 local_center_z = _mm_set1_ps((box_min.z + box_max.z) * 0.5f);
+	__m128 half_size_x = _mm_set1_ps((box_max.x - box_min.x) * 0.5f);
+	__m128 half_size_y = _mm_set1_ps((box_max.y - box_min.y) * 0.5f);
+	__m128 half_size_z = _mm_set1_ps((box_max.z - box_min.z) * 0.5f);
+	__m128 sign_mask = _mm_set1_ps(-0.f);
+
+	__m128 zero = _mm_setzero_ps();
+
+	//we process 4 objects per step
+	for (i = 0; i < num_objects; i += 4)
+	{
+		//box axes scaled by box half size
+		__m128 axis0_x = _mm_mul_ps(_mm_load_ps(&obb_data.m[0][i]), half_size_x);
+		__m128 axis0_y = _mm_mul_ps(_mm_load_ps(&obb_data.m[1][i]), half_size_x);
+		__m128 axis0_z = _mm_mul_ps(_mm_load_ps(&obb_data.m[2][i]), half_size_x);
+		__m128 axis1_x = _mm_mul_ps(_mm_load_ps(&obb_data.m[3][i]), half_size_y);
+		__m128 axis1_y = _mm_mul_ps(_mm_load_ps(&obb_data.m[4][i]), half_size_y);
+		__m128 axis1_z = _mm_mul_ps(_mm_load_ps(&obb_data.m[5][i]), half_size_y);
+		__m128 axis2_x = _mm_mul_ps(_mm_load_ps(&obb_data.m[6][i]), half_size_z);
+		__m128 axis2_y = _mm_mul_ps(_mm_load_ps(&obb_data.m[7][i]), half_size_z);
+		__m128 axis2_z = _mm_mul_ps(_mm_load_ps(&obb_data.m[8][i]), half_size_z);
+
+		//world space box center = obj_mat * local center
+		__m128 center_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&obb_data.m[0][i]), local_center_x), _mm_mul_ps(_mm_load_ps(&obb_data.m[3][i]), local_center_y)),
+			_mm_add_ps(_mm_mul_ps(_mm_load_ps(&obb_data.m[6][i]), local_center_z), _mm_load_ps(&obb_data.m[9][i])));
+		__m128 center_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&obb_data.m[1][i]), local_center_x), _mm_mul_ps(_mm_load_ps(&obb_data.m[4][i]), local_center_y)),
+			_mm_add_ps(_mm_mul_ps(_mm_load_ps(&obb_data.m[7][i]), local_center_z), _mm_load_ps(&obb_data.m[10][i])));
+		__m128 center_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&obb_data.m[2][i]), local_center_x), _mm_mul_ps(_mm_load_ps(&obb_data.m[5][i]), local_center_y)),
+			_mm_add_ps(_mm_mul_ps(_mm_load_ps(&obb_data.m[8][i]), local_center_z), _mm_load_ps(&obb_data.m[11][i])));
+
+		__m128 intersection_res = _mm_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//projected radius: box reaches sum of abs projections of its scaled axes on plane normal from its center
+			__m128 proj0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(axis0_x, frustum_planes_x[j]), _mm_mul_ps(axis0_y, frustum_planes_y[j])), _mm_mul_ps(axis0_z, frustum_planes_z[j]));
+			__m128 proj1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(axis1_x, frustum_planes_x[j]), _mm_mul_ps(axis1_y, frustum_planes_y[j])), _mm_mul_ps(axis1_z, frustum_planes_z[j]));
+			__m128 proj2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(axis2_x, frustum_planes_x[j]), _mm_mul_ps(axis2_y, frustum_planes_y[j])), _mm_mul_ps(axis2_z, frustum_planes_z[j]));
+			__m128 box_radius = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign_mask, proj0), _mm_andnot_ps(sign_mask, proj1)), _mm_andnot_ps(sign_mask, proj2));
+
+			__m128 center_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(center_x, frustum_planes_x[j]), _mm_mul_ps(center_y, frustum_planes_y[j])),
+				_mm_add_ps(_mm_mul_ps(center_z, frustum_planes_z[j]), frustum_planes_d[j]));
+			__m128 distance_to_plane = _mm_add_ps(center_distance, box_radius);
+
+			__m128 plane_res = _mm_cmple_ps(distance_to_plane, zero); //center dist + projected radius < 0 ?
+			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - obb behind the plane & outside frustum
+		}
+
+		visible.add(~_mm_movemask_ps(intersection_res) & 0xf, 4);
+	}
+	visible.flush();
+}
+
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------multiview
+//objects are tested against all views while their bounds are in registers, bits of every view are collected to its own word.
+//distances are calculated in the same order as single view kernels do, so results are the same
+void sse_culling_spheres_soa_multiview(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views)
+{
+	if (num_views <= 0 || num_views > MAX_CULLING_VIEWS)
+		return;
+
+	__m128 zero_v = _mm_setzero_ps();
+	uint32_t words[MAX_CULLING_VIEWS];
+	int i, j, k, word_first;
+	for (word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_objects = num_objects - word_first < VISIBILITY_WORD_BITS ? num_objects - word_first : VISIBILITY_WORD_BITS;
+		for (k = 0; k < num_views; k++)
+			words[k] = 0;
+
+		//we process 4 objects per step
+		for (int bit = 0; bit < word_objects; bit += 4)
+		{
+			i = word_first + bit;
+			__m128 spheres_pos_x = _mm_load_ps(&sphere_data.pos_x[i]);
+			__m128 spheres_pos_y = _mm_load_ps(&sphere_data.pos_y[i]);
+			__m128 spheres_pos_z = _mm_load_ps(&sphere_data.pos_z[i]);
+			__m128 spheres_neg_radius = _mm_sub_ps(zero_v, _mm_load_ps(&sphere_data.radius[i]));
+
+			for (k = 0; k < num_views; k++)
+			{
+				const CullingContext &ctx = views[k];
+				__m128 intersection_res = _mm_setzero_ps();
+				for (j = 0; j < 6; j++) //plane index
+				{
+					__m128 dot_x = _mm_mul_ps(spheres_pos_x, ctx.planes_x[j]);
+					__m128 dot_y = _mm_mul_ps(spheres_pos_y, ctx.planes_y[j]);
+					__m128 dot_z = _mm_mul_ps(spheres_pos_z, ctx.planes_z[j]);
+					__m128 distance_to_plane = _mm_add_ps(_mm_add_ps(dot_x, dot_y), _mm_add_ps(dot_z, ctx.planes_w[j]));
+					intersection_res = _mm_or_ps(intersection_res, _mm_cmple_ps(distance_to_plane, spheres_neg_radius));
+				}
+				words[k] |= uint32_t(~_mm_movemask_ps(intersection_res) & 0xf) << bit;
+			}
+		}
+
+		for (k = 0; k < num_views; k++)
+			visibility[k][word_first / VISIBILITY_WORD_BITS] = words[k];
+	}
+}
+
+
+void sse_culling_aabb_center_extent_multiview(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views)
+{
+	if (num_views <= 0 || num_views > MAX_CULLING_VIEWS)
+		return;
+
+	__m128 zero = _mm_setzero_ps();
+	uint32_t words[MAX_CULLING_VIEWS];
+	int i, j, k, word_first;
+	for (word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_objects = num_objects - word_first < VISIBILITY_WORD_BITS ? num_objects - word_first : VISIBILITY_WORD_BITS;
+		for (k = 0; k < num_views; k++)
+			words[k] = 0;
+
+		//we process 4 objects per step
+		for (int bit = 0; bit < word_objects; bit += 4)
+		{
+			i = word_first + bit;
+			__m128 center_x = _mm_load_ps(&aabb_data.center_x[i]);
+			__m128 center_y = _mm_load_ps(&aabb_data.center_y[i]);
+			__m128 center_z = _mm_load_ps(&aabb_data.center_z[i]);
+			__m128 extent_x = _mm_load_ps(&aabb_data.extent_x[i]);
+			__m128 extent_y = _mm_load_ps(&aabb_data.extent_y[i]);
+			__m128 extent_z = _mm_load_ps(&aabb_data.extent_z[i]);
+
+			for (k = 0; k < num_views; k++)
+			{
+				const CullingContext &ctx = views[k];
+				__m128 intersection_res = _mm_setzero_ps();
+				for (j = 0; j < 6; j++) //plane index
+				{
+					__m128 center_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(center_x, ctx.planes_x[j]), _mm_mul_ps(center_y, ctx.planes_y[j])),
+						_mm_add_ps(_mm_mul_ps(center_z, ctx.planes_z[j]), ctx.planes_w[j]));
+					__m128 extent_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extent_x, ctx.abs_planes_x[j]), _mm_mul_ps(extent_y, ctx.abs_planes_y[j])), _mm_mul_ps(extent_z, ctx.abs_planes_z[j]));
+					intersection_res = _mm_or_ps(intersection_res, _mm_cmple_ps(_mm_add_ps(center_distance, extent_distance), zero));
+				}
+				words[k] |= uint32_t(~_mm_movemask_ps(intersection_res) & 0xf) << bit;
+			}
+		}
+
+		for (k = 0; k < num_views; k++)
+			visibility[k][word_first / VISIBILITY_WORD_BITS] = words[k];
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------simd dispatch
+const char *simd_level_names[NUM_SIMD_LEVELS] = { "sse", "avx2", "avx512" };
+
+static SIMD_LEVEL simd_level = SIMD_SSE;
+SpheresCullingFunc simd_culling_spheres = &sse_culling_spheres;
+AABBCullingFunc simd_culling_aabb = &sse_culling_aabb;
+OBBCullingFunc simd_culling_obb = &sse_culling_obb;
+SpheresSoACullingFunc simd_culling_spheres_soa = &sse_culling_spheres_soa;
+AABBSoACullingFunc simd_culling_aabb_soa = &sse_culling_aabb_soa;
+AABBCenterExtentCullingFunc simd_culling_aabb_center_extent = &sse_culling_aabb_center_extent;
+OBBSoACullingFunc simd_culling_obb_soa = &sse_culling_obb_soa;
+SpheresSoAMultiviewCullingFunc simd_culling_spheres_soa_multiview = &sse_culling_spheres_soa_multiview;
+AABBCenterExtentMultiviewCullingFunc simd_culling_aabb_center_extent_multiview = &sse_culling_aabb_center_extent_multiview;
+
+bool simd_level_supported(SIMD_LEVEL level)
+{
+	switch (level)
+	{
+	case SIMD_SSE: return true;
+	case SIMD_AVX2: return cpu_supports_avx2();
+	case SIMD_AVX512: return cpu_supports_avx512();
+	default: return false;
+	}
+}
+
+bool set_simd_level(SIMD_LEVEL level)
+{
+	if (!simd_level_supported(level))
+		return false;
+
+	simd_level = level;
+	switch (level)
+	{
+	case SIMD_SSE:
+		simd_culling_spheres = &sse_culling_spheres;
+		simd_culling_aabb = &sse_culling_aabb;
+		simd_culling_obb = &sse_culling_obb;
+		simd_culling_spheres_soa = &sse_culling_spheres_soa;
+		simd_culling_aabb_soa = &sse_culling_aabb_soa;
+		simd_culling_aabb_center_extent = &sse_culling_aabb_center_extent;
+		simd_culling_obb_soa = &sse_culling_obb_soa;
+		simd_culling_spheres_soa_multiview = &sse_culling_spheres_soa_multiview;
+		simd_culling_aabb_center_extent_multiview = &sse_culling_aabb_center_extent_multiview;
+		break;
+	case SIMD_AVX2:
+		simd_culling_spheres = &avx2_culling_spheres;
+		simd_culling_aabb = &avx2_culling_aabb;
+		simd_culling_obb = &avx2_culling_obb;
+		simd_culling_spheres_soa = &avx2_culling_spheres_soa;
+		simd_culling_aabb_soa = &avx2_culling_aabb_soa;
+		simd_culling_aabb_center_extent = &avx2_culling_aabb_center_extent;
+		simd_culling_obb_soa = &avx2_culling_obb_soa;
+		simd_culling_spheres_soa_multiview = &avx2_culling_spheres_soa_multiview;
+		simd_culling_aabb_center_extent_multiview = &avx2_culling_aabb_center_extent_multiview;
+		break;
+	case SIMD_AVX512:
+		simd_culling_spheres = &avx512_culling_spheres;
+		simd_culling_aabb = &avx512_culling_aabb;
+		simd_culling_obb = &avx512_culling_obb;
+		simd_culling_spheres_soa = &avx512_culling_spheres_soa;
+		simd_culling_aabb_soa = &avx512_culling_aabb_soa;
+		simd_culling_aabb_center_extent = &avx512_culling_aabb_center_extent;
+		simd_culling_obb_soa = &avx512_culling_obb_soa;
+		simd_culling_spheres_soa_multiview = &avx512_culling_spheres_soa_multiview;
+		simd_culling_aabb_center_extent_multiview = &avx512_culling_aabb_center_extent_multiview;
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+SIMD_LEVEL get_simd_level()
+{
+	return simd_level;
+}
+
+void init_simd_culling()
+{
+	for (int level = NUM_SIMD_LEVELS - 1; level >= SIMD_SSE; level--)
+		if (set_simd_level(SIMD_LEVEL(level)))
+			break;
+}
@@ -0,0 +1,577 @@
+#ifndef _CULLING_H
+#define _CULLING_H
+
+#include <xmmintrin.h>
+#include <mmintrin.h>
+#include <emmintrin.h>
+#include <new>
+
+#include "../platform/Platform.h"
+#include "../math/mathlib.h"
+#include "../Camera/Frustum.h"
+
+//AABB - axis-aligned bounding box
+//OBB - oriented Bounding Box
+
+//culling kernels don't depend on window or gl context, so they may be used by demo and by headless benchmark
+
+enum CULLING_MODE
+{
+	SIMPLE_SPHERES,
+	SIMPLE_AABB,
+	SIMPLE_OBB,
+
+	SSE_SPHERES,
+	SSE_AABB,
+	SSE_OBB,
+
+	SSE_SPHERES_SOA, //bounds from BoundsSoA container
+	SSE_AABB_SOA,
+	SSE_AABB_CE, //BoundsSoA aabbs as center & half extent, 24 bytes per object
+	SSE_OBB_SOA, //BoundsSoA obb matrices, several objects per step
+
+	SSE_AABB_BVH, //hierarchy over aabbs, see BVH.h
+	SSE_AABB_GRID, //uniform grid over aabbs, see UniformGrid.h
+
+	SSE_SPHERES_COHERENT, //BoundsSoA spheres, only objects which results may change since previous frames are tested, see CoherentCulling.h
+
+	SSE_AABB_OCCLUSION, //SSE_AABB_CE & software occlusion culling of visible objects, see OcclusionCulling.h
+
+	NUM_CULLING_MODES
+};
+extern const char *culling_mode_names[NUM_CULLING_MODES];
+
+
+//------------sse
+#define sse_align 16
+#define ALIGN_SSE ALIGN_AS( sse_align )
+
+//arrays are allocated at cache line boundary, so wide avx loads don't cross cache lines
+#define simd_array_align 64
+
+//kernels write visibility by 32 bit words and widest kernel (avx512) processes 16 objects per step
+//arrays should be padded and multithreading slices should be multiple of it, so threads never write the same word
+const int CULLING_OBJECTS_ALIGNMENT = 32;
+
+struct ALIGN_SSE mat4_sse
+{
+	__m128 col0;
+	__m128 col1;
+	__m128 col2;
+	__m128 col3;
+
+	mat4_sse() {}
+	mat4_sse(mat4 &m)
+	{
+		set(m);
+	}
+	inline void set(mat4 &m)
+	{
+		col0 = _mm_loadu_ps(&m.mat[0]);
+		col1 = _mm_loadu_ps(&m.mat[4]);
+		col2 = _mm_loadu_ps(&m.mat[8]);
+		col3 = _mm_loadu_ps(&m.mat[12]);
+	}
+};
+
+//instance transform - affine object matrix without its bottom row (0, 0, 0, 1): 48 bytes instead of 64 bytes of mat4.
+//rows[i] = (x axis[i], y axis[i], z axis[i], translation[i]), rows are aligned, so kernels load them directly
+struct ALIGN_SSE AffineTransform
+{
+	float rows[3][4];
+
+	void set(const mat4 &m)
+	{
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 4; col++)
+				rows[row][col] = m.mat[col * 4 + row];
+	}
+	void set_translation(const vec3 &pos) //identity rotation
+	{
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				rows[row][col] = row == col ? 1.f : 0.f;
+		rows[0][3] = pos.x;
+		rows[1][3] = pos.y;
+		rows[2][3] = pos.z;
+	}
+	mat4 get_mat4() const
+	{
+		mat4 m;
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 4; col++)
+				m.mat[col * 4 + row] = rows[row][col];
+		return m;
+	}
+	vec3 get_translation() const { return vec3(rows[0][3], rows[1][3], rows[2][3]); }
+};
+
+//per-frame culling state, set() once per frame and shared by all kernels & worker threads, so kernels don't prepare planes on every call:
+//frustum planes with their octants, plane components splatted to sse registers (avx kernels widen them by 128 bit broadcast),
+//camera view projection matrix for obb kernels
+struct ALIGN_SSE CullingContext
+{
+	__m128 planes_x[6];
+	__m128 planes_y[6];
+	__m128 planes_z[6];
+	__m128 planes_w[6];
+	__m128 abs_planes_x[6]; //abs of plane normals, center & extent tests
+	__m128 abs_planes_y[6];
+	__m128 abs_planes_z[6];
+	mat4_sse sse_view_proj;
+
+	mat4 view_proj;
+	vec4 planes[6]; //normalized - sphere tests compare distances with radius, box tests need only signs
+	int plane_octants[6];
+
+	void set(const mat4 &view_proj_matrix);
+};
+
+//------------bounding volumes
+struct ALIGN_SSE BSphere
+{
+	vec3 pos;
+	float r;
+};
+
+struct ALIGN_SSE AABB
+{
+	vec4 box_min;
+	vec4 box_max;
+};
+
+//world space aabb of local box transformed by affine matrix: center is transformed, extents are multiplied by abs of rotation part
+inline void transform_aabb(const vec3 &box_min, const vec3 &box_max, const mat4 &m, AABB &out)
+{
+	vec3 center = m * ((box_min + box_max) * 0.5f);
+	vec3 half_size = (box_max - box_min) * 0.5f;
+	vec3 extent;
+	for (int i = 0; i < 3; i++)
+		extent[i] = fabsf(m.mat[i]) * half_size.x + fabsf(m.mat[4 + i]) * half_size.y + fabsf(m.mat[8 + i]) * half_size.z;
+	out.box_min = vec4(center - extent, 1.f);
+	out.box_max = vec4(center + extent, 1.f);
+}
+
+//structure of arrays view of bounding volumes, one array per component, see BoundsSoA.h
+//kernels load components of several objects directly, without transposes
+struct SpheresSoA
+{
+	float *pos_x;
+	float *pos_y;
+	float *pos_z;
+	float *radius;
+};
+
+struct AABBSoA
+{
+	float *min_x;
+	float *min_y;
+	float *min_z;
+	float *max_x;
+	float *max_y;
+	float *max_z;
+};
+
+//the same aabb as center & half extent: distance to plane is dot(center, plane) + plane.w, the box reaches dot(extent, abs(plane normal)) further
+struct AABBCenterExtentSoA
+{
+	float *center_x;
+	float *center_y;
+	float *center_z;
+	float *extent_x;
+	float *extent_y;
+	float *extent_z;
+};
+
+//obb is local box transformed by object matrix, only affine part of matrices is stored: 12 arrays, one per matrix element.
+//m[0..2] - x axis, m[3..5] - y axis, m[6..8] - z axis, m[9..11] - translation (mat4 columns without w)
+const int OBB_SOA_COMPONENTS = 12;
+struct OBBSoA
+{
+	float *m[OBB_SOA_COMPONENTS];
+};
+
+//positive vertex of aabb for every plane (see plane_octant()), coordinates are indices of box bounds: min x, y, z - 0, 1, 2, max x, y, z - 3, 4, 5.
+//aabb kernels multiply only positive vertex by the plane: the same distance as max(min * plane, max * plane) per axis with half of products
+__forceinline void get_positive_vertices(const int *plane_octants, int *vertex_x, int *vertex_y, int *vertex_z)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		vertex_x[i] = (plane_octants[i] & PLANE_OCTANT_X) ? 3 : 0;
+		vertex_y[i] = (plane_octants[i] & PLANE_OCTANT_Y) ? 4 : 1;
+		vertex_z[i] = (plane_octants[i] & PLANE_OCTANT_Z) ? 5 : 2;
+	}
+}
+
+//the same for soa kernels: arrays which hold positive vertex coordinates for every plane
+__forceinline void get_positive_vertices(const AABBSoA &aabb_data, const int *plane_octants, const float **vertex_x, const float **vertex_y, const float **vertex_z)
+{
+	const float *bounds[6] = { aabb_data.min_x, aabb_data.min_y, aabb_data.min_z, aabb_data.max_x, aabb_data.max_y, aabb_data.max_z };
+	int index_x[6], index_y[6], index_z[6];
+	get_positive_vertices(plane_octants, index_x, index_y, index_z);
+	for (int i = 0; i < 6; i++)
+	{
+		vertex_x[i] = bounds[index_x[i]];
+		vertex_y[i] = bounds[index_y[i]];
+		vertex_z[i] = bounds[index_z[i]];
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------SSE base
+
+//https://github.com/nsf/sseculling/blob/master/Core/Memory.cpp
+template <typename T>
+inline T *new_sse(size_t size)
+{
+	return static_cast<T*>(aligned_malloc(sizeof(T)* size, simd_array_align));
+}
+
+template <typename T>
+inline void delete_sse(T *ptr)
+{
+	aligned_free(static_cast<void*>(ptr));
+}
+
+template <typename T>
+inline T* new_sse_array(int array_size)
+{
+	T* arr = static_cast<T*>(aligned_malloc(sizeof(T)* array_size, simd_array_align));
+	for (size_t i = 0; i < size_t(array_size); i++)
+		new (&arr[i]) T;
+	return arr;
+}
+
+template <typename T>
+inline void delete_sse_array(T *arr, size_t array_size)
+{
+	for (size_t i = 0; i < array_size; i++)
+		arr[i].~T();//destroy all initialized elements
+	aligned_free(static_cast<void*>(arr));
+}
+
+
+template <typename T>
+inline T *new_sse32(size_t size)
+{
+	return static_cast<T*>(aligned_malloc(sizeof(T)* size, 32));
+}
+
+
+
+//http://stackoverflow.com/questions/38090188/matrix-multiplication-using-sse
+//https://gist.github.com/rygorous/4172889
+
+__forceinline __m128 sse_mat4_mul_vec4(const mat4_sse &m, __m128 v)
+{
+	__m128 xxxx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 yyyy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 zzzz = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 wwww = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+
+	return _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(xxxx, m.col0), _mm_mul_ps(yyyy, m.col1)),
+		_mm_add_ps(_mm_mul_ps(zzzz, m.col2), _mm_mul_ps(wwww, m.col3))
+	);
+}
+
+__forceinline void sse_mat4_mul(mat4_sse &dest, mat4_sse &m1, mat4_sse &m2)
+{
+	dest.col0 = sse_mat4_mul_vec4(m1, m2.col0);
+	dest.col1 = sse_mat4_mul_vec4(m1, m2.col1);
+	dest.col2 = sse_mat4_mul_vec4(m1, m2.col2);
+	dest.col3 = sse_mat4_mul_vec4(m1, m2.col3);
+}
+
+//dest = m1 * affine m2, column k of m2 is k-th element of its rows, its 4th row is (0, 0, 0, 1), so 12 products instead of 16
+__forceinline void sse_mat4_mul_affine(mat4_sse &dest, const mat4_sse &m1, const AffineTransform &m2)
+{
+	__m128 row0 = _mm_load_ps(m2.rows[0]);
+	__m128 row1 = _mm_load_ps(m2.rows[1]);
+	__m128 row2 = _mm_load_ps(m2.rows[2]);
+
+#define AFFINE_COLUMN(k) _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row0, row0, _MM_SHUFFLE(k, k, k, k)), m1.col0), \
+	_mm_mul_ps(_mm_shuffle_ps(row1, row1, _MM_SHUFFLE(k, k, k, k)), m1.col1)), _mm_mul_ps(_mm_shuffle_ps(row2, row2, _MM_SHUFFLE(k, k, k, k)), m1.col2))
+	dest.col0 = AFFINE_COLUMN(0);
+	dest.col1 = AFFINE_COLUMN(1);
+	dest.col2 = AFFINE_COLUMN(2);
+	dest.col3 = _mm_add_ps(AFFINE_COLUMN(3), m1.col3);
+#undef AFFINE_COLUMN
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------visibility
+//culling result is a bitset, bit i is set if object i is inside the frustum: (visibility[i / 32] >> (i % 32)) & 1
+//bits after num_objects in the last word are undefined, kernels may test padding objects
+const int VISIBILITY_WORD_BITS = 32;
+
+inline int visibility_words(int num_objects)
+{
+	return (num_objects + VISIBILITY_WORD_BITS - 1) / VISIBILITY_WORD_BITS;
+}
+
+inline bool is_visible(const uint32_t *visibility, int object)
+{
+	return (visibility[object / VISIBILITY_WORD_BITS] >> (object % VISIBILITY_WORD_BITS)) & 1;
+}
+
+//used by kernels, collects bits of several steps & stores full words
+struct VisibilityWriter
+{
+	uint32_t *words;
+	uint32_t word;
+	int num_bits;
+
+	__forceinline VisibilityWriter(uint32_t *visibility) : words(visibility), word(0), num_bits(0) {}
+
+	//step should be power of 2, not greater than 32
+	__forceinline void add(uint32_t visible_bits, int step)
+	{
+		word |= visible_bits << num_bits;
+		num_bits += step;
+		if (num_bits == VISIBILITY_WORD_BITS)
+		{
+			*words++ = word;
+			word = 0;
+			num_bits = 0;
+		}
+	}
+
+	__forceinline void flush()
+	{
+		if (num_bits)
+			*words = word;
+	}
+};
+
+int count_visible_objects(const uint32_t *visibility, int num_objects);
+//writes indices of visible objects, walks only set bits. returns number of visible objects
+int get_visible_objects(const uint32_t *visibility, int num_objects, int *visible_objects);
+
+//copies data of visible objects (instance_size vec4 per object) to out, walks only set bits. returns number of copied instances
+//may be used right after culling of small block of objects, while its visibility is in L1, and out may be mapped gpu buffer
+int compact_visible_instances(const uint32_t *visibility, int num_objects, const vec4 *instances, int instance_size, vec4 *out);
+
+//------------packed instances
+//instance data uploaded for rendering: 16 bit fixed point position inside cell of ground grid & rgba8 color, 12 bytes instead of 2 vec4.
+//xy - x (low half) & y (high half), z_cell - z (low half), signed x (bits 16..23) & z (bits 24..31) of the cell.
+//x & z are fractions of the cell with INSTANCE_CELL_SIZE / 65536 step, y is stored as y / INSTANCE_CELL_SIZE * 0.5 + 0.5 with 2 * INSTANCE_CELL_SIZE / 65536 step.
+//gpu copy of pack_instance() & unpack_instance_position() is data/shaders/packed_instance.txt (included by culling_gs, culling_cs & geometry_vs),
+//changes of the format should be made in both. INSTANCE_CELL_SIZE is passed to shaders as define by init_shaders()
+//packed positions: x & z in [-128 * INSTANCE_CELL_SIZE, 128 * INSTANCE_CELL_SIZE), y in [-INSTANCE_CELL_SIZE, INSTANCE_CELL_SIZE).
+//positions outside are clamped to these bounds (cells to -128..127, fractions & y to unorm16), objects are drawn at the border then
+const float INSTANCE_CELL_SIZE = 4.f;
+
+struct PackedInstance
+{
+	uint32_t xy;
+	uint32_t z_cell;
+	uint32_t color; //r in the low byte
+};
+
+inline uint32_t pack_unorm16(float v)
+{
+	int q = int(v * 65536.f + 0.5f);
+	return q < 0 ? 0 : (q > 65535 ? 65535 : q);
+}
+
+inline uint32_t pack_unorm8(float v)
+{
+	int q = int(v * 255.f + 0.5f);
+	return q < 0 ? 0 : (q > 255 ? 255 : q);
+}
+
+inline float clamp_instance_cell(float cell)
+{
+	return cell < -128.f ? -128.f : (cell > 127.f ? 127.f : cell);
+}
+
+inline void pack_instance(const vec3 &pos, const vec4 &color, PackedInstance &out)
+{
+	float cell_x = clamp_instance_cell(floorf(pos.x / INSTANCE_CELL_SIZE));
+	float cell_z = clamp_instance_cell(floorf(pos.z / INSTANCE_CELL_SIZE));
+	uint32_t x = pack_unorm16(pos.x / INSTANCE_CELL_SIZE - cell_x);
+	uint32_t y = pack_unorm16(pos.y / INSTANCE_CELL_SIZE * 0.5f + 0.5f);
+	uint32_t z = pack_unorm16(pos.z / INSTANCE_CELL_SIZE - cell_z);
+	out.xy = x | (y << 16);
+	out.z_cell = z | ((uint32_t(int(cell_x)) & 0xff) << 16) | ((uint32_t(int(cell_z)) & 0xff) << 24);
+	out.color = pack_unorm8(color.x) | (pack_unorm8(color.y) << 8) | (pack_unorm8(color.z) << 16) | (pack_unorm8(color.w) << 24);
+}
+
+inline vec3 unpack_instance_position(const PackedInstance &instance)
+{
+	float cell_x = float(int8_t(instance.z_cell >> 16));
+	float cell_z = float(int8_t(instance.z_cell >> 24));
+	return vec3((cell_x + float(instance.xy & 0xffff) / 65536.f) * INSTANCE_CELL_SIZE,
+		(float(instance.xy >> 16) / 32768.f - 1.f) * INSTANCE_CELL_SIZE,
+		(cell_z + float(instance.z_cell & 0xffff) / 65536.f) * INSTANCE_CELL_SIZE);
+}
+
+//the same as compact_visible_instances for packed instances
+int compact_visible_packed_instances(const uint32_t *visibility, int num_objects, const PackedInstance *instances, PackedInstance *out);
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------culling kernels
+//sse kernels process 4 objects per step, avx2 - 8, avx512 - 16, so arrays should be padded to CULLING_OBJECTS_ALIGNMENT
+//visibility should point to the word of the first object, all kernels take planes & camera matrix from CullingContext of the frame
+
+void simple_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void simple_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void simple_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+
+void sse_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void sse_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void sse_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+
+//soa views should be aligned to CULLING_OBJECTS_ALIGNMENT objects
+void sse_culling_spheres_soa(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void sse_culling_aabb_soa(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void sse_culling_aabb_center_extent(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void sse_culling_obb_soa(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+
+//8 objects per step (obb - 2 objects), CullingAVX2.cpp
+void avx2_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx2_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx2_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+void avx2_culling_spheres_soa(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx2_culling_aabb_soa(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx2_culling_aabb_center_extent(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx2_culling_obb_soa(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+
+//16 objects per step (obb - 4 objects), CullingAVX512.cpp
+void avx512_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx512_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx512_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+void avx512_culling_spheres_soa(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx512_culling_aabb_soa(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx512_culling_aabb_center_extent(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+void avx512_culling_obb_soa(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+
+//multiview: one sweep over bounds for several views (shadow cascades, cube map faces, etc), bounds are loaded once and tested against planes of every view.
+//visibility[k] receives bits of views[k], results are the same as single view kernels give for each view
+const int MAX_CULLING_VIEWS = 8;
+void sse_culling_spheres_soa_multiview(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+void sse_culling_aabb_center_extent_multiview(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+void avx2_culling_spheres_soa_multiview(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+void avx2_culling_aabb_center_extent_multiview(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+void avx512_culling_spheres_soa_multiview(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+void avx512_culling_aabb_center_extent_multiview(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------spatial structures
+//shared by structures which test groups of boxes (BVH.h, UniformGrid.h): node or cell bounds & objects bounds are stored as structure of arrays
+
+//tests 4 boxes against planes from plane_mask, distances are calculated the same way as in aabb kernels.
+//returns mask of boxes which are outside, straddle[i] - mask of boxes which are not fully inside plane i
+__forceinline int sse_test_boxes(const float *min_x, const float *min_y, const float *min_z, const float *max_x, const float *max_y, const float *max_z,
+	const CullingContext &ctx, int plane_mask, int *straddle)
+{
+	__m128 zero_v = _mm_setzero_ps();
+	__m128 box_min_x = _mm_loadu_ps(min_x);
+	__m128 box_min_y = _mm_loadu_ps(min_y);
+	__m128 box_min_z = _mm_loadu_ps(min_z);
+	__m128 box_max_x = _mm_loadu_ps(max_x);
+	__m128 box_max_y = _mm_loadu_ps(max_y);
+	__m128 box_max_z = _mm_loadu_ps(max_z);
+
+	__m128 outside = zero_v;
+	for (int i = 0; i < 6; i++)
+	{
+		straddle[i] = 0;
+		if (!(plane_mask & (1 << i)))
+			continue;
+
+		__m128 plane_x = ctx.planes_x[i];
+		__m128 plane_y = ctx.planes_y[i];
+		__m128 plane_z = ctx.planes_z[i];
+		__m128 plane_w = ctx.planes_w[i];
+		__m128 min_dx = _mm_mul_ps(box_min_x, plane_x), max_dx = _mm_mul_ps(box_max_x, plane_x);
+		__m128 min_dy = _mm_mul_ps(box_min_y, plane_y), max_dy = _mm_mul_ps(box_max_y, plane_y);
+		__m128 min_dz = _mm_mul_ps(box_min_z, plane_z), max_dz = _mm_mul_ps(box_max_z, plane_z);
+
+		//p-vertex - the farthest point along plane normal, n-vertex - the nearest one
+		__m128 p_dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_max_ps(min_dx, max_dx), _mm_max_ps(min_dy, max_dy)), _mm_max_ps(min_dz, max_dz)), plane_w);
+		__m128 n_dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_min_ps(min_dx, max_dx), _mm_min_ps(min_dy, max_dy)), _mm_min_ps(min_dz, max_dz)), plane_w);
+		outside = _mm_or_ps(outside, _mm_cmpngt_ps(p_dist, zero_v));
+		straddle[i] = _mm_movemask_ps(_mm_cmpngt_ps(n_dist, zero_v));
+	}
+	return _mm_movemask_ps(outside);
+}
+
+//planes which box i straddles, from straddle masks of sse_test_boxes
+__forceinline int box_plane_mask(const int *straddle, int i)
+{
+	int plane_mask = 0;
+	for (int j = 0; j < 6; j++)
+		plane_mask |= ((straddle[j] >> i) & 1) << j;
+	return plane_mask;
+}
+
+//sets bits of objects [first, first + count) of structure order, indices - structure order -> object index
+inline void accept_indexed_objects(uint32_t *visibility, const int *indices, int first, int count)
+{
+	for (int i = first; i < first + count; i++)
+	{
+		int object = indices[i];
+		visibility[object / VISIBILITY_WORD_BITS] |= 1u << (object % VISIBILITY_WORD_BITS);
+	}
+}
+
+//tests objects [first, first + count) by 4 against planes from plane_mask, bounds - 6 arrays in structure order, padded for 4 objects loads
+inline void cull_indexed_objects(uint32_t *visibility, const int *indices, float * const *bounds, const CullingContext &ctx, int plane_mask, int first, int count)
+{
+	int straddle[6];
+	for (int i = first; i < first + count; i += 4)
+	{
+		int outside = sse_test_boxes(&bounds[0][i], &bounds[1][i], &bounds[2][i], &bounds[3][i], &bounds[4][i], &bounds[5][i],
+			ctx, plane_mask, straddle);
+		int num = first + count - i < 4 ? first + count - i : 4;
+		int visible = ~outside & ((1 << num) - 1);
+		while (visible)
+		{
+			int object = indices[i + count_trailing_zeros(visible)];
+			visible &= visible - 1;
+			visibility[object / VISIBILITY_WORD_BITS] |= 1u << (object % VISIBILITY_WORD_BITS);
+		}
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------simd dispatch
+//SSE_* modes use widest instruction set which cpu supports, sse kernels are fallback
+enum SIMD_LEVEL
+{
+	SIMD_SSE,
+	SIMD_AVX2,
+	SIMD_AVX512,
+
+	NUM_SIMD_LEVELS
+};
+extern const char *simd_level_names[NUM_SIMD_LEVELS];
+
+typedef void(*SpheresCullingFunc)(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+typedef void(*AABBCullingFunc)(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+typedef void(*OBBCullingFunc)(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+typedef void(*SpheresSoACullingFunc)(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+typedef void(*AABBSoACullingFunc)(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+typedef void(*AABBCenterExtentCullingFunc)(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx);
+typedef void(*OBBSoACullingFunc)(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx);
+typedef void(*SpheresSoAMultiviewCullingFunc)(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+typedef void(*AABBCenterExtentMultiviewCullingFunc)(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views);
+
+extern SpheresCullingFunc simd_culling_spheres;
+extern AABBCullingFunc simd_culling_aabb;
+extern OBBCullingFunc simd_culling_obb;
+extern SpheresSoACullingFunc simd_culling_spheres_soa;
+extern AABBSoACullingFunc simd_culling_aabb_soa;
+extern AABBCenterExtentCullingFunc simd_culling_aabb_center_extent;
+extern OBBSoACullingFunc simd_culling_obb_soa;
+extern SpheresSoAMultiviewCullingFunc simd_culling_spheres_soa_multiview;
+extern AABBCenterExtentMultiviewCullingFunc simd_culling_aabb_center_extent_multiview;
+
+void init_simd_culling(); //select widest supported instruction set
+bool simd_level_supported(SIMD_LEVEL level);
+bool set_simd_level(SIMD_LEVEL level); //false if cpu doesn't support it, current level is not changed in this case
+SIMD_LEVEL get_simd_level();
+
+#endif
@@ -0,0 +1,527 @@
+//avx2 culling kernels, 8 objects per step
+//this file is compiled with avx2 & fma enabled (see CMakeLists.txt), kernels are called only if cpu supports them (see set_simd_level)
+//NOTE: don't call not inlined functions from headers here (mathlib constructors etc), linker may pick their avx version for sse code
+
+#include "Culling.h"
+#include <immintrin.h>
+
+
+//transpose 4x4 floats in each 128 bit lane, same as _MM_TRANSPOSE4_PS
+static __forceinline void avx_transpose4_ps(__m256 &row0, __m256 &row1, __m256 &row2, __m256 &row3)
+{
+	__m256 tmp0 = _mm256_unpacklo_ps(row0, row1);
+	__m256 tmp1 = _mm256_unpacklo_ps(row2, row3);
+	__m256 tmp2 = _mm256_unpackhi_ps(row0, row1);
+	__m256 tmp3 = _mm256_unpackhi_ps(row2, row3);
+	row0 = _mm256_shuffle_ps(tmp0, tmp1, _MM_SHUFFLE(1, 0, 1, 0));
+	row1 = _mm256_shuffle_ps(tmp0, tmp1, _MM_SHUFFLE(3, 2, 3, 2));
+	row2 = _mm256_shuffle_ps(tmp2, tmp3, _MM_SHUFFLE(1, 0, 1, 0));
+	row3 = _mm256_shuffle_ps(tmp2, tmp3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+//2 x 128 bit values to one register: lo - low lane, hi - high lane
+static __forceinline __m256 avx_load_2x128(const float *lo, const float *hi)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(lo)), _mm_load_ps(hi), 1);
+}
+
+//context planes are already splatted to 4 lanes, 128 bit broadcast fills both lanes
+static __forceinline void avx_splat_planes(const CullingContext &ctx, __m256 *planes_x, __m256 *planes_y, __m256 *planes_z, __m256 *planes_d)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		planes_x[i] = _mm256_broadcast_ps(&ctx.planes_x[i]);
+		planes_y[i] = _mm256_broadcast_ps(&ctx.planes_y[i]);
+		planes_z[i] = _mm256_broadcast_ps(&ctx.planes_z[i]);
+		planes_d[i] = _mm256_broadcast_ps(&ctx.planes_w[i]);
+	}
+}
+
+//abs of plane normals, center & extent tests
+static __forceinline void avx_splat_abs_planes(const CullingContext &ctx, __m256 *abs_planes_x, __m256 *abs_planes_y, __m256 *abs_planes_z)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		abs_planes_x[i] = _mm256_broadcast_ps(&ctx.abs_planes_x[i]);
+		abs_planes_y[i] = _mm256_broadcast_ps(&ctx.abs_planes_y[i]);
+		abs_planes_z[i] = _mm256_broadcast_ps(&ctx.abs_planes_z[i]);
+	}
+}
+
+
+void avx2_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	float *sphere_data_ptr = reinterpret_cast<float*>(&sphere_data[0]);
+
+	__m256 frustum_planes_x[6];
+	__m256 frustum_planes_y[6];
+	__m256 frustum_planes_z[6];
+	__m256 frustum_planes_d[6];
+	avx_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	__m256 zero_v = _mm256_setzero_ps();
+	int i, j;
+
+	//we process 8 objects per step
+	for (i = 0; i < num_objects; i += 8)
+	{
+		//low lanes contain spheres 0..3, high lanes - spheres 4..7, so after transpose we get xxxxxxxx for spheres in right order
+		__m256 spheres_pos_x = avx_load_2x128(sphere_data_ptr, sphere_data_ptr + 16);
+		__m256 spheres_pos_y = avx_load_2x128(sphere_data_ptr + 4, sphere_data_ptr + 20);
+		__m256 spheres_pos_z = avx_load_2x128(sphere_data_ptr + 8, sphere_data_ptr + 24);
+		__m256 spheres_radius = avx_load_2x128(sphere_data_ptr + 12, sphere_data_ptr + 28);
+		sphere_data_ptr += 32;
+
+		avx_transpose4_ps(spheres_pos_x, spheres_pos_y, spheres_pos_z, spheres_radius);
+
+		__m256 spheres_neg_radius = _mm256_sub_ps(zero_v, spheres_radius);
+		__m256 intersection_res = _mm256_setzero_ps();
+
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//distance to plane = dot(sphere_pos.xyz, plane.xyz) + plane.w
+			__m256 distance_to_plane = _mm256_fmadd_ps(spheres_pos_x, frustum_planes_x[j],
+				_mm256_fmadd_ps(spheres_pos_y, frustum_planes_y[j],
+				_mm256_fmadd_ps(spheres_pos_z, frustum_planes_z[j], frustum_planes_d[j])));
+
+			__m256 plane_res = _mm256_cmp_ps(distance_to_plane, spheres_neg_radius, _CMP_LE_OQ); //dist < -sphere_r ?
+			intersection_res = _mm256_or_ps(intersection_res, plane_res); //if yes - sphere behind the plane & outside frustum
+		}
+
+		//store result, one bit per object
+		visible.add(~_mm256_movemask_ps(intersection_res) & 0xff, 8);
+	}
+	visible.flush();
+}
+
+
+void avx2_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	float *aabb_data_ptr = reinterpret_cast<float*>(&aabb_data[0]);
+
+	__m256 frustum_planes_x[6];
+	__m256 frustum_planes_y[6];
+	__m256 frustum_planes_z[6];
+	__m256 frustum_planes_d[6];
+	avx_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	int vertex_x[6], vertex_y[6], vertex_z[6];
+	get_positive_vertices(ctx.plane_octants, vertex_x, vertex_y, vertex_z);
+	VisibilityWriter visible(visibility);
+
+	__m256 zero = _mm256_setzero_ps();
+	int i, j;
+
+	//we process 8 objects per step
+	for (i = 0; i < num_objects; i += 8)
+	{
+		//one register = one aabb: min in low lane, max in high lane
+		__m256 a_x = _mm256_loadu_ps(aabb_data_ptr);
+		__m256 a_y = _mm256_loadu_ps(aabb_data_ptr + 8);
+		__m256 a_z = _mm256_loadu_ps(aabb_data_ptr + 16);
+		__m256 a_w = _mm256_loadu_ps(aabb_data_ptr + 24);
+
+		__m256 b_x = _mm256_loadu_ps(aabb_data_ptr + 32);
+		__m256 b_y = _mm256_loadu_ps(aabb_data_ptr + 40);
+		__m256 b_z = _mm256_loadu_ps(aabb_data_ptr + 48);
+		__m256 b_w = _mm256_loadu_ps(aabb_data_ptr + 56);
+		aabb_data_ptr += 64;
+
+		//after transpose: a_x = min.x of objects 0..3 | max.x of objects 0..3, b_x - the same for objects 4..7
+		avx_transpose4_ps(a_x, a_y, a_z, a_w);
+		avx_transpose4_ps(b_x, b_y, b_z, b_w);
+
+		//gather min & max of all 8 objects
+		__m256 aabb_min_x = _mm256_permute2f128_ps(a_x, b_x, 0x20);
+		__m256 aabb_min_y = _mm256_permute2f128_ps(a_y, b_y, 0x20);
+		__m256 aabb_min_z = _mm256_permute2f128_ps(a_z, b_z, 0x20);
+		__m256 aabb_max_x = _mm256_permute2f128_ps(a_x, b_x, 0x31);
+		__m256 aabb_max_y = _mm256_permute2f128_ps(a_y, b_y, 0x31);
+		__m256 aabb_max_z = _mm256_permute2f128_ps(a_z, b_z, 0x31);
+		__m256 box[6] = { aabb_min_x, aabb_min_y, aabb_min_z, aabb_max_x, aabb_max_y, aabb_max_z };
+
+		__m256 intersection_res = _mm256_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//positive vertex (box corner farthest along plane normal) behind the plane - object outside frustum
+			__m256 res_x = _mm256_mul_ps(box[vertex_x[j]], frustum_planes_x[j]);
+			__m256 res_y = _mm256_mul_ps(box[vertex_y[j]], frustum_planes_y[j]);
+			__m256 res_z = _mm256_mul_ps(box[vertex_z[j]], frustum_planes_z[j]);
+
+			__m256 distance_to_plane = _mm256_add_ps(_mm256_add_ps(res_x, res_y), _mm256_add_ps(res_z, frustum_planes_d[j]));
+
+			__m256 plane_res = _mm256_cmp_ps(distance_to_plane, zero, _CMP_LE_OQ); //dist from positive vertex to plane < 0 ?
+			intersection_res = _mm256_or_ps(intersection_res, plane_res); //if yes - aabb behind the plane & outside frustum
+		}
+
+		visible.add(~_mm256_movemask_ps(intersection_res) & 0xff, 8);
+	}
+	visible.flush();
+}
+
+
+void avx2_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	//camera matrix columns in both lanes
+	__m256 cam_col0 = _mm256_broadcast_ps(&ctx.sse_view_proj.col0);
+	__m256 cam_col1 = _mm256_broadcast_ps(&ctx.sse_view_proj.col1);
+	__m256 cam_col2 = _mm256_broadcast_ps(&ctx.sse_view_proj.col2);
+	__m256 cam_col3 = _mm256_broadcast_ps(&ctx.sse_view_proj.col3);
+
+	//box points coordinates are known, so instead of transforming 8 points with shuffles we scale clip matrix columns by min/max coordinates
+	__m256 box_min_x = _mm256_set1_ps(box_min.x), box_max_x = _mm256_set1_ps(box_max.x);
+	__m256 box_min_y = _mm256_set1_ps(box_min.y), box_max_y = _mm256_set1_ps(box_max.y);
+	__m256 box_min_z = _mm256_set1_ps(box_min.z), box_max_z = _mm256_set1_ps(box_max.z);
+
+	VisibilityWriter visible(visibility);
+	__m256 zero_v = _mm256_setzero_ps();
+	int i, j;
+
+	//process 2 objects per step, one object per lane
+	for (i = 0; i < num_objects; i += 2)
+	{
+		const AffineTransform &m0 = transforms[i];
+		const AffineTransform &m1 = transforms[i + 1];
+		__m256 obj_rows[3] = {
+			_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(m0.rows[0])), _mm_load_ps(m1.rows[0]), 1),
+			_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(m0.rows[1])), _mm_load_ps(m1.rows[1]), 1),
+			_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(m0.rows[2])), _mm_load_ps(m1.rows[2]), 1)
+		};
+
+		//clip space matrix = camera_view_proj * obj_mat, obj_mat bottom row is (0, 0, 0, 1)
+		__m256 clip_cols[4] = {
+			_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[0], 0x00), cam_col0,
+				_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[1], 0x00), cam_col1, _mm256_mul_ps(_mm256_permute_ps(obj_rows[2], 0x00), cam_col2))),
+			_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[0], 0x55), cam_col0,
+				_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[1], 0x55), cam_col1, _mm256_mul_ps(_mm256_permute_ps(obj_rows[2], 0x55), cam_col2))),
+			_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[0], 0xaa), cam_col0,
+				_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[1], 0xaa), cam_col1, _mm256_mul_ps(_mm256_permute_ps(obj_rows[2], 0xaa), cam_col2))),
+			_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[0], 0xff), cam_col0,
+				_mm256_fmadd_ps(_mm256_permute_ps(obj_rows[1], 0xff), cam_col1, _mm256_fmadd_ps(_mm256_permute_ps(obj_rows[2], 0xff), cam_col2, cam_col3)))
+		};
+
+		__m256 x_min = _mm256_mul_ps(clip_cols[0], box_min_x), x_max = _mm256_mul_ps(clip_cols[0], box_max_x);
+		__m256 y_min = _mm256_mul_ps(clip_cols[1], box_min_y), y_max = _mm256_mul_ps(clip_cols[1], box_max_y);
+		__m256 z_min = _mm256_fmadd_ps(clip_cols[2], box_min_z, clip_cols[3]), z_max = _mm256_fmadd_ps(clip_cols[2], box_max_z, clip_cols[3]);
+
+		//all 8 box points in clip space
+		__m256 xy[4] = { _mm256_add_ps(x_min, y_min), _mm256_add_ps(x_min, y_max), _mm256_add_ps(x_max, y_min), _mm256_add_ps(x_max, y_max) };
+
+		//initially assume that planes are separating
+		__m256 outside_positive_plane = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		__m256 outside_negative_plane = outside_positive_plane;
+
+		for (j = 0; j < 8; j++)
+		{
+			__m256 obb_transformed_point = _mm256_add_ps(xy[j >> 1], (j & 1) ? z_max : z_min);
+
+			__m256 wwww = _mm256_permute_ps(obb_transformed_point, 0xff);
+			__m256 wwww_neg = _mm256_sub_ps(zero_v, wwww);
+
+			//box_point.xyz > box_point.w || box_point.xyz < -box_point.w ?
+			outside_positive_plane = _mm256_and_ps(outside_positive_plane, _mm256_cmp_ps(obb_transformed_point, wwww, _CMP_GE_OQ));
+			outside_negative_plane = _mm256_and_ps(outside_negative_plane, _mm256_cmp_ps(obb_transformed_point, wwww_neg, _CMP_LE_OQ));
+		}
+
+		//if any of 3 axes is separating - object outside frustum
+		int outside = _mm256_movemask_ps(_mm256_or_ps(outside_positive_plane, outside_negative_plane));
+		visible.add(((outside & 0x7) == 0) | (((outside & 0x70) == 0) << 1), 2);
+	}
+	visible.flush();
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------SoA
+void avx2_culling_spheres_soa(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	__m256 frustum_planes_x[6];
+	__m256 frustum_planes_y[6];
+	__m256 frustum_planes_z[6];
+	__m256 frustum_planes_d[6];
+	avx_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	__m256 zero_v = _mm256_setzero_ps();
+	int i, j;
+
+	//we process 8 objects per step
+	for (i = 0; i < num_objects; i += 8)
+	{
+		__m256 spheres_pos_x = _mm256_load_ps(&sphere_data.pos_x[i]);
+		__m256 spheres_pos_y = _mm256_load_ps(&sphere_data.pos_y[i]);
+		__m256 spheres_pos_z = _mm256_load_ps(&sphere_data.pos_z[i]);
+		__m256 spheres_neg_radius = _mm256_sub_ps(zero_v, _mm256_load_ps(&sphere_data.radius[i]));
+
+		__m256 intersection_res = _mm256_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			__m256 distance_to_plane = _mm256_fmadd_ps(spheres_pos_x, frustum_planes_x[j],
+				_mm256_fmadd_ps(spheres_pos_y, frustum_planes_y[j],
+				_mm256_fmadd_ps(spheres_pos_z, frustum_planes_z[j], frustum_planes_d[j])));
+
+			__m256 plane_res = _mm256_cmp_ps(distance_to_plane, spheres_neg_radius, _CMP_LE_OQ); //dist < -sphere_r ?
+			intersection_res = _mm256_or_ps(intersection_res, plane_res);
+		}
+
+		visible.add(~_mm256_movemask_ps(intersection_res) & 0xff, 8);
+	}
+	visible.flush();
+}
+
+
+void avx2_culling_aabb_soa(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	__m256 frustum_planes_x[6];
+	__m256 frustum_planes_y[6];
+	__m256 frustum_planes_z[6];
+	__m256 frustum_planes_d[6];
+	avx_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	const float *vertex_x[6], *vertex_y[6], *vertex_z[6];
+	get_positive_vertices(aabb_data, ctx.plane_octants, vertex_x, vertex_y, vertex_z);
+	VisibilityWriter visible(visibility);
+
+	__m256 zero = _mm256_setzero_ps();
+	int i, j;
+
+	//we process 8 objects per step
+	for (i = 0; i < num_objects; i += 8)
+	{
+		__m256 intersection_res = _mm256_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			__m256 res_x = _mm256_mul_ps(_mm256_load_ps(&vertex_x[j][i]), frustum_planes_x[j]);
+			__m256 res_y = _mm256_mul_ps(_mm256_load_ps(&vertex_y[j][i]), frustum_planes_y[j]);
+			__m256 res_z = _mm256_mul_ps(_mm256_load_ps(&vertex_z[j][i]), frustum_planes_z[j]);
+
+			__m256 distance_to_plane = _mm256_add_ps(_mm256_add_ps(res_x, res_y), _mm256_add_ps(res_z, frustum_planes_d[j]));
+
+			__m256 plane_res = _mm256_cmp_ps(distance_to_plane, zero, _CMP_LE_OQ); //dist from positive vertex to plane < 0 ?
+			intersection_res = _mm256_or_ps(intersection_res, plane_res);
+		}
+
+		visible.add(~_mm256_movemask_ps(intersection_res) & 0xff, 8);
+	}
+	visible.flush();
+}
+
+
+void avx2_culling_aabb_center_extent(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	__m256 frustum_planes_x[6];
+	__m256 frustum_planes_y[6];
+	__m256 frustum_planes_z[6];
+	__m256 frustum_planes_d[6];
+	avx_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	__m256 abs_planes_x[6];
+	__m256 abs_planes_y[6];
+	__m256 abs_planes_z[6];
+	avx_splat_abs_planes(ctx, abs_planes_x, abs_planes_y, abs_planes_z);
+	int i, j;
+
+	__m256 zero = _mm256_setzero_ps();
+
+	//we process 8 objects per step
+	for (i = 0; i < num_objects; i += 8)
+	{
+		__m256 center_x = _mm256_load_ps(&aabb_data.center_x[i]);
+		__m256 center_y = _mm256_load_ps(&aabb_data.center_y[i]);
+		__m256 center_z = _mm256_load_ps(&aabb_data.center_z[i]);
+		__m256 extent_x = _mm256_load_ps(&aabb_data.extent_x[i]);
+		__m256 extent_y = _mm256_load_ps(&aabb_data.extent_y[i]);
+		__m256 extent_z = _mm256_load_ps(&aabb_data.extent_z[i]);
+
+		__m256 intersection_res = _mm256_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			__m256 center_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(center_x, frustum_planes_x[j]), _mm256_mul_ps(center_y, frustum_planes_y[j])),
+				_mm256_add_ps(_mm256_mul_ps(center_z, frustum_planes_z[j]), frustum_planes_d[j]));
+			__m256 extent_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extent_x, abs_planes_x[j]), _mm256_mul_ps(extent_y, abs_planes_y[j])), _mm256_mul_ps(extent_z, abs_planes_z[j]));
+			__m256 distance_to_plane = _mm256_add_ps(center_distance, extent_distance);
+
+			__m256 plane_res = _mm256_cmp_ps(distance_to_plane, zero, _CMP_LE_OQ); //center dist + projected radius < 0 ?
+			intersection_res = _mm256_or_ps(intersection_res, plane_res);
+		}
+
+		visible.add(~_mm256_movemask_ps(intersection_res) & 0xff, 8);
+	}
+	visible.flush();
+}
+
+
+void avx2_culling_obb_soa(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	__m256 frustum_planes_x[6];
+	__m256 frustum_planes_y[6];
+	__m256 frustum_planes_z[6];
+	__m256 frustum_planes_d[6];
+	avx_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	//local box is the same for all objects
+	__m256 local_center_x = _mm256_set1_ps((box_min.x + box_max.x) * 0.5f);
+	__m256 local_center_y = _mm256_set1_ps((box_min.y + box_max.y) * 0.5f);
+	__m256 local_center_z = _mm256_set1_ps((box_min.z + box_max.z) * 0.5f);
+	__m256 half_size_x = _mm256_set1_ps((box_max.x - box_min.x) * 0.5f);
+	__m256 half_size_y = _mm256_set1_ps((box_max.y - box_min.y) * 0.5f);
+	__m256 half_size_z = _mm256_set1_ps((box_max.z - box_min.z) * 0.5f);
+	__m256 sign_mask = _mm256_set1_ps(-0.f);
+
+	__m256 zero = _mm256_setzero_ps();
+	int i, j;
+
+	//we process 8 objects per step
+	for (i = 0; i < num_objects; i += 8)
+	{
+		//box axes scaled by box half size
+		__m256 axis0_x = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[0][i]), half_size_x);
+		__m256 axis0_y = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[1][i]), half_size_x);
+		__m256 axis0_z = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[2][i]), half_size_x);
+		__m256 axis1_x = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[3][i]), half_size_y);
+		__m256 axis1_y = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[4][i]), half_size_y);
+		__m256 axis1_z = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[5][i]), half_size_y);
+		__m256 axis2_x = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[6][i]), half_size_z);
+		__m256 axis2_y = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[7][i]), half_size_z);
+		__m256 axis2_z = _mm256_mul_ps(_mm256_load_ps(&obb_data.m[8][i]), half_size_z);
+
+		//world space box center = obj_mat * local center
+		__m256 center_x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&obb_data.m[0][i]), local_center_x), _mm256_mul_ps(_mm256_load_ps(&obb_data.m[3][i]), local_center_y)),
+			_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&obb_data.m[6][i]), local_center_z), _mm256_load_ps(&obb_data.m[9][i])));
+		__m256 center_y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&obb_data.m[1][i]), local_center_x), _mm256_mul_ps(_mm256_load_ps(&obb_data.m[4][i]), local_center_y)),
+			_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&obb_data.m[7][i]), local_center_z), _mm256_load_ps(&obb_data.m[10][i])));
+		__m256 center_z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&obb_data.m[2][i]), local_center_x), _mm256_mul_ps(_mm256_load_ps(&obb_data.m[5][i]), local_center_y)),
+			_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&obb_data.m[8][i]), local_center_z), _mm256_load_ps(&obb_data.m[11][i])));
+
+		__m256 intersection_res = _mm256_setzero_ps();
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//box reaches sum of abs projections of its scaled axes on plane normal from its center
+			__m256 proj0 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(axis0_x, frustum_planes_x[j]), _mm256_mul_ps(axis0_y, frustum_planes_y[j])), _mm256_mul_ps(axis0_z, frustum_planes_z[j]));
+			__m256 proj1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(axis1_x, frustum_planes_x[j]), _mm256_mul_ps(axis1_y, frustum_planes_y[j])), _mm256_mul_ps(axis1_z, frustum_planes_z[j]));
+			__m256 proj2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(axis2_x, frustum_planes_x[j]), _mm256_mul_ps(axis2_y, frustum_planes_y[j])), _mm256_mul_ps(axis2_z, frustum_planes_z[j]));
+			__m256 box_radius = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(sign_mask, proj0), _mm256_andnot_ps(sign_mask, proj1)), _mm256_andnot_ps(sign_mask, proj2));
+
+			__m256 center_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(center_x, frustum_planes_x[j]), _mm256_mul_ps(center_y, frustum_planes_y[j])),
+				_mm256_add_ps(_mm256_mul_ps(center_z, frustum_planes_z[j]), frustum_planes_d[j]));
+			__m256 distance_to_plane = _mm256_add_ps(center_distance, box_radius);
+
+			__m256 plane_res = _mm256_cmp_ps(distance_to_plane, zero, _CMP_LE_OQ); //center dist + projected radius < 0 ?
+			intersection_res = _mm256_or_ps(intersection_res, plane_res);
+		}
+
+		visible.add(~_mm256_movemask_ps(intersection_res) & 0xff, 8);
+	}
+	visible.flush();
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------multiview
+//the same tests as single view kernels, planes of all views are splatted once & bounds are loaded once for all views
+void avx2_culling_spheres_soa_multiview(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views)
+{
+	if (num_views <= 0 || num_views > MAX_CULLING_VIEWS)
+		return;
+
+	__m256 zero_v = _mm256_setzero_ps();
+	uint32_t words[MAX_CULLING_VIEWS];
+	__m256 frustum_planes_x[MAX_CULLING_VIEWS][6];
+	__m256 frustum_planes_y[MAX_CULLING_VIEWS][6];
+	__m256 frustum_planes_z[MAX_CULLING_VIEWS][6];
+	__m256 frustum_planes_d[MAX_CULLING_VIEWS][6];
+	int i, j, k, word_first;
+	for (k = 0; k < num_views; k++)
+		avx_splat_planes(views[k], frustum_planes_x[k], frustum_planes_y[k], frustum_planes_z[k], frustum_planes_d[k]);
+	for (word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_objects = num_objects - word_first < VISIBILITY_WORD_BITS ? num_objects - word_first : VISIBILITY_WORD_BITS;
+		for (k = 0; k < num_views; k++)
+			words[k] = 0;
+
+		//we process 8 objects per step
+		for (int bit = 0; bit < word_objects; bit += 8)
+		{
+			i = word_first + bit;
+			__m256 spheres_pos_x = _mm256_load_ps(&sphere_data.pos_x[i]);
+			__m256 spheres_pos_y = _mm256_load_ps(&sphere_data.pos_y[i]);
+			__m256 spheres_pos_z = _mm256_load_ps(&sphere_data.pos_z[i]);
+			__m256 spheres_neg_radius = _mm256_sub_ps(zero_v, _mm256_load_ps(&sphere_data.radius[i]));
+
+			for (k = 0; k < num_views; k++)
+			{
+				__m256 intersection_res = _mm256_setzero_ps();
+				for (j = 0; j < 6; j++) //plane index
+				{
+					__m256 distance_to_plane = _mm256_fmadd_ps(spheres_pos_x, frustum_planes_x[k][j],
+						_mm256_fmadd_ps(spheres_pos_y, frustum_planes_y[k][j],
+						_mm256_fmadd_ps(spheres_pos_z, frustum_planes_z[k][j], frustum_planes_d[k][j])));
+					intersection_res = _mm256_or_ps(intersection_res, _mm256_cmp_ps(distance_to_plane, spheres_neg_radius, _CMP_LE_OQ));
+				}
+				words[k] |= uint32_t(~_mm256_movemask_ps(intersection_res) & 0xff) << bit;
+			}
+		}
+
+		for (k = 0; k < num_views; k++)
+			visibility[k][word_first / VISIBILITY_WORD_BITS] = words[k];
+	}
+}
+
+
+void avx2_culling_aabb_center_extent_multiview(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views)
+{
+	if (num_views <= 0 || num_views > MAX_CULLING_VIEWS)
+		return;
+
+	__m256 zero = _mm256_setzero_ps();
+	uint32_t words[MAX_CULLING_VIEWS];
+	__m256 frustum_planes_x[MAX_CULLING_VIEWS][6];
+	__m256 frustum_planes_y[MAX_CULLING_VIEWS][6];
+	__m256 frustum_planes_z[MAX_CULLING_VIEWS][6];
+	__m256 frustum_planes_d[MAX_CULLING_VIEWS][6];
+	int i, j, k, word_first;
+	__m256 abs_planes_x[MAX_CULLING_VIEWS][6];
+	__m256 abs_planes_y[MAX_CULLING_VIEWS][6];
+	__m256 abs_planes_z[MAX_CULLING_VIEWS][6];
+	for (k = 0; k < num_views; k++)
+	{
+		avx_splat_planes(views[k], frustum_planes_x[k], frustum_planes_y[k], frustum_planes_z[k], frustum_planes_d[k]);
+		avx_splat_abs_planes(views[k], abs_planes_x[k], abs_planes_y[k], abs_planes_z[k]);
+	}
+
+	for (word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_objects = num_objects - word_first < VISIBILITY_WORD_BITS ? num_objects - word_first : VISIBILITY_WORD_BITS;
+		for (k = 0; k < num_views; k++)
+			words[k] = 0;
+
+		//we process 8 objects per step
+		for (int bit = 0; bit < word_objects; bit += 8)
+		{
+			i = word_first + bit;
+			__m256 center_x = _mm256_load_ps(&aabb_data.center_x[i]);
+			__m256 center_y = _mm256_load_ps(&aabb_data.center_y[i]);
+			__m256 center_z = _mm256_load_ps(&aabb_data.center_z[i]);
+			__m256 extent_x = _mm256_load_ps(&aabb_data.extent_x[i]);
+			__m256 extent_y = _mm256_load_ps(&aabb_data.extent_y[i]);
+			__m256 extent_z = _mm256_load_ps(&aabb_data.extent_z[i]);
+
+			for (k = 0; k < num_views; k++)
+			{
+				__m256 intersection_res = _mm256_setzero_ps();
+				for (j = 0; j < 6; j++) //plane index
+				{
+					__m256 center_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(center_x, frustum_planes_x[k][j]), _mm256_mul_ps(center_y, frustum_planes_y[k][j])),
+						_mm256_add_ps(_mm256_mul_ps(center_z, frustum_planes_z[k][j]), frustum_planes_d[k][j]));
+					__m256 extent_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extent_x, abs_planes_x[k][j]), _mm256_mul_ps(extent_y, abs_planes_y[k][j])),
+						_mm256_mul_ps(extent_z, abs_planes_z[k][j]));
+					__m256 distance_to_plane = _mm256_add_ps(center_distance, extent_distance);
+					intersection_res = _mm256_or_ps(intersection_res, _mm256_cmp_ps(distance_to_plane, zero, _CMP_LE_OQ));
+				}
+				words[k] |= uint32_t(~_mm256_movemask_ps(intersection_res) & 0xff) << bit;
+			}
+		}
+
+		for (k = 0; k < num_views; k++)
+			visibility[k][word_first / VISIBILITY_WORD_BITS] = words[k];
+	}
+}
@@ -0,0 +1,532 @@
+//avx512 culling kernels, 16 objects per step
+//this file is compiled with avx512f enabled (see CMakeLists.txt), kernels are called only if cpu supports them (see set_simd_level)
+//NOTE: don't call not inlined functions from headers here (mathlib constructors etc), linker may pick their avx512 version for sse code
+
+#include "Culling.h"
+#include <immintrin.h>
+
+
+//transpose 4x4 floats in each 128 bit lane, same as _MM_TRANSPOSE4_PS
+static __forceinline void avx512_transpose4_ps(__m512 &row0, __m512 &row1, __m512 &row2, __m512 &row3)
+{
+	__m512 tmp0 = _mm512_unpacklo_ps(row0, row1);
+	__m512 tmp1 = _mm512_unpacklo_ps(row2, row3);
+	__m512 tmp2 = _mm512_unpackhi_ps(row0, row1);
+	__m512 tmp3 = _mm512_unpackhi_ps(row2, row3);
+	row0 = _mm512_shuffle_ps(tmp0, tmp1, _MM_SHUFFLE(1, 0, 1, 0));
+	row1 = _mm512_shuffle_ps(tmp0, tmp1, _MM_SHUFFLE(3, 2, 3, 2));
+	row2 = _mm512_shuffle_ps(tmp2, tmp3, _MM_SHUFFLE(1, 0, 1, 0));
+	row3 = _mm512_shuffle_ps(tmp2, tmp3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+//context planes are already splatted to 4 lanes, 128 bit broadcast fills all lanes
+static __forceinline void avx512_splat_planes(const CullingContext &ctx, __m512 *planes_x, __m512 *planes_y, __m512 *planes_z, __m512 *planes_d)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		planes_x[i] = _mm512_broadcast_f32x4(ctx.planes_x[i]);
+		planes_y[i] = _mm512_broadcast_f32x4(ctx.planes_y[i]);
+		planes_z[i] = _mm512_broadcast_f32x4(ctx.planes_z[i]);
+		planes_d[i] = _mm512_broadcast_f32x4(ctx.planes_w[i]);
+	}
+}
+
+//abs of plane normals, center & extent tests
+static __forceinline void avx512_splat_abs_planes(const CullingContext &ctx, __m512 *abs_planes_x, __m512 *abs_planes_y, __m512 *abs_planes_z)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		abs_planes_x[i] = _mm512_broadcast_f32x4(ctx.abs_planes_x[i]);
+		abs_planes_y[i] = _mm512_broadcast_f32x4(ctx.abs_planes_y[i]);
+		abs_planes_z[i] = _mm512_broadcast_f32x4(ctx.abs_planes_z[i]);
+	}
+}
+
+//reorder mask bits to objects order: res[obj] = mask[order[obj]]
+//bits are expanded to ints, permuted & packed back
+static __forceinline uint32_t avx512_reorder_mask(__mmask16 mask, __m512i order)
+{
+	__m512i res = _mm512_maskz_mov_epi32(mask, _mm512_set1_epi32(-1));
+	res = _mm512_permutexvar_epi32(order, res);
+	return _mm512_test_epi32_mask(res, res);
+}
+
+
+void avx512_culling_spheres(BSphere *sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	float *sphere_data_ptr = reinterpret_cast<float*>(&sphere_data[0]);
+
+	__m512 frustum_planes_x[6];
+	__m512 frustum_planes_y[6];
+	__m512 frustum_planes_z[6];
+	__m512 frustum_planes_d[6];
+	avx512_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	//after in-lane transpose element k of lane j belongs to sphere 4k+j
+	const __m512i result_order = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	__m512 zero_v = _mm512_setzero_ps();
+	int i, j;
+
+	//we process 16 objects per step
+	for (i = 0; i < num_objects; i += 16)
+	{
+		__m512 spheres_pos_x = _mm512_loadu_ps(sphere_data_ptr);
+		__m512 spheres_pos_y = _mm512_loadu_ps(sphere_data_ptr + 16);
+		__m512 spheres_pos_z = _mm512_loadu_ps(sphere_data_ptr + 32);
+		__m512 spheres_radius = _mm512_loadu_ps(sphere_data_ptr + 48);
+		sphere_data_ptr += 64;
+
+		avx512_transpose4_ps(spheres_pos_x, spheres_pos_y, spheres_pos_z, spheres_radius);
+
+		__m512 spheres_neg_radius = _mm512_sub_ps(zero_v, spheres_radius);
+		__mmask16 intersection_res = 0;
+
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//distance to plane = dot(sphere_pos.xyz, plane.xyz) + plane.w
+			__m512 distance_to_plane = _mm512_fmadd_ps(spheres_pos_x, frustum_planes_x[j],
+				_mm512_fmadd_ps(spheres_pos_y, frustum_planes_y[j],
+				_mm512_fmadd_ps(spheres_pos_z, frustum_planes_z[j], frustum_planes_d[j])));
+
+			//dist < -sphere_r ? if yes - sphere behind the plane & outside frustum
+			intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, spheres_neg_radius, _CMP_LE_OQ);
+		}
+
+		visible.add(~avx512_reorder_mask(intersection_res, result_order) & 0xffff, 16);
+	}
+	visible.flush();
+}
+
+
+void avx512_culling_aabb(AABB *aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	float *aabb_data_ptr = reinterpret_cast<float*>(&aabb_data[0]);
+
+	__m512 frustum_planes_x[6];
+	__m512 frustum_planes_y[6];
+	__m512 frustum_planes_z[6];
+	__m512 frustum_planes_d[6];
+	avx512_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	int vertex_x[6], vertex_y[6], vertex_z[6];
+	get_positive_vertices(ctx.plane_octants, vertex_x, vertex_y, vertex_z);
+	VisibilityWriter visible(visibility);
+
+	//lanes of min/max registers hold objects 0,2,4,6 | 1,3,5,7 | 8,10,12,14 | 9,11,13,15
+	const __m512i result_order = _mm512_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+	__m512 zero = _mm512_setzero_ps();
+	int i, j;
+
+	//we process 16 objects per step
+	for (i = 0; i < num_objects; i += 16)
+	{
+		//one register = 2 aabbs: min0 max0 min1 max1
+		__m512 a_x = _mm512_loadu_ps(aabb_data_ptr);
+		__m512 a_y = _mm512_loadu_ps(aabb_data_ptr + 16);
+		__m512 a_z = _mm512_loadu_ps(aabb_data_ptr + 32);
+		__m512 a_w = _mm512_loadu_ps(aabb_data_ptr + 48);
+
+		__m512 b_x = _mm512_loadu_ps(aabb_data_ptr + 64);
+		__m512 b_y = _mm512_loadu_ps(aabb_data_ptr + 80);
+		__m512 b_z = _mm512_loadu_ps(aabb_data_ptr + 96);
+		__m512 b_w = _mm512_loadu_ps(aabb_data_ptr + 112);
+		aabb_data_ptr += 128;
+
+		//after transpose: a_x = min.x 0,2,4,6 | max.x 0,2,4,6 | min.x 1,3,5,7 | max.x 1,3,5,7, b_x - the same for objects 8..15
+		avx512_transpose4_ps(a_x, a_y, a_z, a_w);
+		avx512_transpose4_ps(b_x, b_y, b_z, b_w);
+
+		__m512 aabb_min_x = _mm512_shuffle_f32x4(a_x, b_x, _MM_SHUFFLE(2, 0, 2, 0));
+		__m512 aabb_min_y = _mm512_shuffle_f32x4(a_y, b_y, _MM_SHUFFLE(2, 0, 2, 0));
+		__m512 aabb_min_z = _mm512_shuffle_f32x4(a_z, b_z, _MM_SHUFFLE(2, 0, 2, 0));
+		__m512 aabb_max_x = _mm512_shuffle_f32x4(a_x, b_x, _MM_SHUFFLE(3, 1, 3, 1));
+		__m512 aabb_max_y = _mm512_shuffle_f32x4(a_y, b_y, _MM_SHUFFLE(3, 1, 3, 1));
+		__m512 aabb_max_z = _mm512_shuffle_f32x4(a_z, b_z, _MM_SHUFFLE(3, 1, 3, 1));
+		__m512 box[6] = { aabb_min_x, aabb_min_y, aabb_min_z, aabb_max_x, aabb_max_y, aabb_max_z };
+
+		__mmask16 intersection_res = 0;
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//positive vertex (box corner farthest along plane normal) behind the plane - object outside frustum
+			__m512 res_x = _mm512_mul_ps(box[vertex_x[j]], frustum_planes_x[j]);
+			__m512 res_y = _mm512_mul_ps(box[vertex_y[j]], frustum_planes_y[j]);
+			__m512 res_z = _mm512_mul_ps(box[vertex_z[j]], frustum_planes_z[j]);
+
+			__m512 distance_to_plane = _mm512_add_ps(_mm512_add_ps(res_x, res_y), _mm512_add_ps(res_z, frustum_planes_d[j]));
+
+			intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, zero, _CMP_LE_OQ); //dist from positive vertex to plane < 0 ?
+		}
+
+		visible.add(~avx512_reorder_mask(intersection_res, result_order) & 0xffff, 16);
+	}
+	visible.flush();
+}
+
+
+void avx512_culling_obb(const AffineTransform *transforms, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	//camera matrix columns in all lanes
+	__m512 cam_col0 = _mm512_broadcast_f32x4(ctx.sse_view_proj.col0);
+	__m512 cam_col1 = _mm512_broadcast_f32x4(ctx.sse_view_proj.col1);
+	__m512 cam_col2 = _mm512_broadcast_f32x4(ctx.sse_view_proj.col2);
+	__m512 cam_col3 = _mm512_broadcast_f32x4(ctx.sse_view_proj.col3);
+
+	//box points coordinates are known, so instead of transforming 8 points with shuffles we scale clip matrix columns by min/max coordinates
+	__m512 box_min_x = _mm512_set1_ps(box_min.x), box_max_x = _mm512_set1_ps(box_max.x);
+	__m512 box_min_y = _mm512_set1_ps(box_min.y), box_max_y = _mm512_set1_ps(box_max.y);
+	__m512 box_min_z = _mm512_set1_ps(box_min.z), box_max_z = _mm512_set1_ps(box_max.z);
+
+	VisibilityWriter visible(visibility);
+	__m512 zero_v = _mm512_setzero_ps();
+	int i, j;
+
+	//process 4 objects per step, one object per lane
+	for (i = 0; i < num_objects; i += 4)
+	{
+		//obj_rows[k] = row k of all 4 transforms, one per 128 bit lane
+		const AffineTransform *t = &transforms[i];
+		__m512 obj_rows[3];
+		for (j = 0; j < 3; j++)
+		{
+			__m512 row = _mm512_castps128_ps512(_mm_load_ps(t[0].rows[j]));
+			row = _mm512_insertf32x4(row, _mm_load_ps(t[1].rows[j]), 1);
+			row = _mm512_insertf32x4(row, _mm_load_ps(t[2].rows[j]), 2);
+			obj_rows[j] = _mm512_insertf32x4(row, _mm_load_ps(t[3].rows[j]), 3);
+		}
+
+		//clip space matrix = camera_view_proj * obj_mat, obj_mat bottom row is (0, 0, 0, 1)
+		__m512 clip_cols[4] = {
+			_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[0], 0x00), cam_col0,
+				_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[1], 0x00), cam_col1, _mm512_mul_ps(_mm512_permute_ps(obj_rows[2], 0x00), cam_col2))),
+			_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[0], 0x55), cam_col0,
+				_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[1], 0x55), cam_col1, _mm512_mul_ps(_mm512_permute_ps(obj_rows[2], 0x55), cam_col2))),
+			_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[0], 0xaa), cam_col0,
+				_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[1], 0xaa), cam_col1, _mm512_mul_ps(_mm512_permute_ps(obj_rows[2], 0xaa), cam_col2))),
+			_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[0], 0xff), cam_col0,
+				_mm512_fmadd_ps(_mm512_permute_ps(obj_rows[1], 0xff), cam_col1, _mm512_fmadd_ps(_mm512_permute_ps(obj_rows[2], 0xff), cam_col2, cam_col3)))
+		};
+
+		__m512 x_min = _mm512_mul_ps(clip_cols[0], box_min_x), x_max = _mm512_mul_ps(clip_cols[0], box_max_x);
+		__m512 y_min = _mm512_mul_ps(clip_cols[1], box_min_y), y_max = _mm512_mul_ps(clip_cols[1], box_max_y);
+		__m512 z_min = _mm512_fmadd_ps(clip_cols[2], box_min_z, clip_cols[3]), z_max = _mm512_fmadd_ps(clip_cols[2], box_max_z, clip_cols[3]);
+
+		//all 8 box points in clip space
+		__m512 xy[4] = { _mm512_add_ps(x_min, y_min), _mm512_add_ps(x_min, y_max), _mm512_add_ps(x_max, y_min), _mm512_add_ps(x_max, y_max) };
+
+		//initially assume that planes are separating
+		__mmask16 outside_positive_plane = 0xffff;
+		__mmask16 outside_negative_plane = 0xffff;
+
+		for (j = 0; j < 8; j++)
+		{
+			__m512 obb_transformed_point = _mm512_add_ps(xy[j >> 1], (j & 1) ? z_max : z_min);
+
+			__m512 wwww = _mm512_permute_ps(obb_transformed_point, 0xff);
+			__m512 wwww_neg = _mm512_sub_ps(zero_v, wwww);
+
+			//box_point.xyz > box_point.w || box_point.xyz < -box_point.w ?
+			outside_positive_plane &= _mm512_cmp_ps_mask(obb_transformed_point, wwww, _CMP_GE_OQ);
+			outside_negative_plane &= _mm512_cmp_ps_mask(obb_transformed_point, wwww_neg, _CMP_LE_OQ);
+		}
+
+		//if any of 3 axes is separating - object outside frustum
+		int outside = outside_positive_plane | outside_negative_plane;
+		uint32_t visible_bits = 0;
+		for (j = 0; j < 4; j++)
+			visible_bits |= uint32_t(((outside >> (j * 4)) & 0x7) == 0) << j;
+		visible.add(visible_bits, 4);
+	}
+	visible.flush();
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------SoA
+//components of 16 objects are loaded directly, so mask bits are already in objects order
+void avx512_culling_spheres_soa(const SpheresSoA &sphere_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	__m512 frustum_planes_x[6];
+	__m512 frustum_planes_y[6];
+	__m512 frustum_planes_z[6];
+	__m512 frustum_planes_d[6];
+	avx512_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	__m512 zero_v = _mm512_setzero_ps();
+	int i, j;
+
+	//we process 16 objects per step
+	for (i = 0; i < num_objects; i += 16)
+	{
+		__m512 spheres_pos_x = _mm512_load_ps(&sphere_data.pos_x[i]);
+		__m512 spheres_pos_y = _mm512_load_ps(&sphere_data.pos_y[i]);
+		__m512 spheres_pos_z = _mm512_load_ps(&sphere_data.pos_z[i]);
+		__m512 spheres_neg_radius = _mm512_sub_ps(zero_v, _mm512_load_ps(&sphere_data.radius[i]));
+
+		__mmask16 intersection_res = 0;
+		for (j = 0; j < 6; j++) //plane index
+		{
+			__m512 distance_to_plane = _mm512_fmadd_ps(spheres_pos_x, frustum_planes_x[j],
+				_mm512_fmadd_ps(spheres_pos_y, frustum_planes_y[j],
+				_mm512_fmadd_ps(spheres_pos_z, frustum_planes_z[j], frustum_planes_d[j])));
+
+			intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, spheres_neg_radius, _CMP_LE_OQ); //dist < -sphere_r ?
+		}
+
+		visible.add(~uint32_t(intersection_res) & 0xffff, 16);
+	}
+	visible.flush();
+}
+
+
+void avx512_culling_aabb_soa(const AABBSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	__m512 frustum_planes_x[6];
+	__m512 frustum_planes_y[6];
+	__m512 frustum_planes_z[6];
+	__m512 frustum_planes_d[6];
+	avx512_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	const float *vertex_x[6], *vertex_y[6], *vertex_z[6];
+	get_positive_vertices(aabb_data, ctx.plane_octants, vertex_x, vertex_y, vertex_z);
+	VisibilityWriter visible(visibility);
+
+	__m512 zero = _mm512_setzero_ps();
+	int i, j;
+
+	//we process 16 objects per step
+	for (i = 0; i < num_objects; i += 16)
+	{
+		__mmask16 intersection_res = 0;
+		for (j = 0; j < 6; j++) //plane index
+		{
+			__m512 res_x = _mm512_mul_ps(_mm512_load_ps(&vertex_x[j][i]), frustum_planes_x[j]);
+			__m512 res_y = _mm512_mul_ps(_mm512_load_ps(&vertex_y[j][i]), frustum_planes_y[j]);
+			__m512 res_z = _mm512_mul_ps(_mm512_load_ps(&vertex_z[j][i]), frustum_planes_z[j]);
+
+			__m512 distance_to_plane = _mm512_add_ps(_mm512_add_ps(res_x, res_y), _mm512_add_ps(res_z, frustum_planes_d[j]));
+
+			intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, zero, _CMP_LE_OQ); //dist from positive vertex to plane < 0 ?
+		}
+
+		visible.add(~uint32_t(intersection_res) & 0xffff, 16);
+	}
+	visible.flush();
+}
+
+
+void avx512_culling_aabb_center_extent(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t *visibility, const CullingContext &ctx)
+{
+	__m512 frustum_planes_x[6];
+	__m512 frustum_planes_y[6];
+	__m512 frustum_planes_z[6];
+	__m512 frustum_planes_d[6];
+	avx512_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	__m512 abs_planes_x[6];
+	__m512 abs_planes_y[6];
+	__m512 abs_planes_z[6];
+	avx512_splat_abs_planes(ctx, abs_planes_x, abs_planes_y, abs_planes_z);
+	int i, j;
+
+	__m512 zero = _mm512_setzero_ps();
+
+	//we process 16 objects per step
+	for (i = 0; i < num_objects; i += 16)
+	{
+		__m512 center_x = _mm512_load_ps(&aabb_data.center_x[i]);
+		__m512 center_y = _mm512_load_ps(&aabb_data.center_y[i]);
+		__m512 center_z = _mm512_load_ps(&aabb_data.center_z[i]);
+		__m512 extent_x = _mm512_load_ps(&aabb_data.extent_x[i]);
+		__m512 extent_y = _mm512_load_ps(&aabb_data.extent_y[i]);
+		__m512 extent_z = _mm512_load_ps(&aabb_data.extent_z[i]);
+
+		__mmask16 intersection_res = 0;
+		for (j = 0; j < 6; j++) //plane index
+		{
+			__m512 center_distance = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(center_x, frustum_planes_x[j]), _mm512_mul_ps(center_y, frustum_planes_y[j])),
+				_mm512_add_ps(_mm512_mul_ps(center_z, frustum_planes_z[j]), frustum_planes_d[j]));
+			__m512 extent_distance = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(extent_x, abs_planes_x[j]), _mm512_mul_ps(extent_y, abs_planes_y[j])), _mm512_mul_ps(extent_z, abs_planes_z[j]));
+			__m512 distance_to_plane = _mm512_add_ps(center_distance, extent_distance);
+
+			intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, zero, _CMP_LE_OQ); //center dist + projected radius < 0 ?
+		}
+
+		visible.add(~uint32_t(intersection_res) & 0xffff, 16);
+	}
+	visible.flush();
+}
+
+
+void avx512_culling_obb_soa(const OBBSoA &obb_data, int num_objects, uint32_t *visibility, const vec3 &box_min, const vec3 &box_max, const CullingContext &ctx)
+{
+	__m512 frustum_planes_x[6];
+	__m512 frustum_planes_y[6];
+	__m512 frustum_planes_z[6];
+	__m512 frustum_planes_d[6];
+	avx512_splat_planes(ctx, frustum_planes_x, frustum_planes_y, frustum_planes_z, frustum_planes_d);
+	VisibilityWriter visible(visibility);
+
+	//local box is the same for all objects
+	__m512 local_center_x = _mm512_set1_ps((box_min.x + box_max.x) * 0.5f);
+	__m512 local_center_y = _mm512_set1_ps((box_min.y + box_max.y) * 0.5f);
+	__m512 local_center_z = _mm512_set1_ps((box_min.z + box_max.z) * 0.5f);
+	__m512 half_size_x = _mm512_set1_ps((box_max.x - box_min.x) * 0.5f);
+	__m512 half_size_y = _mm512_set1_ps((box_max.y - box_min.y) * 0.5f);
+	__m512 half_size_z = _mm512_set1_ps((box_max.z - box_min.z) * 0.5f);
+
+	__m512 zero = _mm512_setzero_ps();
+	int i, j;
+
+	//we process 16 objects per step
+	for (i = 0; i < num_objects; i += 16)
+	{
+		//box axes scaled by box half size
+		__m512 axis0_x = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[0][i]), half_size_x);
+		__m512 axis0_y = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[1][i]), half_size_x);
+		__m512 axis0_z = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[2][i]), half_size_x);
+		__m512 axis1_x = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[3][i]), half_size_y);
+		__m512 axis1_y = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[4][i]), half_size_y);
+		__m512 axis1_z = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[5][i]), half_size_y);
+		__m512 axis2_x = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[6][i]), half_size_z);
+		__m512 axis2_y = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[7][i]), half_size_z);
+		__m512 axis2_z = _mm512_mul_ps(_mm512_load_ps(&obb_data.m[8][i]), half_size_z);
+
+		//world space box center = obj_mat * local center
+		__m512 center_x = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_load_ps(&obb_data.m[0][i]), local_center_x), _mm512_mul_ps(_mm512_load_ps(&obb_data.m[3][i]), local_center_y)),
+			_mm512_add_ps(_mm512_mul_ps(_mm512_load_ps(&obb_data.m[6][i]), local_center_z), _mm512_load_ps(&obb_data.m[9][i])));
+		__m512 center_y = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_load_ps(&obb_data.m[1][i]), local_center_x), _mm512_mul_ps(_mm512_load_ps(&obb_data.m[4][i]), local_center_y)),
+			_mm512_add_ps(_mm512_mul_ps(_mm512_load_ps(&obb_data.m[7][i]), local_center_z), _mm512_load_ps(&obb_data.m[10][i])));
+		__m512 center_z = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_load_ps(&obb_data.m[2][i]), local_center_x), _mm512_mul_ps(_mm512_load_ps(&obb_data.m[5][i]), local_center_y)),
+			_mm512_add_ps(_mm512_mul_ps(_mm512_load_ps(&obb_data.m[8][i]), local_center_z), _mm512_load_ps(&obb_data.m[11][i])));
+
+		__mmask16 intersection_res = 0;
+		for (j = 0; j < 6; j++) //plane index
+		{
+			//box reaches sum of abs projections of its scaled axes on plane normal from its center
+			__m512 proj0 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(axis0_x, frustum_planes_x[j]), _mm512_mul_ps(axis0_y, frustum_planes_y[j])), _mm512_mul_ps(axis0_z, frustum_planes_z[j]));
+			__m512 proj1 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(axis1_x, frustum_planes_x[j]), _mm512_mul_ps(axis1_y, frustum_planes_y[j])), _mm512_mul_ps(axis1_z, frustum_planes_z[j]));
+			__m512 proj2 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(axis2_x, frustum_planes_x[j]), _mm512_mul_ps(axis2_y, frustum_planes_y[j])), _mm512_mul_ps(axis2_z, frustum_planes_z[j]));
+			__m512 box_radius = _mm512_add_ps(_mm512_add_ps(_mm512_abs_ps(proj0), _mm512_abs_ps(proj1)), _mm512_abs_ps(proj2));
+
+			__m512 center_distance = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(center_x, frustum_planes_x[j]), _mm512_mul_ps(center_y, frustum_planes_y[j])),
+				_mm512_add_ps(_mm512_mul_ps(center_z, frustum_planes_z[j]), frustum_planes_d[j]));
+			__m512 distance_to_plane = _mm512_add_ps(center_distance, box_radius);
+
+			intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, zero, _CMP_LE_OQ); //center dist + projected radius < 0 ?
+		}
+
+		visible.add(~uint32_t(intersection_res) & 0xffff, 16);
+	}
+	visible.flush();
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------multiview
+//the same tests as single view kernels, planes of all views are splatted once & bounds are loaded once for all views
+void avx512_culling_spheres_soa_multiview(const SpheresSoA &sphere_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views)
+{
+	if (num_views <= 0 || num_views > MAX_CULLING_VIEWS)
+		return;
+
+	__m512 zero_v = _mm512_setzero_ps();
+	uint32_t words[MAX_CULLING_VIEWS];
+	__m512 frustum_planes_x[MAX_CULLING_VIEWS][6];
+	__m512 frustum_planes_y[MAX_CULLING_VIEWS][6];
+	__m512 frustum_planes_z[MAX_CULLING_VIEWS][6];
+	__m512 frustum_planes_d[MAX_CULLING_VIEWS][6];
+	int i, j, k, word_first;
+	for (k = 0; k < num_views; k++)
+		avx512_splat_planes(views[k], frustum_planes_x[k], frustum_planes_y[k], frustum_planes_z[k], frustum_planes_d[k]);
+	for (word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_objects = num_objects - word_first < VISIBILITY_WORD_BITS ? num_objects - word_first : VISIBILITY_WORD_BITS;
+		for (k = 0; k < num_views; k++)
+			words[k] = 0;
+
+		//we process 16 objects per step
+		for (int bit = 0; bit < word_objects; bit += 16)
+		{
+			i = word_first + bit;
+			__m512 spheres_pos_x = _mm512_load_ps(&sphere_data.pos_x[i]);
+			__m512 spheres_pos_y = _mm512_load_ps(&sphere_data.pos_y[i]);
+			__m512 spheres_pos_z = _mm512_load_ps(&sphere_data.pos_z[i]);
+			__m512 spheres_neg_radius = _mm512_sub_ps(zero_v, _mm512_load_ps(&sphere_data.radius[i]));
+
+			for (k = 0; k < num_views; k++)
+			{
+				__mmask16 intersection_res = 0;
+				for (j = 0; j < 6; j++) //plane index
+				{
+					__m512 distance_to_plane = _mm512_fmadd_ps(spheres_pos_x, frustum_planes_x[k][j],
+						_mm512_fmadd_ps(spheres_pos_y, frustum_planes_y[k][j],
+						_mm512_fmadd_ps(spheres_pos_z, frustum_planes_z[k][j], frustum_planes_d[k][j])));
+					intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, spheres_neg_radius, _CMP_LE_OQ);
+				}
+				words[k] |= (~uint32_t(intersection_res) & 0xffff) << bit;
+			}
+		}
+
+		for (k = 0; k < num_views; k++)
+			visibility[k][word_first / VISIBILITY_WORD_BITS] = words[k];
+	}
+}
+
+
+void avx512_culling_aabb_center_extent_multiview(const AABBCenterExtentSoA &aabb_data, int num_objects, uint32_t * const *visibility, const CullingContext *views, int num_views)
+{
+	if (num_views <= 0 || num_views > MAX_CULLING_VIEWS)
+		return;
+
+	__m512 zero = _mm512_setzero_ps();
+	uint32_t words[MAX_CULLING_VIEWS];
+	__m512 frustum_planes_x[MAX_CULLING_VIEWS][6];
+	__m512 frustum_planes_y[MAX_CULLING_VIEWS][6];
+	__m512 frustum_planes_z[MAX_CULLING_VIEWS][6];
+	__m512 frustum_planes_d[MAX_CULLING_VIEWS][6];
+	int i, j, k, word_first;
+	__m512 abs_planes_x[MAX_CULLING_VIEWS][6];
+	__m512 abs_planes_y[MAX_CULLING_VIEWS][6];
+	__m512 abs_planes_z[MAX_CULLING_VIEWS][6];
+	for (k = 0; k < num_views; k++)
+	{
+		avx512_splat_planes(views[k], frustum_planes_x[k], frustum_planes_y[k], frustum_planes_z[k], frustum_planes_d[k]);
+		avx512_splat_abs_planes(views[k], abs_planes_x[k], abs_planes_y[k], abs_planes_z[k]);
+	}
+
+	for (word_first = 0; word_first < num_objects; word_first += VISIBILITY_WORD_BITS)
+	{
+		int word_objects = num_objects - word_first < VISIBILITY_WORD_BITS ? num_objects - word_first : VISIBILITY_WORD_BITS;
+		for (k = 0; k < num_views; k++)
+			words[k] = 0;
+
+		//we process 16 objects per step
+		for (int bit = 0; bit < word_objects; bit += 16)
+		{
+			i = word_first + bit;
+			__m512 center_x = _mm512_load_ps(&aabb_data.center_x[i]);
+			__m512 center_y = _mm512_load_ps(&aabb_data.center_y[i]);
+			__m512 center_z = _mm512_load_ps(&aabb_data.center_z[i]);
+			__m512 extent_x = _mm512_load_ps(&aabb_data.extent_x[i]);
+			__m512 extent_y = _mm512_load_ps(&aabb_data.extent_y[i]);
+			__m512 extent_z = _mm512_load_ps(&aabb_data.extent_z[i]);
+
+			for (k = 0; k < num_views; k++)
+			{
+				__mmask16 intersection_res = 0;
+				for (j = 0; j < 6; j++) //plane index
+				{
+					__m512 center_distance = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(center_x, frustum_planes_x[k][j]), _mm512_mul_ps(center_y, frustum_planes_y[k][j])),
+						_mm512_add_ps(_mm512_mul_ps(center_z, frustum_planes_z[k][j]), frustum_planes_d[k][j]));
+					__m512 extent_distance = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(extent_x, abs_planes_x[k][j]), _mm512_mul_ps(extent_y, abs_planes_y[k][j])),
+						_mm512_mul_ps(extent_z, abs_planes_z[k][j]));
+					__m512 distance_to_plane = _mm512_add_ps(center_distance, extent_distance);
+					intersection_res |= _mm512_cmp_ps_mask(distance_to_plane, zero, _CMP_LE_OQ);
+				}
+				words[k] |= (~uint32_t(intersection_res) & 0xffff) << bit;
+			}
+		}
+
+		for (k = 0; k < num_views; k++)
+			visibility[k][word_first / VISIBILITY_WORD_BITS] = words[k];
+	}
+}
@@ -0,0 +1,374 @@
+#include "OcclusionCulling.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+
+//corners of box: bit 0 - x, bit 1 - y, bit 2 - z of max corner
+static const int box_indices[36] =
+{
+	0, 2, 6, 0, 6, 4, //-x
+	1, 5, 7, 1, 7, 3, //+x
+	0, 4, 5, 0, 5, 1, //-y
+	2, 3, 7, 2, 7, 6, //+y
+	0, 1, 3, 0, 3, 2, //-z
+	4, 6, 7, 4, 7, 5  //+z
+};
+
+static __forceinline float sse_horizontal_min(__m128 v)
+{
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+static __forceinline float sse_horizontal_max(__m128 v)
+{
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+
+OcclusionCulling::OcclusionCulling() : width(0), height(0), tiles_x(0), tiles_y(0), depth(NULL), hiz(NULL), pixels_per_unit(0.f)
+{
+}
+
+OcclusionCulling::~OcclusionCulling()
+{
+	clear();
+}
+
+void OcclusionCulling::init(int in_width, int in_height)
+{
+	clear();
+	if (in_width <= 0 || in_height <= 0)
+		return;
+
+	tiles_x = (in_width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH;
+	tiles_y = (in_height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+	width = tiles_x * OCCLUSION_TILE_WIDTH;
+	height = tiles_y * OCCLUSION_TILE_HEIGHT;
+	depth = new_sse<float>(tiles_x * tiles_y * OCCLUSION_TILE_PIXELS);
+	hiz = new_sse<float>(tiles_x * tiles_y);
+	memset(&depth[0], 0, sizeof(float) * tiles_x * tiles_y * OCCLUSION_TILE_PIXELS);
+	memset(&hiz[0], 0, sizeof(float) * tiles_x * tiles_y);
+}
+
+void OcclusionCulling::clear()
+{
+	if (depth) { delete_sse(depth); depth = NULL; }
+	if (hiz) { delete_sse(hiz); hiz = NULL; }
+	width = height = 0;
+	tiles_x = tiles_y = 0;
+	candidates.clear();
+	projected_vertices.clear();
+}
+
+void OcclusionCulling::begin_frame(const CullingContext &ctx)
+{
+	if (!depth)
+		return;
+
+	view_proj = ctx.view_proj;
+	const float *m = view_proj.mat;
+	pixels_per_unit = 0.5f * float(height) * sqrtf(m[1] * m[1] + m[5] * m[5] + m[9] * m[9]); //view rotation keeps length of projection y row
+	memset(&depth[0], 0, sizeof(float) * tiles_x * tiles_y * OCCLUSION_TILE_PIXELS);
+	memset(&hiz[0], 0, sizeof(float) * tiles_x * tiles_y);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------occluders
+int OcclusionCulling::select_occluders(const AABBCenterExtentSoA &boxes, int num_objects, const uint32_t *visibility, int max_occluders, float min_size, int *occluders)
+{
+	if (max_occluders <= 0)
+		return 0;
+
+	const float *m = view_proj.mat;
+	candidates.clear();
+	int num_words = visibility_words(num_objects);
+	for (int i = 0; i < num_words; i++)
+	{
+		uint32_t word = visibility[i];
+		while (word)
+		{
+			int object = i * VISIBILITY_WORD_BITS + count_trailing_zeros(word);
+			word &= word - 1;
+			if (object >= num_objects)
+				break;
+
+			float w = m[3] * boxes.center_x[object] + m[7] * boxes.center_y[object] + m[11] * boxes.center_z[object] + m[15];
+			if (w < OCCLUSION_MIN_W)
+				continue;
+			float ex = boxes.extent_x[object], ey = boxes.extent_y[object], ez = boxes.extent_z[object];
+			if (2.f * sqrtf(ex * ex + ey * ey + ez * ez) * pixels_per_unit >= min_size * w)
+				candidates.push_back(std::make_pair(w, object));
+		}
+	}
+
+	//the nearest ones
+	int num_occluders = std::min(int(candidates.size()), max_occluders);
+	if (int(candidates.size()) > max_occluders)
+		std::nth_element(candidates.begin(), candidates.begin() + max_occluders, candidates.end());
+	for (int i = 0; i < num_occluders; i++)
+		occluders[i] = candidates[i].second;
+	return num_occluders;
+}
+
+void OcclusionCulling::add_occluder(const vec3 &center, const vec3 &extent)
+{
+	vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+		corners[i] = vec3((i & 1) ? center.x + extent.x : center.x - extent.x, (i & 2) ? center.y + extent.y : center.y - extent.y,
+			(i & 4) ? center.z + extent.z : center.z - extent.z);
+	add_occluder_triangles(corners, 8, box_indices, 12);
+}
+
+void OcclusionCulling::add_occluder_triangles(const vec3 *vertices, int num_vertices, const int *indices, int num_triangles)
+{
+	if (!depth || num_vertices <= 0)
+		return;
+
+	//screen x, y, 1/w & w, vertices behind the camera plane keep only w, their triangles are skipped
+	const float *m = view_proj.mat;
+	projected_vertices.resize(num_vertices);
+	int i;
+	for (i = 0; i < num_vertices; i++)
+	{
+		const vec3 &v = vertices[i];
+		float x = m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12];
+		float y = m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13];
+		float w = m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15];
+		vec4 &p = projected_vertices[i];
+		p.w = w;
+		if (w < OCCLUSION_MIN_W)
+			continue;
+		float rhw = 1.f / w;
+		p.x = (x * rhw * 0.5f + 0.5f) * float(width);
+		p.y = (y * rhw * 0.5f + 0.5f) * float(height);
+		p.z = rhw;
+	}
+
+	for (i = 0; i < num_triangles; i++)
+		rasterize_triangle(projected_vertices[indices[i * 3 + 0]], projected_vertices[indices[i * 3 + 1]], projected_vertices[indices[i * 3 + 2]]);
+}
+
+//edge functions are evaluated for 4 pixels at once, pixel is covered if all 3 edge functions are not negative at its farthest corner.
+//depth is plane of 1/w shifted to the farthest value over the pixel
+void OcclusionCulling::rasterize_triangle(const vec4 &v0, const vec4 &v1, const vec4 &v2)
+{
+	//it only makes occlusion weaker
+	if (v0.w < OCCLUSION_MIN_W || v1.w < OCCLUSION_MIN_W || v2.w < OCCLUSION_MIN_W)
+		return;
+	const float guard_min = -OCCLUSION_GUARD_BAND, guard_max_x = float(width) + OCCLUSION_GUARD_BAND, guard_max_y = float(height) + OCCLUSION_GUARD_BAND;
+	if (v0.x < guard_min || v1.x < guard_min || v2.x < guard_min || v0.x > guard_max_x || v1.x > guard_max_x || v2.x > guard_max_x ||
+		v0.y < guard_min || v1.y < guard_min || v2.y < guard_min || v0.y > guard_max_y || v1.y > guard_max_y || v2.y > guard_max_y)
+		return;
+
+	//double area, triangles smaller than pixel can't cover any pixel fully
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (fabsf(area) < 2.f)
+		return;
+	const vec4 *p[3] = { &v0, area > 0.f ? &v1 : &v2, area > 0.f ? &v2 : &v1 }; //counter clockwise
+	area = fabsf(area);
+
+	//edge i is opposite to vertex i, it's positive inside
+	float a[3], b[3], c[3];
+	int i;
+	for (i = 0; i < 3; i++)
+	{
+		const vec4 &from = *p[(i + 1) % 3];
+		const vec4 &to = *p[(i + 2) % 3];
+		a[i] = from.y - to.y;
+		b[i] = to.x - from.x;
+		c[i] = -(a[i] * from.x + b[i] * from.y) - 0.5f * (fabsf(a[i]) + fabsf(b[i]));
+	}
+	float inv_area = 1.f / area;
+	float za = (a[0] * p[0]->z + a[1] * p[1]->z + a[2] * p[2]->z) * inv_area;
+	float zb = (b[0] * p[0]->z + b[1] * p[1]->z + b[2] * p[2]->z) * inv_area;
+	float zc = ((c[0] + 0.5f * (fabsf(a[0]) + fabsf(b[0]))) * p[0]->z + (c[1] + 0.5f * (fabsf(a[1]) + fabsf(b[1]))) * p[1]->z +
+		(c[2] + 0.5f * (fabsf(a[2]) + fabsf(b[2]))) * p[2]->z) * inv_area - 0.5f * (fabsf(za) + fabsf(zb));
+
+	//pixels which may be covered
+	float min_x = std::min(v0.x, std::min(v1.x, v2.x)), max_x = std::max(v0.x, std::max(v1.x, v2.x));
+	float min_y = std::min(v0.y, std::min(v1.y, v2.y)), max_y = std::max(v0.y, std::max(v1.y, v2.y));
+	int x0 = std::max(int(floorf(min_x)), 0), x1 = std::min(int(ceilf(max_x)) - 1, width - 1);
+	int y0 = std::max(int(floorf(min_y)), 0), y1 = std::min(int(ceilf(max_y)) - 1, height - 1);
+	if (x0 > x1 || y0 > y1)
+		return;
+
+	__m128 a_v[3], zero = _mm_setzero_ps();
+	for (i = 0; i < 3; i++)
+		a_v[i] = _mm_set1_ps(a[i]);
+	__m128 za_v = _mm_set1_ps(za);
+	__m128 pixel_centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	for (int ty = y0 / OCCLUSION_TILE_HEIGHT; ty <= y1 / OCCLUSION_TILE_HEIGHT; ty++)
+		for (int tx = x0 / OCCLUSION_TILE_WIDTH; tx <= x1 / OCCLUSION_TILE_WIDTH; tx++)
+		{
+			//edge function is linear, its maximum over tile pixels is at one of tile corners
+			float tile_x0 = float(tx * OCCLUSION_TILE_WIDTH) + 0.5f, tile_x1 = tile_x0 + float(OCCLUSION_TILE_WIDTH - 1);
+			float tile_y0 = float(ty * OCCLUSION_TILE_HEIGHT) + 0.5f, tile_y1 = tile_y0 + float(OCCLUSION_TILE_HEIGHT - 1);
+			for (i = 0; i < 3; i++)
+				if (std::max(a[i] * tile_x0, a[i] * tile_x1) + std::max(b[i] * tile_y0, b[i] * tile_y1) + c[i] < 0.f)
+					break;
+			if (i < 3)
+				continue;
+
+			float *tile = &depth[(ty * tiles_x + tx) * OCCLUSION_TILE_PIXELS];
+			__m128 x_lo = _mm_add_ps(_mm_set1_ps(float(tx * OCCLUSION_TILE_WIDTH)), pixel_centers);
+			__m128 x_hi = _mm_add_ps(x_lo, _mm_set1_ps(4.f));
+			for (int row = 0; row < OCCLUSION_TILE_HEIGHT; row++)
+			{
+				float y = float(ty * OCCLUSION_TILE_HEIGHT + row) + 0.5f;
+				__m128 e_row[3];
+				for (i = 0; i < 3; i++)
+					e_row[i] = _mm_set1_ps(b[i] * y + c[i]);
+				__m128 z_row = _mm_set1_ps(zb * y + zc);
+
+				for (int half = 0; half < 2; half++)
+				{
+					__m128 x = half ? x_hi : x_lo;
+					__m128 inside = _mm_and_ps(_mm_and_ps(
+						_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a_v[0], x), e_row[0]), zero),
+						_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a_v[1], x), e_row[1]), zero)),
+						_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a_v[2], x), e_row[2]), zero));
+					__m128 z = _mm_add_ps(_mm_mul_ps(za_v, x), z_row);
+
+					//depth is never negative, so pixels outside get nothing from max
+					float *dest = &tile[row * OCCLUSION_TILE_WIDTH + half * 4];
+					_mm_store_ps(dest, _mm_max_ps(_mm_load_ps(dest), _mm_and_ps(inside, z)));
+				}
+			}
+		}
+}
+
+void OcclusionCulling::update_hiz()
+{
+	if (!depth)
+		return;
+
+	for (int t = 0; t < tiles_x * tiles_y; t++)
+	{
+		const float *tile = &depth[t * OCCLUSION_TILE_PIXELS];
+		__m128 farthest = _mm_load_ps(&tile[0]);
+		for (int i = 4; i < OCCLUSION_TILE_PIXELS; i += 4)
+			farthest = _mm_min_ps(farthest, _mm_load_ps(&tile[i]));
+		hiz[t] = sse_horizontal_min(farthest);
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------tests
+//8 corners are projected at once, box is visible if any pixel its screen rect touches is not closer than its nearest corner
+bool OcclusionCulling::is_box_visible(const vec3 &center, const vec3 &extent) const
+{
+	if (!depth)
+		return true;
+
+	const float *m = view_proj.mat;
+	__m128 corners_x = _mm_add_ps(_mm_set1_ps(center.x), _mm_mul_ps(_mm_set1_ps(extent.x), _mm_setr_ps(-1.f, 1.f, -1.f, 1.f)));
+	__m128 corners_y = _mm_add_ps(_mm_set1_ps(center.y), _mm_mul_ps(_mm_set1_ps(extent.y), _mm_setr_ps(-1.f, -1.f, 1.f, 1.f)));
+	__m128 clip_x[2], clip_y[2], clip_w[2];
+	for (int i = 0; i < 2; i++)
+	{
+		__m128 corners_z = _mm_set1_ps(i ? center.z + extent.z : center.z - extent.z);
+		clip_x[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(corners_x, _mm_set1_ps(m[0])), _mm_mul_ps(corners_y, _mm_set1_ps(m[4]))),
+			_mm_add_ps(_mm_mul_ps(corners_z, _mm_set1_ps(m[8])), _mm_set1_ps(m[12])));
+		clip_y[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(corners_x, _mm_set1_ps(m[1])), _mm_mul_ps(corners_y, _mm_set1_ps(m[5]))),
+			_mm_add_ps(_mm_mul_ps(corners_z, _mm_set1_ps(m[9])), _mm_set1_ps(m[13])));
+		clip_w[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(corners_x, _mm_set1_ps(m[3])), _mm_mul_ps(corners_y, _mm_set1_ps(m[7]))),
+			_mm_add_ps(_mm_mul_ps(corners_z, _mm_set1_ps(m[11])), _mm_set1_ps(m[15])));
+	}
+
+	//box which crosses the camera plane covers the whole screen
+	float min_w = sse_horizontal_min(_mm_min_ps(clip_w[0], clip_w[1]));
+	if (min_w < OCCLUSION_MIN_W)
+		return true;
+	float box_depth = 1.f / min_w;
+
+	__m128 half_width = _mm_set1_ps(0.5f * float(width)), half_height = _mm_set1_ps(0.5f * float(height));
+	__m128 screen_x[2], screen_y[2];
+	for (int i = 0; i < 2; i++)
+	{
+		__m128 rhw = _mm_div_ps(_mm_set1_ps(1.f), clip_w[i]);
+		screen_x[i] = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip_x[i], rhw), half_width), half_width);
+		screen_y[i] = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip_y[i], rhw), half_height), half_height);
+	}
+
+	//pixels which rect touches
+	int x0 = std::max(int(floorf(sse_horizontal_min(_mm_min_ps(screen_x[0], screen_x[1])))), 0);
+	int x1 = std::min(int(floorf(sse_horizontal_max(_mm_max_ps(screen_x[0], screen_x[1])))), width - 1);
+	int y0 = std::max(int(floorf(sse_horizontal_min(_mm_min_ps(screen_y[0], screen_y[1])))), 0);
+	int y1 = std::min(int(floorf(sse_horizontal_max(_mm_max_ps(screen_y[0], screen_y[1])))), height - 1);
+	if (x0 > x1 || y0 > y1)
+		return true; //outside the screen, frustum culling decides
+
+	__m128 box_depth_v = _mm_set1_ps(box_depth);
+	__m128 rect_x0 = _mm_set1_ps(float(x0)), rect_x1 = _mm_set1_ps(float(x1));
+	__m128 pixel_offsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+	for (int ty = y0 / OCCLUSION_TILE_HEIGHT; ty <= y1 / OCCLUSION_TILE_HEIGHT; ty++)
+		for (int tx = x0 / OCCLUSION_TILE_WIDTH; tx <= x1 / OCCLUSION_TILE_WIDTH; tx++)
+		{
+			int t = ty * tiles_x + tx;
+			if (hiz[t] > box_depth)
+				continue; //the farthest occluder of the tile is closer than box
+
+			//columns of the rect in tile
+			__m128 x_lo = _mm_add_ps(_mm_set1_ps(float(tx * OCCLUSION_TILE_WIDTH)), pixel_offsets);
+			__m128 x_hi = _mm_add_ps(x_lo, _mm_set1_ps(4.f));
+			__m128 columns_lo = _mm_and_ps(_mm_cmpge_ps(x_lo, rect_x0), _mm_cmple_ps(x_lo, rect_x1));
+			__m128 columns_hi = _mm_and_ps(_mm_cmpge_ps(x_hi, rect_x0), _mm_cmple_ps(x_hi, rect_x1));
+
+			const float *tile = &depth[t * OCCLUSION_TILE_PIXELS];
+			int row0 = std::max(y0 - ty * OCCLUSION_TILE_HEIGHT, 0);
+			int row1 = std::min(y1 - ty * OCCLUSION_TILE_HEIGHT, OCCLUSION_TILE_HEIGHT - 1);
+			__m128 not_occluded = _mm_setzero_ps();
+			for (int row = row0; row <= row1; row++)
+			{
+				const float *row_depth = &tile[row * OCCLUSION_TILE_WIDTH];
+				not_occluded = _mm_or_ps(not_occluded, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(&row_depth[0]), box_depth_v), columns_lo));
+				not_occluded = _mm_or_ps(not_occluded, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(&row_depth[4]), box_depth_v), columns_hi));
+			}
+			if (_mm_movemask_ps(not_occluded))
+				return true;
+		}
+	return false;
+}
+
+int OcclusionCulling::cull(const AABBCenterExtentSoA &boxes, int num_objects, uint32_t *visibility) const
+{
+	int num_occluded = 0;
+	int num_words = visibility_words(num_objects);
+	for (int i = 0; i < num_words; i++)
+	{
+		uint32_t word = visibility[i];
+		uint32_t bits = word;
+		while (bits)
+		{
+			int bit = count_trailing_zeros(bits);
+			bits &= bits - 1;
+			int object = i * VISIBILITY_WORD_BITS + bit;
+			if (object >= num_objects)
+				break;
+
+			vec3 center = vec3(boxes.center_x[object], boxes.center_y[object], boxes.center_z[object]);
+			vec3 extent = vec3(boxes.extent_x[object], boxes.extent_y[object], boxes.extent_z[object]);
+			if (!is_box_visible(center, extent))
+			{
+				word &= ~(1u << bit);
+				num_occluded++;
+			}
+		}
+		visibility[i] = word;
+	}
+	return num_occluded;
+}
+
+float OcclusionCulling::get_depth(int x, int y) const
+{
+	if (!depth || x < 0 || y < 0 || x >= width || y >= height)
+		return 0.f;
+	const float *tile = &depth[((y / OCCLUSION_TILE_HEIGHT) * tiles_x + x / OCCLUSION_TILE_WIDTH) * OCCLUSION_TILE_PIXELS];
+	return tile[(y % OCCLUSION_TILE_HEIGHT) * OCCLUSION_TILE_WIDTH + x % OCCLUSION_TILE_WIDTH];
+}
@@ -0,0 +1,67 @@
+#ifndef _OCCLUSION_CULLING_H
+#define _OCCLUSION_CULLING_H
+
+#include "Culling.h"
+#include <vector>
+
+//software occlusion culling, runs after frustum culling: chosen occluders are rasterized to small depth buffer on cpu,
+//objects which passed frustum culling are tested against it & removed if they are fully behind occluders.
+//depth is 1/w (bigger - closer), it's linear in screen space, so triangles depth is a plane & no near/far range is needed.
+//buffer is split to tiles of OCCLUSION_TILE_WIDTH x OCCLUSION_TILE_HEIGHT pixels stored one after another, row of tile is 2 sse registers.
+//hi-z keeps the farthest depth of every tile, most boxes are accepted or rejected by it without reading pixels.
+//
+//results are conservative: occluders cover only pixels which are fully inside their triangles with the farthest depth over the pixel,
+//boxes are tested with their nearest depth over all pixels their screen rect touches. Triangles which cross w = OCCLUSION_MIN_W are skipped
+
+const int OCCLUSION_TILE_WIDTH = 8;
+const int OCCLUSION_TILE_HEIGHT = 4;
+const int OCCLUSION_TILE_PIXELS = OCCLUSION_TILE_WIDTH * OCCLUSION_TILE_HEIGHT;
+const float OCCLUSION_MIN_W = 1e-3f; //occluder triangles & boxes closer to the camera plane are not projected
+const float OCCLUSION_GUARD_BAND = 4096.f; //occluder triangles which go farther from the screen in pixels are skipped, edge functions lose precision
+
+class OcclusionCulling
+{
+public:
+	OcclusionCulling();
+	~OcclusionCulling();
+
+	void init(int width, int height); //depth buffer resolution, rounded up to whole tiles
+	void clear();
+
+	//clears depth buffer, occluders & boxes are projected by view projection matrix of ctx
+	void begin_frame(const CullingContext &ctx);
+
+	//picks up to max_occluders visible boxes nearest to the camera which are not smaller than min_size pixels on screen.
+	//returns number of picked boxes, their indices are written to occluders
+	int select_occluders(const AABBCenterExtentSoA &boxes, int num_objects, const uint32_t *visibility, int max_occluders, float min_size, int *occluders);
+
+	void add_occluder(const vec3 &center, const vec3 &extent); //box, 12 triangles
+	void add_occluder_triangles(const vec3 *vertices, int num_vertices, const int *indices, int num_triangles);
+	void update_hiz(); //after all occluders of the frame are added
+
+	//clears visibility bits of visible objects which are occluded, returns their number.
+	//boxes & visibility point to the first object as for kernels
+	int cull(const AABBCenterExtentSoA &boxes, int num_objects, uint32_t *visibility) const;
+	bool is_box_visible(const vec3 &center, const vec3 &extent) const;
+
+	int get_width() const { return width; }
+	int get_height() const { return height; }
+	float get_depth(int x, int y) const; //1/w, 0 - no occluders
+
+private:
+	void rasterize_triangle(const vec4 &v0, const vec4 &v1, const vec4 &v2); //projected vertices
+
+	int width;
+	int height;
+	int tiles_x;
+	int tiles_y;
+	float *depth; //tiles_x * tiles_y tiles, OCCLUSION_TILE_PIXELS each, rows of tile go one after another
+	float *hiz; //the farthest depth of tile
+
+	mat4 view_proj;
+	float pixels_per_unit; //screen size of unit length at w = 1, for occluders selection
+	std::vector<std::pair<float, int> > candidates; //occluders selection, w & object
+	std::vector<vec4> projected_vertices; //of occluder: screen x, y, 1/w & w
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "UniformGrid.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+
+UniformGrid::UniformGrid() : num_objects(0), cells_x(0), cells_z(0), num_cells(0)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		cell_arrays[i] = NULL;
+		object_arrays[i] = NULL;
+	}
+}
+
+UniformGrid::~UniformGrid()
+{
+	clear();
+}
+
+void UniformGrid::clear()
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (cell_arrays[i])
+		{
+			delete_sse(cell_arrays[i]);
+			cell_arrays[i] = NULL;
+		}
+		if (object_arrays[i])
+		{
+			delete_sse(object_arrays[i]);
+			object_arrays[i] = NULL;
+		}
+	}
+
+	num_objects = 0;
+	cells_x = 0;
+	cells_z = 0;
+	num_cells = 0;
+	cell_first_object.clear();
+	object_indices.clear();
+	object_positions.clear();
+	object_cells.clear();
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------build
+void UniformGrid::build(const AABB *aabbs, int in_num_objects, int objects_per_cell)
+{
+	clear();
+	if (!aabbs || in_num_objects <= 0)
+		return;
+	num_objects = in_num_objects;
+	if (objects_per_cell < 1)
+		objects_per_cell = 1;
+
+	//grid covers centers of objects
+	int i;
+	float center_min[2] = { FLT_MAX, FLT_MAX };
+	float center_max[2] = { -FLT_MAX, -FLT_MAX };
+	for (i = 0; i < num_objects; i++)
+	{
+		float x = (aabbs[i].box_min.x + aabbs[i].box_max.x) * 0.5f;
+		float z = (aabbs[i].box_min.z + aabbs[i].box_max.z) * 0.5f;
+		center_min[0] = std::min(center_min[0], x); center_max[0] = std::max(center_max[0], x);
+		center_min[1] = std::min(center_min[1], z); center_max[1] = std::max(center_max[1], z);
+	}
+	float size_x = std::max(center_max[0] - center_min[0], 1e-3f);
+	float size_z = std::max(center_max[1] - center_min[1], 1e-3f);
+
+	//cells_x / cells_z follows area proportions
+	int target_cells = std::max(1, num_objects / objects_per_cell);
+	cells_x = std::max(1, std::min(target_cells, int(sqrtf(float(target_cells) * size_x / size_z) + 0.5f)));
+	cells_z = std::max(1, target_cells / cells_x);
+	num_cells = cells_x * cells_z;
+	float inv_cell_x = float(cells_x) / size_x;
+	float inv_cell_z = float(cells_z) / size_z;
+
+	//counting sort of objects by cell
+	object_cells.resize(num_objects);
+	cell_first_object.assign(num_cells + 1, 0);
+	for (i = 0; i < num_objects; i++)
+	{
+		float x = (aabbs[i].box_min.x + aabbs[i].box_max.x) * 0.5f;
+		float z = (aabbs[i].box_min.z + aabbs[i].box_max.z) * 0.5f;
+		int cx = std::min(cells_x - 1, std::max(0, int((x - center_min[0]) * inv_cell_x)));
+		int cz = std::min(cells_z - 1, std::max(0, int((z - center_min[1]) * inv_cell_z)));
+		object_cells[i] = cz * cells_x + cx;
+		cell_first_object[object_cells[i] + 1]++;
+	}
+	for (i = 0; i < num_cells; i++)
+		cell_first_object[i + 1] += cell_first_object[i];
+
+	object_indices.resize(num_objects);
+	object_positions.resize(num_objects);
+	std::vector<int> cell_fill(cell_first_object.begin(), cell_first_object.end() - 1);
+	for (i = 0; i < num_objects; i++)
+	{
+		int pos = cell_fill[object_cells[i]]++;
+		object_indices[pos] = i;
+		object_positions[i] = pos;
+	}
+
+	//objects bounds in cell order, padding objects are never counted as visible
+	int padded_objects = num_objects + 4;
+	int padded_cells = num_cells + 4;
+	for (i = 0; i < 6; i++)
+	{
+		object_arrays[i] = new_sse<float>(padded_objects);
+		memset(&object_arrays[i][0], 0, sizeof(float) * padded_objects);
+		cell_arrays[i] = new_sse<float>(padded_cells);
+		memset(&cell_arrays[i][0], 0, sizeof(float) * padded_cells);
+	}
+	for (i = 0; i < num_objects; i++)
+	{
+		const AABB &box = aabbs[object_indices[i]];
+		object_arrays[0][i] = box.box_min.x;
+		object_arrays[1][i] = box.box_min.y;
+		object_arrays[2][i] = box.box_min.z;
+		object_arrays[3][i] = box.box_max.x;
+		object_arrays[4][i] = box.box_max.y;
+		object_arrays[5][i] = box.box_max.z;
+	}
+
+	//cells bounds are unions of their objects bounds, empty cells are skipped by culling
+	for (int cell = 0; cell < num_cells; cell++)
+	{
+		int first = cell_first_object[cell];
+		int last = cell_first_object[cell + 1];
+		if (first == last)
+			continue;
+		for (int j = 0; j < 3; j++)
+		{
+			float box_min = FLT_MAX, box_max = -FLT_MAX;
+			for (i = first; i < last; i++)
+			{
+				box_min = std::min(box_min, object_arrays[j][i]);
+				box_max = std::max(box_max, object_arrays[3 + j][i]);
+			}
+			cell_arrays[j][cell] = box_min;
+			cell_arrays[3 + j][cell] = box_max;
+		}
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------moving objects
+void UniformGrid::update_object(int object, const AABB &aabb)
+{
+	if (object < 0 || object >= num_objects)
+		return;
+
+	int pos = object_positions[object];
+	object_arrays[0][pos] = aabb.box_min.x;
+	object_arrays[1][pos] = aabb.box_min.y;
+	object_arrays[2][pos] = aabb.box_min.z;
+	object_arrays[3][pos] = aabb.box_max.x;
+	object_arrays[4][pos] = aabb.box_max.y;
+	object_arrays[5][pos] = aabb.box_max.z;
+
+	//cell only grows, it's not recalculated from all its objects
+	int cell = object_cells[object];
+	for (int j = 0; j < 3; j++)
+	{
+		cell_arrays[j][cell] = std::min(cell_arrays[j][cell], object_arrays[j][pos]);
+		cell_arrays[3 + j][cell] = std::max(cell_arrays[3 + j][cell], object_arrays[3 + j][pos]);
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------culling
+void UniformGrid::cull(uint32_t *visibility, const CullingContext &ctx) const
+{
+	if (!num_objects)
+		return;
+	memset(&visibility[0], 0, sizeof(uint32_t) * visibility_words(num_objects));
+
+	const int all_planes = (1 << 6) - 1;
+	int straddle[6];
+	for (int cell = 0; cell < num_cells; cell += 4)
+	{
+		int outside = sse_test_boxes(&cell_arrays[0][cell], &cell_arrays[1][cell], &cell_arrays[2][cell], &cell_arrays[3][cell], &cell_arrays[4][cell], &cell_arrays[5][cell],
+			ctx, all_planes, straddle);
+
+		int num = num_cells - cell < 4 ? num_cells - cell : 4;
+		int not_outside = ~outside & ((1 << num) - 1);
+		while (not_outside)
+		{
+			int i = count_trailing_zeros(not_outside);
+			not_outside &= not_outside - 1;
+
+			int first = cell_first_object[cell + i];
+			int count = cell_first_object[cell + i + 1] - first;
+			if (!count)
+				continue;
+
+			int plane_mask = box_plane_mask(straddle, i);
+			if (!plane_mask)
+				accept_indexed_objects(visibility, &object_indices[0], first, count);
+			else
+				cull_indexed_objects(visibility, &object_indices[0], object_arrays, ctx, plane_mask, first, count);
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef _UNIFORM_GRID_H
+#define _UNIFORM_GRID_H
+
+#include <vector>
+#include "Culling.h"
+
+//uniform grid over objects aabbs, made for flat scenes: cells split xz plane, every cell spans y range of its objects
+//object is stored in the cell of its aabb center, cell bounds are union of its objects bounds, so cells are loose - objects may stick out of
+//cell rectangle, but cell bounds always contain them. Culling tests cells by 4 with the same sse code as BVH does: fully inside cell accepts
+//its objects without per-object tests, outside cell rejects them, objects of intersected cells are tested only against planes which cell crosses.
+//results are exactly the same as aabb kernels give.
+//
+//build is a counting sort by cell, much cheaper than BVH one, but culling tests every cell - good for uniform density scenes.
+//update_object() keeps object in its cell & grows cell bounds, results stay correct, but cells become bigger when objects move far,
+//build() should be called again then
+
+const int GRID_DEFAULT_OBJECTS_PER_CELL = 32;
+
+class UniformGrid
+{
+public:
+	UniformGrid();
+	~UniformGrid();
+
+	//number of cells is about num_objects / objects_per_cell, cells are square-ish in xz plane
+	void build(const AABB *aabbs, int num_objects, int objects_per_cell = GRID_DEFAULT_OBJECTS_PER_CELL);
+	void clear();
+
+	//sets bits of visible objects, indices are the same as in aabbs array passed to build. visibility should have visibility_words(num_objects) words
+	void cull(uint32_t *visibility, const CullingContext &ctx) const;
+
+	//moving objects, should not be called during culling
+	void update_object(int object, const AABB &aabb);
+
+	int get_num_objects() const { return num_objects; }
+	int get_num_cells() const { return num_cells; }
+	int get_cells_x() const { return cells_x; }
+	int get_cells_z() const { return cells_z; }
+
+private:
+	int num_objects;
+	int cells_x;
+	int cells_z;
+	int num_cells;
+
+	float *cell_arrays[6]; //cells bounds: min x, y, z, max x, y, z, padded for 4 cells loads
+	std::vector<int> cell_first_object; //num_cells + 1 entries, objects of cell i are [cell_first_object[i], cell_first_object[i + 1]) in cell order
+
+	std::vector<int> object_indices; //cell order -> object index
+	std::vector<int> object_positions; //object index -> cell order
+	std::vector<int> object_cells; //object index -> cell
+	float *object_arrays[6]; //objects bounds in cell order, padded for 4 objects loads
+};
+
+#endif
@@ -1,18 +1,24 @@
-#include <windows.h>
 #include "glext.h"
+#include "../platform/Window.h"
+#include <string.h>
+#include <ctype.h>
 
 
 PFNGLGETPROGRAMIVARBPROC glGetProgramivARB;
 
 //min max
+#ifdef _WIN32 //gl 1.2, 1.3 functions, see glext.h
 PFNGLMINMAXPROC glMinmax;
 PFNGLGETMINMAXPROC glGetMinmax;
+#endif
 
 // stencil
 PFNGLACTIVESTENCILFACEEXTPROC glActiveStencilFaceEXT;
 
 //blend
+#ifdef _WIN32
 PFNGLBLENDEQUATIONPROC glBlendEquation;
+#endif
 PFNGLBLENDFUNCSEPARATEEXTPROC glBlendFuncSeparateEXT;
 
 //clear color
@@ -25,9 +31,9 @@ PFNGLCLEARBUFFERFVPROC glClearBufferfv;
 PFNGLCLEARBUFFERFIPROC glClearBufferfi;
 
 // textures
+#ifdef _WIN32
 PFNGLACTIVETEXTUREARBPROC glActiveTextureARB;
 PFNGLTEXIMAGE3DPROC glTexImage3D;
-PFNGLCOPYTEXSUBIMAGE3DEXTPROC glCopyTexSubImage3DEXT;
 PFNGLCOPYTEXSUBIMAGE3DPROC glCopyTexSubImage3D;
 PFNGLMULTITEXCOORD3FARBPROC	glMultiTexCoord3fARB;
 PFNGLMULTITEXCOORD4FARBPROC	glMultiTexCoord4fARB;
@@ -37,11 +43,14 @@ PFNGLMULTITEXCOORD2FVARBPROC glMultiTexCoord2fvARB;
 PFNGLCLIENTACTIVETEXTUREARBPROC glClientActiveTextureARB;
 PFNGLTEXSUBIMAGE3DPROC glTexSubImage3D;
 PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D;
+#endif
+PFNGLCOPYTEXSUBIMAGE3DEXTPROC glCopyTexSubImage3DEXT;
 PFNGLCOMPRESSEDTEXIMAGE2DARBPROC glCompressedTexImage2DARB;
 PFNGLTEXPARAMETERIIVPROC glTexParameterIiv;
 PFNGLGENERATEMIPMAPPROC glGenerateMipmap;
 
 PFNGLMEMORYBARRIERPROC glMemoryBarrier;
+PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
 PFNGLTEXTUREBARRIERPROC glTextureBarrier;
 
 PFNGLTEXSTORAGE3DPROC glTexStorage3D;
@@ -92,8 +101,10 @@ PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced;
 PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
 PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
 PFNGLDRAWARRAYSINDIRECTPROC glDrawArraysIndirect;
+PFNGLDRAWELEMENTSINDIRECTPROC glDrawElementsIndirect;
 
 PFNGLTEXBUFFERPROC glTexBuffer;
+PFNGLTEXBUFFERRANGEPROC glTexBufferRange;
 //PFNGLPRIMITIVERESTARTINDEXPROC glPrimitiveRestartIndex;
 PFNGLCOPYBUFFERSUBDATAPROC glCopyBufferSubData;
 
@@ -125,7 +136,9 @@ PFNGLBINDBUFFERARBPROC glBindBufferARB;
 PFNGLBUFFERDATAARBPROC glBufferDataARB;
 PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB;
 
+#ifdef _WIN32
 PFNGLDRAWRANGEELEMENTSPROC glDrawRangeElements;
+#endif
 PFNGLMAPBUFFERARBPROC glMapBufferARB;
 PFNGLUNMAPBUFFERARBPROC glUnmapBufferARB;
 
@@ -138,13 +151,21 @@ PFNGLBINDBUFFERPROC glBindBuffer;
 PFNGLDELETEBUFFERSPROC glDeleteBuffers;
 PFNGLGENBUFFERSPROC glGenBuffers;
 PFNGLBUFFERDATAPROC glBufferData;
+PFNGLBUFFERSUBDATAPROC glBufferSubData;
+PFNGLGETBUFFERSUBDATAPROC glGetBufferSubData;
 PFNGLMAPBUFFERPROC glMapBuffer;
 PFNGLUNMAPBUFFERPROC glUnmapBuffer;
 PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+PFNGLBUFFERSTORAGEPROC glBufferStorage;
+
+//sync
+PFNGLFENCESYNCPROC glFenceSync;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+PFNGLDELETESYNCPROC glDeleteSync;
 
 // vertex array
 PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
-PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArray;
+PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
 PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
 //PFNGLISVERTEXARRAYPROC glIsVertexArray;
 
@@ -239,7 +260,9 @@ PFNGLUNIFORMMATRIX2FVPROC glUniformMatrix2fv;
 PFNGLUNIFORMMATRIX3FVPROC glUniformMatrix3fv;
 PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
 
+#ifdef _WIN32
 PFNGLACTIVETEXTUREPROC glActiveTexture;
+#endif
 
 
 //texture sampler
@@ -296,6 +319,7 @@ PFNGLDEBUGMESSAGECALLBACKARBPROC  glDebugMessageCallbackARB;
 PFNGLGETDEBUGMESSAGELOGARBPROC    glGetDebugMessageLogARB;
 
 //wgl
+#ifdef _WIN32
 PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatARB = NULL;
 PFNWGLCREATEPBUFFERARBPROC wglCreatePbufferARB = NULL;
 PFNWGLGETPBUFFERDCARBPROC wglGetPbufferDCARB = NULL;
@@ -307,6 +331,7 @@ PFNWGLRELEASETEXIMAGEARBPROC wglReleaseTexImageARB = NULL;
 PFNWGLGETPIXELFORMATATTRIBIVARBPROC wglGetPixelFormatAttribivARB = NULL;
 PFNWGLSETPBUFFERATTRIBARBPROC wglSetPbufferAttribARB = NULL;
 PFNWGLGETEXTENSIONSSTRINGARBPROC wglGetExtensionsStringARB = NULL;
+#endif
 
 
 //----------------------------------------------------------------------------------------------------------------
@@ -337,12 +362,14 @@ bool    isExtensionSupported ( const char * ext )
     if ( isExtensionSupported ( ext, extensions ) )
 	    return true;
 
+#ifdef _WIN32
 	if ( wglGetExtensionsStringARB != NULL )
 	{
 		const char * wgl_extensions = (const char *) wglGetExtensionsStringARB ( wglGetCurrentDC () );
 	    if ( isExtensionSupported ( ext, wgl_extensions ) )
 		    return true;
 	}
+#endif
 
 	return false;
 }
@@ -351,25 +378,25 @@ bool    isExtensionSupported ( const char * ext )
 
 void glext_init() {
 
-#ifdef _WIN32
-#define GET_PROC_ADDRESS(a,b) b = (a)wglGetProcAddress(#b)
-#else
-#define GET_PROC_ADDRESS(a,b) b = (a)glXGetProcAddressARB((const GLubyte*)#b)
-#endif
+#define GET_PROC_ADDRESS(a,b) b = (a)window_get_proc_address(#b)
 	
 
  	GET_PROC_ADDRESS(PFNGLGETPROGRAMIVARBPROC,glGetProgramivARB);
 
 // min max
+#ifdef _WIN32
 	GET_PROC_ADDRESS(PFNGLMINMAXPROC,glMinmax);
 	GET_PROC_ADDRESS(PFNGLGETMINMAXPROC,glGetMinmax);
+#endif
 
 
 // stencil
 	GET_PROC_ADDRESS(PFNGLACTIVESTENCILFACEEXTPROC,glActiveStencilFaceEXT);
 
 // blend
+#ifdef _WIN32
 	GET_PROC_ADDRESS(PFNGLBLENDEQUATIONPROC,glBlendEquation);
+#endif
 	GET_PROC_ADDRESS(PFNGLBLENDFUNCSEPARATEEXTPROC,glBlendFuncSeparateEXT);
 
 //clear color
@@ -382,9 +409,9 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNGLCLEARBUFFERFIPROC, glClearBufferfi);
 
 // textures
+#ifdef _WIN32
 	GET_PROC_ADDRESS(PFNGLACTIVETEXTUREARBPROC, glActiveTextureARB);
 	GET_PROC_ADDRESS(PFNGLTEXIMAGE3DPROC,glTexImage3D);
-	GET_PROC_ADDRESS(PFNGLCOPYTEXSUBIMAGE3DEXTPROC,glCopyTexSubImage3DEXT);
 	GET_PROC_ADDRESS(PFNGLCOPYTEXSUBIMAGE3DPROC,glCopyTexSubImage3D);
 	GET_PROC_ADDRESS(PFNGLMULTITEXCOORD3FARBPROC,glMultiTexCoord3fARB);
 	GET_PROC_ADDRESS(PFNGLMULTITEXCOORD4FARBPROC,glMultiTexCoord4fARB);
@@ -394,11 +421,14 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNGLCLIENTACTIVETEXTUREARBPROC,glClientActiveTextureARB);
 	GET_PROC_ADDRESS(PFNGLTEXSUBIMAGE3DPROC,glTexSubImage3D);
 	GET_PROC_ADDRESS(PFNGLCOMPRESSEDTEXIMAGE2DPROC,glCompressedTexImage2D);
+#endif
+	GET_PROC_ADDRESS(PFNGLCOPYTEXSUBIMAGE3DEXTPROC,glCopyTexSubImage3DEXT);
 	GET_PROC_ADDRESS(PFNGLCOMPRESSEDTEXIMAGE2DARBPROC,glCompressedTexImage2DARB);
 	GET_PROC_ADDRESS(PFNGLTEXPARAMETERIIVPROC, glTexParameterIiv);
 	GET_PROC_ADDRESS(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap);
 
 	GET_PROC_ADDRESS(PFNGLMEMORYBARRIERPROC, glMemoryBarrier);
+	GET_PROC_ADDRESS(PFNGLDISPATCHCOMPUTEPROC, glDispatchCompute);
 	GET_PROC_ADDRESS(PFNGLTEXTUREBARRIERPROC, glTextureBarrier);
 
 	GET_PROC_ADDRESS(PFNGLTEXSTORAGE3DPROC, glTexStorage3D);
@@ -451,8 +481,10 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced);
 	GET_PROC_ADDRESS(PFNGLMULTIDRAWELEMENTSINDIRECTPROC, glMultiDrawElementsIndirect);
 	GET_PROC_ADDRESS(PFNGLDRAWARRAYSINDIRECTPROC, glDrawArraysIndirect);
+	GET_PROC_ADDRESS(PFNGLDRAWELEMENTSINDIRECTPROC, glDrawElementsIndirect);
 
 	GET_PROC_ADDRESS(PFNGLTEXBUFFERPROC, glTexBuffer);
+	GET_PROC_ADDRESS(PFNGLTEXBUFFERRANGEPROC, glTexBufferRange);
 	//GET_PROC_ADDRESS(PFNGLPRIMITIVERESTARTINDEXPROC, glPrimitiveRestartIndex);
 	GET_PROC_ADDRESS(PFNGLCOPYBUFFERSUBDATAPROC, glCopyBufferSubData);
 
@@ -482,7 +514,9 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNGLBUFFERDATAARBPROC,glBufferDataARB);
 	GET_PROC_ADDRESS(PFNGLDELETEBUFFERSARBPROC,glDeleteBuffersARB);
 
+#ifdef _WIN32
 	GET_PROC_ADDRESS(PFNGLDRAWRANGEELEMENTSPROC,glDrawRangeElements);
+#endif
 	GET_PROC_ADDRESS(PFNGLMAPBUFFERARBPROC,glMapBufferARB);
 	GET_PROC_ADDRESS(PFNGLUNMAPBUFFERARBPROC,glUnmapBufferARB);
 
@@ -495,15 +529,23 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNGLDELETEBUFFERSPROC, glDeleteBuffers);
 	GET_PROC_ADDRESS(PFNGLGENBUFFERSPROC, glGenBuffers);
 	GET_PROC_ADDRESS(PFNGLBUFFERDATAPROC, glBufferData);
+	GET_PROC_ADDRESS(PFNGLBUFFERSUBDATAPROC, glBufferSubData);
+	GET_PROC_ADDRESS(PFNGLGETBUFFERSUBDATAPROC, glGetBufferSubData);
 
 	GET_PROC_ADDRESS(PFNGLMAPBUFFERPROC, glMapBuffer);
 	GET_PROC_ADDRESS(PFNGLUNMAPBUFFERPROC, glUnmapBuffer);
 	GET_PROC_ADDRESS(PFNGLMAPBUFFERRANGEPROC, glMapBufferRange);
+	GET_PROC_ADDRESS(PFNGLBUFFERSTORAGEPROC, glBufferStorage);
+
+//sync
+	GET_PROC_ADDRESS(PFNGLFENCESYNCPROC, glFenceSync);
+	GET_PROC_ADDRESS(PFNGLCLIENTWAITSYNCPROC, glClientWaitSync);
+	GET_PROC_ADDRESS(PFNGLDELETESYNCPROC, glDeleteSync);
 
 
 // vertex array
 	GET_PROC_ADDRESS(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray);
-	GET_PROC_ADDRESS(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArray);
+	GET_PROC_ADDRESS(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays);
 	GET_PROC_ADDRESS(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays);
 
 
@@ -601,7 +643,9 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNGLUNIFORM4FVPROC, glUniform4fv);
 	GET_PROC_ADDRESS(PFNGLUNIFORM4IVPROC, glUniform4iv);
 
+#ifdef _WIN32
 	GET_PROC_ADDRESS(PFNGLACTIVETEXTUREPROC, glActiveTexture);
+#endif
 
 
 //texture sampler
@@ -654,6 +698,7 @@ void glext_init() {
 
 
 //wgl
+#ifdef _WIN32
 	GET_PROC_ADDRESS(PFNWGLCHOOSEPIXELFORMATARBPROC, wglChoosePixelFormatARB);
 	GET_PROC_ADDRESS(PFNWGLCREATEPBUFFERARBPROC, wglCreatePbufferARB);
 	GET_PROC_ADDRESS(PFNWGLGETPBUFFERDCARBPROC, wglGetPbufferDCARB);
@@ -665,6 +710,7 @@ void glext_init() {
 	GET_PROC_ADDRESS(PFNWGLGETPIXELFORMATATTRIBIVARBPROC, wglGetPixelFormatAttribivARB);
 	GET_PROC_ADDRESS(PFNWGLSETPBUFFERATTRIBARBPROC, wglSetPbufferAttribARB);
 	GET_PROC_ADDRESS(PFNWGLGETEXTENSIONSSTRINGARBPROC, wglGetExtensionsStringARB);
+#endif
 
 #undef GET_PROC_ADDRESS
 }
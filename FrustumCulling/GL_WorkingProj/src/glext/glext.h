@@ -7,20 +7,26 @@
 
 #include <GL/gl.h>
 #include <GL/glext.h>
+#ifdef _WIN32
 #include <GL/wglext.h>
+#endif
 
 
 extern PFNGLGETPROGRAMIVARBPROC glGetProgramivARB;
 
 //min max
+#ifdef _WIN32 //opengl32.dll exports only gl 1.1, gl.h of other platforms declares gl 1.2, 1.3 & ARB_multitexture functions
 extern PFNGLMINMAXPROC glMinmax;
 extern PFNGLGETMINMAXPROC glGetMinmax;
+#endif
 
 // stencil
 extern PFNGLACTIVESTENCILFACEEXTPROC glActiveStencilFaceEXT;
 
 //blend
+#ifdef _WIN32
 extern PFNGLBLENDEQUATIONPROC glBlendEquation;
+#endif
 extern PFNGLBLENDFUNCSEPARATEEXTPROC glBlendFuncSeparateEXT;
 
 //clear color
@@ -33,9 +39,9 @@ extern PFNGLCLEARBUFFERFVPROC glClearBufferfv;
 extern PFNGLCLEARBUFFERFIPROC glClearBufferfi;
 
 // textures
+#ifdef _WIN32
 extern PFNGLACTIVETEXTUREARBPROC glActiveTextureARB;
 extern PFNGLTEXIMAGE3DPROC glTexImage3D;
-extern PFNGLCOPYTEXSUBIMAGE3DEXTPROC glCopyTexSubImage3DEXT;
 extern PFNGLCOPYTEXSUBIMAGE3DPROC glCopyTexSubImage3D;
 extern PFNGLMULTITEXCOORD3FARBPROC	glMultiTexCoord3fARB;
 extern PFNGLMULTITEXCOORD4FARBPROC	glMultiTexCoord4fARB;
@@ -45,11 +51,14 @@ extern PFNGLMULTITEXCOORD2FVARBPROC glMultiTexCoord2fvARB;
 extern PFNGLCLIENTACTIVETEXTUREARBPROC glClientActiveTextureARB;
 extern PFNGLTEXSUBIMAGE3DPROC glTexSubImage3D;
 extern PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D;
+#endif
+extern PFNGLCOPYTEXSUBIMAGE3DEXTPROC glCopyTexSubImage3DEXT;
 extern PFNGLCOMPRESSEDTEXIMAGE2DARBPROC glCompressedTexImage2DARB;
 extern PFNGLTEXPARAMETERIIVPROC glTexParameterIiv;
 extern PFNGLGENERATEMIPMAPPROC glGenerateMipmap;
 
 extern PFNGLMEMORYBARRIERPROC glMemoryBarrier;
+extern PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
 extern PFNGLTEXTUREBARRIERPROC glTextureBarrier;
 
 extern PFNGLTEXSTORAGE3DPROC glTexStorage3D;
@@ -100,8 +109,10 @@ extern PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced;
 extern PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
 extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
 extern PFNGLDRAWARRAYSINDIRECTPROC glDrawArraysIndirect;
+extern PFNGLDRAWELEMENTSINDIRECTPROC glDrawElementsIndirect;
 
 extern PFNGLTEXBUFFERPROC glTexBuffer;
+extern PFNGLTEXBUFFERRANGEPROC glTexBufferRange;
 //extern PFNGLPRIMITIVERESTARTINDEXPROC glPrimitiveRestartIndex;
 extern PFNGLCOPYBUFFERSUBDATAPROC glCopyBufferSubData;
 
@@ -132,7 +143,9 @@ extern PFNGLBINDBUFFERARBPROC glBindBufferARB;
 extern PFNGLBUFFERDATAARBPROC glBufferDataARB;
 extern PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB;
 
+#ifdef _WIN32
 extern PFNGLDRAWRANGEELEMENTSPROC glDrawRangeElements;
+#endif
 extern PFNGLMAPBUFFERARBPROC glMapBufferARB;
 extern PFNGLUNMAPBUFFERARBPROC glUnmapBufferARB;
 
@@ -144,13 +157,21 @@ extern PFNGLBINDBUFFERPROC glBindBuffer;
 extern PFNGLDELETEBUFFERSPROC glDeleteBuffers;
 extern PFNGLGENBUFFERSPROC glGenBuffers;
 extern PFNGLBUFFERDATAPROC glBufferData;
+extern PFNGLBUFFERSUBDATAPROC glBufferSubData;
+extern PFNGLGETBUFFERSUBDATAPROC glGetBufferSubData;
 extern PFNGLMAPBUFFERPROC glMapBuffer;
 extern PFNGLUNMAPBUFFERPROC glUnmapBuffer;
 extern PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+extern PFNGLBUFFERSTORAGEPROC glBufferStorage;
+
+//sync
+extern PFNGLFENCESYNCPROC glFenceSync;
+extern PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+extern PFNGLDELETESYNCPROC glDeleteSync;
 
 // vertex array
 extern PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
-extern PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArray;
+extern PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
 extern PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
 //extern PFNGLISVERTEXARRAYPROC glIsVertexArray;
 
@@ -246,7 +267,9 @@ extern PFNGLUNIFORM4FVPROC glUniform4fv;
 extern PFNGLUNIFORM4IVPROC glUniform4iv;
 
 
+#ifdef _WIN32
 extern PFNGLACTIVETEXTUREPROC glActiveTexture;
+#endif
 
 
 //texture sampler
@@ -303,6 +326,7 @@ extern PFNGLDEBUGMESSAGECALLBACKARBPROC  glDebugMessageCallbackARB;
 extern PFNGLGETDEBUGMESSAGELOGARBPROC    glGetDebugMessageLogARB;
 
 //wgl
+#ifdef _WIN32
 extern PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatARB;
 extern PFNWGLCREATEPBUFFERARBPROC wglCreatePbufferARB;
 extern PFNWGLGETPBUFFERDCARBPROC wglGetPbufferDCARB;
@@ -314,12 +338,13 @@ extern PFNWGLRELEASETEXIMAGEARBPROC wglReleaseTexImageARB;
 extern PFNWGLGETPIXELFORMATATTRIBIVARBPROC wglGetPixelFormatAttribivARB;
 extern PFNWGLSETPBUFFERATTRIBARBPROC wglSetPbufferAttribARB;
 extern PFNWGLGETEXTENSIONSSTRINGARBPROC        wglGetExtensionsStringARB;
+#endif
 
 
 
 bool    isExtensionSupported ( const char * ext, const char * extList );
 bool    isExtensionSupported ( const char * ext );
 
-void glext_init();
+void glext_init(); //gl context should be current, functions are taken by window_get_proc_address()
 
 #endif /* __GLEXT_H__ */
@@ -0,0 +1,188 @@
+#include "JobSystem.h"
+#include <new>
+#include "../platform/Platform.h"
+
+
+inline uint64_t pack_range(uint32_t begin, uint32_t end) { return (uint64_t(end) << 32) | begin; }
+inline uint32_t range_begin(uint64_t range) { return uint32_t(range); }
+inline uint32_t range_end(uint64_t range) { return uint32_t(range >> 32); }
+
+
+JobSystem::JobSystem() : num_workers(1), ranges(NULL), job_func(NULL), job_data(NULL), job_num_items(0), job_chunk_size(0), job_num_chunks(0),
+	num_completed_chunks(0), num_active_workers(0), num_stolen_chunks(0), job_generation(0), job_open(false), stop(false)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	shutdown();
+}
+
+void JobSystem::init(int in_num_workers)
+{
+	shutdown();
+
+	num_workers = in_num_workers > 0 ? in_num_workers : int(std::thread::hardware_concurrency());
+	if (num_workers < 1)
+		num_workers = 1;
+
+	ranges = (WorkerRange*)aligned_malloc(sizeof(WorkerRange) * num_workers, 64);
+	for (int i = 0; i < num_workers; i++)
+		new (&ranges[i].range) std::atomic<uint64_t>(0);
+
+	stop = false;
+	job_open = false;
+	for (int i = 1; i < num_workers; i++)
+		threads.push_back(std::thread(&JobSystem::worker_thread, this, i));
+}
+
+void JobSystem::shutdown()
+{
+	if (!threads.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		wake_condition.notify_all();
+		for (size_t i = 0; i < threads.size(); i++)
+			threads[i].join();
+		threads.clear();
+	}
+
+	if (ranges)
+	{
+		aligned_free(ranges);
+		ranges = NULL;
+	}
+	num_workers = 1;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------jobs
+void JobSystem::parallel_for(int num_items, int chunk_size, JobFunc func, void *data)
+{
+	if (num_items <= 0 || !func)
+		return;
+	if (chunk_size <= 0)
+		chunk_size = num_items;
+	int num_chunks = (num_items + chunk_size - 1) / chunk_size;
+
+	num_stolen_chunks = 0;
+
+	//nothing to share, don't wake workers
+	if (num_workers == 1 || num_chunks == 1 || !ranges)
+	{
+		for (int first = 0; first < num_items; first += chunk_size)
+			func(data, first, num_items - first < chunk_size ? num_items - first : chunk_size, 0);
+		return;
+	}
+
+	job_func = func;
+	job_data = data;
+	job_num_items = num_items;
+	job_chunk_size = chunk_size;
+	job_num_chunks = num_chunks;
+	num_completed_chunks = 0;
+
+	//initial equal split of chunks
+	for (int i = 0; i < num_workers; i++)
+	{
+		uint32_t begin = uint32_t(int64_t(num_chunks) * i / num_workers);
+		uint32_t end = uint32_t(int64_t(num_chunks) * (i + 1) / num_workers);
+		ranges[i].range.store(pack_range(begin, end), std::memory_order_relaxed);
+	}
+
+	//wake workers, job data are published by mutex
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job_generation++;
+		job_open = true;
+	}
+	wake_condition.notify_all();
+
+	run_chunks(0);
+
+	//wait chunks taken by other workers
+	while (num_completed_chunks.load(std::memory_order_acquire) < num_chunks)
+		std::this_thread::yield();
+
+	//late workers should not join finished job, joined ones may still look for chunks to steal
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job_open = false;
+	}
+	while (num_active_workers.load(std::memory_order_acquire) > 0)
+		std::this_thread::yield();
+}
+
+void JobSystem::worker_thread(int worker_index)
+{
+	uint32_t done_generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!stop && !(job_open && job_generation != done_generation))
+				wake_condition.wait(lock);
+			if (stop)
+				break;
+			done_generation = job_generation;
+			num_active_workers.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		run_chunks(worker_index);
+		num_active_workers.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void JobSystem::run_chunks(int worker_index)
+{
+	int chunk;
+	while (pop_chunk(worker_index, chunk) || steal_chunk(worker_index, chunk))
+	{
+		int first = chunk * job_chunk_size;
+		int num = job_num_items - first < job_chunk_size ? job_num_items - first : job_chunk_size;
+		job_func(job_data, first, num, worker_index);
+		num_completed_chunks.fetch_add(1, std::memory_order_release);
+	}
+}
+
+bool JobSystem::pop_chunk(int worker_index, int &chunk)
+{
+	std::atomic<uint64_t> &range = ranges[worker_index].range;
+	uint64_t cur = range.load(std::memory_order_acquire);
+	while (range_begin(cur) < range_end(cur))
+	{
+		if (range.compare_exchange_weak(cur, pack_range(range_begin(cur) + 1, range_end(cur)), std::memory_order_acq_rel))
+		{
+			chunk = int(range_begin(cur));
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::steal_chunk(int worker_index, int &chunk)
+{
+	for (int i = 1; i < num_workers; i++)
+	{
+		std::atomic<uint64_t> &victim = ranges[(worker_index + i) % num_workers].range;
+		uint64_t cur = victim.load(std::memory_order_acquire);
+		while (range_begin(cur) < range_end(cur))
+		{
+			//take back half, victim keeps front part which is probably in its cache already
+			uint32_t begin = range_begin(cur), end = range_end(cur);
+			uint32_t mid = begin + (end - begin) / 2;
+			if (victim.compare_exchange_weak(cur, pack_range(begin, mid), std::memory_order_acq_rel))
+			{
+				//own range is empty, so nobody else changes it
+				chunk = int(mid);
+				ranges[worker_index].range.store(pack_range(mid + 1, end), std::memory_order_release);
+				num_stolen_chunks.fetch_add(int(end - mid), std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,72 @@
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+//portable work stealing job system for data parallel jobs, e.g. culling of objects ranges
+//parallel_for splits items into chunks, each worker gets equal contiguous part of chunks & takes them from the front.
+//worker which has no chunks steals back half of other worker's part, so the load stays balanced when chunks cost differs
+//(obb culling, visible objects compaction) or some cores are busy with other work.
+//calling thread works as worker 0, other workers sleep on condition variable (futex on linux) between jobs
+
+//called for each chunk [first_item, first_item + num_items), chunks don't overlap & are the same for equal num_items/chunk_size
+typedef void (*JobFunc)(void *data, int first_item, int num_items, int worker_index);
+
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	//num_workers includes calling thread, 0 - all hardware threads
+	void init(int num_workers = 0);
+	void shutdown();
+
+	//returns when all chunks are done. Should be called from the thread which called init
+	void parallel_for(int num_items, int chunk_size, JobFunc func, void *data);
+
+	int get_num_workers() const { return num_workers; }
+	int get_num_stolen_chunks() const { return num_stolen_chunks.load(); } //in the last parallel_for
+
+private:
+	//chunks range of worker packed to one word: begin in low bits, end in high bits.
+	//owner increments begin, thieves decrease end, both with compare exchange
+	struct WorkerRange
+	{
+		std::atomic<uint64_t> range;
+		char padding[64 - sizeof(uint64_t)]; //ranges of different workers are in different cache lines
+	};
+
+	void worker_thread(int worker_index);
+	void run_chunks(int worker_index);
+	bool pop_chunk(int worker_index, int &chunk);
+	bool steal_chunk(int worker_index, int &chunk);
+
+	int num_workers;
+	std::vector<std::thread> threads;
+	WorkerRange *ranges;
+
+	//current job
+	JobFunc job_func;
+	void *job_data;
+	int job_num_items;
+	int job_chunk_size;
+	int job_num_chunks;
+	std::atomic<int> num_completed_chunks;
+	std::atomic<int> num_active_workers; //workers which took the job & may still touch ranges
+	std::atomic<int> num_stolen_chunks;
+
+	//workers wake up
+	std::mutex mutex;
+	std::condition_variable wake_condition;
+	uint32_t job_generation;
+	bool job_open; //workers may join the job
+	bool stop;
+};
+
+#endif
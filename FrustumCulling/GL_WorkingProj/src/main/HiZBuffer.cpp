@@ -0,0 +1,113 @@
+#include "HiZBuffer.h"
+
+
+HiZBuffer::HiZBuffer() : width(0), height(0), num_levels(0), valid(false), depth_texture(-1), fbo(-1), vao(-1), downsample_program(-1)
+{
+}
+
+HiZBuffer::~HiZBuffer()
+{
+}
+
+void HiZBuffer::init(int in_width, int in_height)
+{
+	clear();
+	if (in_width <= 0 || in_height <= 0)
+		return;
+
+	width = in_width;
+	height = in_height;
+	num_levels = 1;
+	while ((width >> num_levels) > 0 || (height >> num_levels) > 0)
+		num_levels++;
+
+	//depth texture with all mips, they are read only by texelFetch
+	glGenTextures(1, &depth_texture);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+	for (int i = 0; i < num_levels; i++)
+	{
+		int level_width = width >> i, level_height = height >> i;
+		glTexImage2D(GL_TEXTURE_2D, i, GL_DEPTH_COMPONENT32F, level_width > 0 ? level_width : 1, level_height > 0 ? level_height : 1, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	//depth only framebuffer, mips are attached to it one by one
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glGenVertexArrays(1, &vao);
+	downsample_program = init_shader("hiz_vs", "hiz_ps");
+}
+
+void HiZBuffer::clear()
+{
+	if (depth_texture != (GLuint)-1)
+		glDeleteTextures(1, &depth_texture);
+	if (fbo != (GLuint)-1)
+		glDeleteFramebuffers(1, &fbo);
+	if (vao != (GLuint)-1)
+		glDeleteVertexArrays(1, &vao);
+	if (downsample_program != (GLuint)-1)
+		glDeleteProgram(downsample_program);
+	depth_texture = fbo = vao = downsample_program = -1;
+	width = height = num_levels = 0;
+	valid = false;
+}
+
+//every mip is rendered by full screen triangle which reads previous mip, so only previous mip is left in texture levels range while it's attached
+void HiZBuffer::build(const mat4 &frame_view_proj)
+{
+	valid = false;
+	if (!num_levels || downsample_program == (GLuint)-1)
+		return;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+	glUseProgram(downsample_program);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glBindVertexArray(vao);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_ALWAYS);
+	glActiveTexture(GL_TEXTURE0);
+	for (int i = 1; i < num_levels; i++)
+	{
+		int level_width = width >> i, level_height = height >> i;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, i - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, i - 1);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_texture, i);
+		glViewport(0, 0, level_width > 0 ? level_width : 1, level_height > 0 ? level_height : 1);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindVertexArray(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDepthFunc(GL_LESS);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	view_proj = frame_view_proj;
+	valid = true;
+}
+
+void HiZBuffer::bind(int texture_unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + texture_unit);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+}
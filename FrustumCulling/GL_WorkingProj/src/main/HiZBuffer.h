@@ -0,0 +1,43 @@
+#ifndef _HIZ_BUFFER_H
+#define _HIZ_BUFFER_H
+
+#include "Utilities.h"
+#include "../math/mathlib.h"
+
+//hierarchical z buffer for gpu occlusion culling. Depth of the rendered frame is copied to mip 0 of depth texture,
+//every next mip keeps the farthest depth of 2x2 texels of previous one (3 texels at odd borders), so 2x2 texels of some mip cover any screen rect.
+//it's built at the end of the frame, culling shader of the next frame projects boxes by view_proj of that frame & compares their nearest depth with it
+class HiZBuffer
+{
+public:
+	HiZBuffer();
+	~HiZBuffer();
+
+	void init(int in_width, int in_height); //size of the screen depth buffer
+	void clear();
+
+	//copies depth of the bound read framebuffer & builds mips, frame_view_proj - matrix the frame was rendered with
+	void build(const mat4 &frame_view_proj);
+	void invalidate() { valid = false; } //frame wasn't built, culling shader skips the test
+	void bind(int texture_unit) const;
+
+	bool is_valid() const { return valid; }
+	int get_width() const { return width; }
+	int get_height() const { return height; }
+	int get_num_levels() const { return num_levels; }
+
+	mat4 view_proj;
+
+private:
+	int width;
+	int height;
+	int num_levels;
+	bool valid;
+
+	GLuint depth_texture;
+	GLuint fbo;
+	GLuint vao; //empty, full screen triangle is made from vertex ids
+	GLuint downsample_program;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "InstanceUploadRing.h"
+
+
+InstanceUploadRing::InstanceUploadRing() : buffer(-1), mapped_data(NULL), slot_size(0), format(GL_RGBA32F), cur_slot(0), num_waits(0)
+{
+	for (int i = 0; i < UPLOAD_RING_FRAMES; i++)
+		fences[i] = NULL;
+}
+
+InstanceUploadRing::~InstanceUploadRing()
+{
+}
+
+bool InstanceUploadRing::init(int in_slot_size, GLenum in_format)
+{
+	clear();
+	if (in_slot_size <= 0 || !glBufferStorage || !glFenceSync || !glTexBufferRange)
+		return false;
+
+	GLint alignment = 1;
+	glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment < 1)
+		alignment = 1;
+	slot_size = (in_slot_size + alignment - 1) / alignment * alignment;
+	format = in_format;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferStorage(GL_TEXTURE_BUFFER, (GLsizeiptr)slot_size * UPLOAD_RING_FRAMES, NULL, flags);
+	mapped_data = (char*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)slot_size * UPLOAD_RING_FRAMES, flags);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	if (!mapped_data)
+	{
+		clear();
+		return false;
+	}
+	return true;
+}
+
+void InstanceUploadRing::clear()
+{
+	for (int i = 0; i < UPLOAD_RING_FRAMES; i++)
+		if (fences[i])
+		{
+			glDeleteSync(fences[i]);
+			fences[i] = NULL;
+		}
+
+	if (buffer != (GLuint)-1)
+	{
+		if (mapped_data)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+			glUnmapBuffer(GL_TEXTURE_BUFFER);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = -1;
+	mapped_data = NULL;
+	slot_size = 0;
+	cur_slot = 0;
+	num_waits = 0;
+}
+
+void *InstanceUploadRing::begin_frame()
+{
+	if (!mapped_data)
+		return NULL;
+
+	cur_slot = (cur_slot + 1) % UPLOAD_RING_FRAMES;
+	GLsync fence = fences[cur_slot];
+	if (fence)
+	{
+		//gpu is usually done with the slot, then it's just a check
+		GLenum res = glClientWaitSync(fence, 0, 0);
+		if (res == GL_TIMEOUT_EXPIRED)
+		{
+			num_waits++;
+			do
+				res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			while (res == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fences[cur_slot] = NULL;
+	}
+	return mapped_data + (size_t)cur_slot * slot_size;
+}
+
+void InstanceUploadRing::bind_texture_buffer() const
+{
+	glTexBufferRange(GL_TEXTURE_BUFFER, format, buffer, (GLintptr)cur_slot * slot_size, slot_size);
+}
+
+void InstanceUploadRing::end_frame()
+{
+	if (!mapped_data)
+		return;
+
+	//slot may be drawn in several frames if culling is disabled, only the last draw matters
+	if (fences[cur_slot])
+		glDeleteSync(fences[cur_slot]);
+	fences[cur_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
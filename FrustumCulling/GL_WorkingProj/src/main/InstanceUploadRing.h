@@ -0,0 +1,38 @@
+#ifndef _INSTANCE_UPLOAD_RING_H
+#define _INSTANCE_UPLOAD_RING_H
+
+#include "Utilities.h"
+#include "../math/mathlib.h"
+
+//visible instances upload without copies & driver stalls: buffer is persistently & coherently mapped once,
+//it's split to UPLOAD_RING_FRAMES slots, culling writes the next slot while gpu draws from previous ones.
+//fence after the last draw from the slot guards it, so cpu waits only if gpu is more than UPLOAD_RING_FRAMES - 1 frames behind
+const int UPLOAD_RING_FRAMES = 3;
+
+class InstanceUploadRing
+{
+public:
+	InstanceUploadRing();
+	~InstanceUploadRing();
+
+	bool init(int in_slot_size, GLenum in_format); //bytes & texture buffer format, false if persistent mapping isn't supported (gl 4.4)
+	void clear();
+	bool is_initialized() const { return mapped_data != NULL; }
+
+	void *begin_frame(); //the next slot, waits until gpu finished drawing from it
+	void bind_texture_buffer() const; //range of the current slot to texture bound to GL_TEXTURE_BUFFER
+	void end_frame(); //after draw calls which read the current slot
+
+	int get_num_waits() const { return num_waits; } //frames which waited for gpu
+
+private:
+	GLuint buffer;
+	char *mapped_data;
+	int slot_size; //aligned to GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT
+	GLenum format;
+	int cur_slot;
+	GLsync fences[UPLOAD_RING_FRAMES];
+	int num_waits;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "Profiler.h"
+
+
+Profiler::Profiler() : enabled(false), use_gpu_timers(false), num_threads(0), frame_index(0), current_slot(-1), gpu_event_open(false), num_dropped_events(0)
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::init(int in_num_threads, bool gpu_timers)
+{
+	clear();
+	num_threads = in_num_threads < 1 ? 1 : (in_num_threads > MAX_PROFILER_THREADS ? MAX_PROFILER_THREADS : in_num_threads);
+	use_gpu_timers = gpu_timers && glGetQueryObjectui64v != NULL;
+
+	frames.resize(PROFILER_FRAMES);
+	for (int i = 0; i < PROFILER_FRAMES; i++)
+	{
+		frames[i].frame = -1;
+		frames[i].num_gpu_events = 0;
+		frames[i].gpu_pending = false;
+	}
+	cpu_events.resize(PROFILER_FRAMES * num_threads * MAX_PROFILER_CPU_EVENTS);
+	num_cpu_events.assign(PROFILER_FRAMES * num_threads, 0);
+
+	if (use_gpu_timers)
+	{
+		queries.resize(PROFILER_FRAMES * MAX_PROFILER_GPU_EVENTS);
+		glGenQueries((GLsizei)queries.size(), &queries[0]);
+	}
+	enabled = true;
+}
+
+void Profiler::clear()
+{
+	if (!queries.empty())
+		glDeleteQueries((GLsizei)queries.size(), &queries[0]);
+	queries.clear();
+	frames.clear();
+	cpu_events.clear();
+	num_cpu_events.clear();
+
+	enabled = false;
+	use_gpu_timers = false;
+	num_threads = 0;
+	frame_index = 0;
+	current_slot = -1;
+	gpu_event_open = false;
+	num_dropped_events = 0;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------frame
+void Profiler::begin_frame()
+{
+	if (!enabled)
+		return;
+	poll_gpu_results();
+
+	//the oldest frame is replaced, its queries are reused even if results weren't read
+	current_slot = frame_index % PROFILER_FRAMES;
+	ProfilerFrame &frame_data = frames[current_slot];
+	frame_data.frame = frame_index;
+	frame_data.start = GetTimeInSeconds();
+	frame_data.end = frame_data.start;
+	frame_data.label[0] = '\0';
+	frame_data.num_gpu_events = 0;
+	frame_data.gpu_pending = false;
+	for (int i = 0; i < num_threads; i++)
+		num_cpu_events[current_slot * num_threads + i] = 0;
+	frame_index++;
+}
+
+void Profiler::end_frame(const char *label)
+{
+	if (!enabled || current_slot < 0)
+		return;
+
+	ProfilerFrame &frame_data = frames[current_slot];
+	frame_data.end = GetTimeInSeconds();
+	strncpy(frame_data.label, label ? label : "", MAX_PROFILER_LABEL - 1);
+	frame_data.label[MAX_PROFILER_LABEL - 1] = '\0';
+	frame_data.gpu_pending = frame_data.num_gpu_events > 0;
+	current_slot = -1;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------events
+void Profiler::add_cpu_event(const char *name, int thread, double start, double end)
+{
+	if (current_slot < 0 || thread < 0 || thread >= num_threads)
+		return;
+
+	int &num_events = num_cpu_events[current_slot * num_threads + thread];
+	if (num_events == MAX_PROFILER_CPU_EVENTS)
+	{
+		num_dropped_events++;
+		return;
+	}
+	ProfilerCpuEvent &event = cpu_events[(current_slot * num_threads + thread) * MAX_PROFILER_CPU_EVENTS + num_events];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	num_events++;
+}
+
+bool Profiler::begin_gpu_event(const char *name)
+{
+	if (!use_gpu_timers || current_slot < 0 || gpu_event_open)
+		return false;
+
+	ProfilerFrame &frame_data = frames[current_slot];
+	if (frame_data.num_gpu_events == MAX_PROFILER_GPU_EVENTS)
+	{
+		num_dropped_events++;
+		return false;
+	}
+
+	ProfilerGpuEvent &event = frame_data.gpu_events[frame_data.num_gpu_events];
+	event.name = name;
+	event.cpu_start = GetTimeInSeconds();
+	event.elapsed = 0;
+	glBeginQuery(GL_TIME_ELAPSED, queries[current_slot * MAX_PROFILER_GPU_EVENTS + frame_data.num_gpu_events]);
+	gpu_event_open = true;
+	return true;
+}
+
+void Profiler::end_gpu_event()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	frames[current_slot].num_gpu_events++;
+	gpu_event_open = false;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------gpu results
+void Profiler::read_gpu_results(ProfilerFrame &frame_data, int slot)
+{
+	for (int i = 0; i < frame_data.num_gpu_events; i++)
+		glGetQueryObjectui64v(queries[slot * MAX_PROFILER_GPU_EVENTS + i], GL_QUERY_RESULT, &frame_data.gpu_events[i].elapsed);
+	frame_data.gpu_pending = false;
+}
+
+//frames finish in order, so polling stops at the first frame with unfinished last query
+void Profiler::poll_gpu_results()
+{
+	for (int i = 0; i < PROFILER_FRAMES; i++)
+	{
+		int slot = (frame_index + i) % PROFILER_FRAMES; //from the oldest frame
+		ProfilerFrame &frame_data = frames[slot];
+		if (!frame_data.gpu_pending)
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(queries[slot * MAX_PROFILER_GPU_EVENTS + frame_data.num_gpu_events - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+		read_gpu_results(frame_data, slot);
+	}
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------export
+//complete events in microseconds from the oldest frame, pid 0 - cpu threads, pid 1 - gpu
+bool Profiler::write_trace(const char *file_name)
+{
+	if (!enabled)
+		return false;
+
+	FILE *f = fopen(file_name, "w");
+	if (!f)
+	{
+		fprintf(stderr, "can`t open \"%s\" file\n", file_name);
+		return false;
+	}
+
+	//finished frames from the oldest, frame which is recorded now is skipped
+	int oldest_slot = -1;
+	int num_frames = 0;
+	for (int i = 0; i < PROFILER_FRAMES; i++)
+	{
+		int slot = (frame_index + i) % PROFILER_FRAMES;
+		if (frames[slot].frame < 0 || slot == current_slot)
+			continue;
+		if (oldest_slot < 0)
+			oldest_slot = slot;
+		num_frames++;
+	}
+	double base_time = oldest_slot >= 0 ? frames[oldest_slot].start : 0.0;
+
+	fprintf(f, "{\"traceEvents\":[\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"cpu\"}},\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"gpu\"}},\n");
+	fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GL_TIME_ELAPSED\"}},\n");
+	for (int t = 0; t < num_threads; t++)
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}},\n", t, t ? "worker" : "main, worker", t);
+
+	for (int i = 0; i < PROFILER_FRAMES; i++)
+	{
+		int slot = (frame_index + i) % PROFILER_FRAMES;
+		ProfilerFrame &frame_data = frames[slot];
+		if (frame_data.frame < 0 || slot == current_slot)
+			continue;
+		if (frame_data.gpu_pending)
+			read_gpu_results(frame_data, slot);
+
+		fprintf(f, "{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d,\"mode\":\"%s\"}},\n",
+			(frame_data.start - base_time) * 1e6, (frame_data.end - frame_data.start) * 1e6, frame_data.frame, frame_data.label);
+
+		for (int t = 0; t < num_threads; t++)
+		{
+			int num_events = num_cpu_events[slot * num_threads + t];
+			const ProfilerCpuEvent *events = &cpu_events[(slot * num_threads + t) * MAX_PROFILER_CPU_EVENTS];
+			for (int e = 0; e < num_events; e++)
+				fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+					events[e].name, t, (events[e].start - base_time) * 1e6, (events[e].end - events[e].start) * 1e6);
+		}
+
+		for (int e = 0; e < frame_data.num_gpu_events; e++)
+		{
+			const ProfilerGpuEvent &event = frame_data.gpu_events[e];
+			fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}},\n",
+				event.name, (event.cpu_start - base_time) * 1e6, double(event.elapsed) * 1e-3, frame_data.frame);
+		}
+	}
+
+	//the last record without comma
+	fprintf(f, "{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":0,\"args\":{\"dropped\":%d}}\n", num_dropped_events.load());
+	fprintf(f, "]}\n");
+	fclose(f);
+
+	printf("trace: %d frames written to %s\n", num_frames, file_name);
+	return true;
+}
@@ -0,0 +1,124 @@
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <vector>
+#include <atomic>
+#include "Utilities.h"
+#include "../Timer/Timer.h"
+
+//frame profiler: cpu scopes of the main thread & job system workers, gpu scopes measured by GL_TIME_ELAPSED queries.
+//events of the last PROFILER_FRAMES frames are kept in ring buffer & exported to chrome trace json (chrome://tracing, ui.perfetto.dev).
+//cpu scopes nest, scopes of worker are written only by that worker. Gpu scopes don't nest (one GL_TIME_ELAPSED query may be active),
+//inner one is skipped. Gpu results are polled without waiting in the next frames, gpu event is placed at cpu time it was issued.
+//event names should be string literals, only pointers are stored
+const int PROFILER_FRAMES = 32;
+const int MAX_PROFILER_THREADS = 64;
+const int MAX_PROFILER_CPU_EVENTS = 256; //per thread & frame, the rest are dropped
+const int MAX_PROFILER_GPU_EVENTS = 16; //per frame
+const int MAX_PROFILER_LABEL = 32;
+
+struct ProfilerCpuEvent
+{
+	const char *name;
+	double start; //seconds, GetTimeInSeconds()
+	double end;
+};
+
+struct ProfilerGpuEvent
+{
+	const char *name;
+	double cpu_start; //seconds, when query began
+	GLuint64 elapsed; //nanoseconds
+};
+
+struct ProfilerFrame
+{
+	int frame; //-1 - slot wasn't used
+	double start;
+	double end;
+	char label[MAX_PROFILER_LABEL]; //e.g. culling mode
+	int num_gpu_events;
+	bool gpu_pending; //queries results weren't read yet
+	ProfilerGpuEvent gpu_events[MAX_PROFILER_GPU_EVENTS];
+};
+
+class Profiler
+{
+public:
+	Profiler();
+	~Profiler();
+
+	void init(int in_num_threads, bool gpu_timers); //threads - job system workers, main thread is worker 0. Gl context should be current
+	void clear();
+	bool is_enabled() const { return enabled; }
+
+	void begin_frame();
+	void end_frame(const char *label);
+
+	//called by scopes
+	void add_cpu_event(const char *name, int thread, double start, double end);
+	bool begin_gpu_event(const char *name); //false if event isn't measured, end_gpu_event() shouldn't be called then
+	void end_gpu_event();
+
+	//frames of the ring, waits for their gpu results
+	bool write_trace(const char *file_name);
+
+private:
+	void read_gpu_results(ProfilerFrame &frame_data, int slot);
+	void poll_gpu_results();
+
+	bool enabled;
+	bool use_gpu_timers;
+	int num_threads;
+	int frame_index; //next frame
+	int current_slot; //-1 if frame isn't recorded now
+	bool gpu_event_open;
+
+	std::vector<ProfilerFrame> frames;
+	std::vector<ProfilerCpuEvent> cpu_events; //[slot][thread][event]
+	std::vector<int> num_cpu_events; //[slot][thread]
+	std::vector<GLuint> queries; //[slot][event]
+	std::atomic<int> num_dropped_events;
+};
+
+//cpu time of the scope, thread - worker index of job system
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler &in_profiler, const char *in_name, int in_thread = 0) : profiler(in_profiler), name(in_name), thread(in_thread)
+	{
+		start = profiler.is_enabled() ? GetTimeInSeconds() : 0.0;
+	}
+	~ProfileScope()
+	{
+		if (profiler.is_enabled())
+			profiler.add_cpu_event(name, thread, start, GetTimeInSeconds());
+	}
+
+private:
+	Profiler &profiler;
+	const char *name;
+	int thread;
+	double start;
+};
+
+//gpu time of commands issued in the scope, main thread only
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(Profiler &in_profiler, const char *name) : profiler(in_profiler)
+	{
+		measured = profiler.is_enabled() && profiler.begin_gpu_event(name);
+	}
+	~GpuProfileScope()
+	{
+		if (measured)
+			profiler.end_gpu_event();
+	}
+
+private:
+	Profiler &profiler;
+	bool measured;
+};
+
+#endif
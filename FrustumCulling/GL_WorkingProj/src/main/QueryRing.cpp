@@ -0,0 +1,87 @@
+#include "QueryRing.h"
+
+
+QueryRing::QueryRing() : target(0), num_slots(0), first_in_flight(0), num_in_flight(0)
+{
+	reset_stats();
+}
+
+QueryRing::~QueryRing()
+{
+}
+
+void QueryRing::init(GLenum in_target, int in_num_slots)
+{
+	clear();
+	if (in_num_slots <= 0 || in_num_slots > MAX_QUERY_RING_SLOTS)
+		return;
+
+	target = in_target;
+	num_slots = in_num_slots;
+	glGenQueries(num_slots, &queries[0]);
+}
+
+void QueryRing::clear()
+{
+	if (num_slots)
+		glDeleteQueries(num_slots, &queries[0]);
+	num_slots = 0;
+	first_in_flight = 0;
+	num_in_flight = 0;
+	reset_stats();
+}
+
+bool QueryRing::begin(int frame)
+{
+	if (num_in_flight == num_slots)
+	{
+		stats.num_skipped++;
+		return false;
+	}
+
+	int slot = (first_in_flight + num_in_flight) % num_slots;
+	issue_frames[slot] = frame;
+	glBeginQuery(target, queries[slot]);
+	return true;
+}
+
+void QueryRing::end()
+{
+	glEndQuery(target);
+	num_in_flight++;
+}
+
+bool QueryRing::poll(int frame, GLint &result)
+{
+	bool has_result = false;
+	while (num_in_flight > 0)
+	{
+		GLuint query = queries[first_in_flight];
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		glGetQueryObjectiv(query, GL_QUERY_RESULT, &result);
+		has_result = true;
+
+		int latency = frame - issue_frames[first_in_flight];
+		stats.min_latency = stats.num_results ? (latency < stats.min_latency ? latency : stats.min_latency) : latency;
+		stats.max_latency = latency > stats.max_latency ? latency : stats.max_latency;
+		stats.total_latency += latency;
+		stats.num_results++;
+
+		first_in_flight = (first_in_flight + 1) % num_slots;
+		num_in_flight--;
+	}
+	return has_result;
+}
+
+void QueryRing::reset_stats()
+{
+	stats.num_results = 0;
+	stats.num_skipped = 0;
+	stats.min_latency = 0;
+	stats.max_latency = 0;
+	stats.total_latency = 0;
+}
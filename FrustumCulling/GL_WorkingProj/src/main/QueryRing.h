@@ -0,0 +1,50 @@
+#ifndef _QUERY_RING_H
+#define _QUERY_RING_H
+
+#include "Utilities.h"
+
+//ring of gpu queries which are read without stalls: results are polled by GL_QUERY_RESULT_AVAILABLE from the oldest one,
+//queries of one target finish in order, so polling stops at the first unfinished one. When all slots are in flight no query is issued in the frame.
+//latency is counted in frames from issue to the frame result was read in
+const int MAX_QUERY_RING_SLOTS = 8;
+
+struct QueryRingStats
+{
+	int num_results;
+	int num_skipped; //frames without query, all slots were in flight
+	int min_latency;
+	int max_latency;
+	int total_latency;
+
+	float get_avg_latency() const { return num_results ? float(total_latency) / float(num_results) : 0.f; }
+};
+
+class QueryRing
+{
+public:
+	QueryRing();
+	~QueryRing();
+
+	void init(GLenum in_target, int in_num_slots);
+	void clear();
+
+	bool begin(int frame); //false if there is no free slot, end() shouldn't be called then
+	void end();
+
+	//reads results of all finished queries, returns true & the newest of them if any finished since the last call
+	bool poll(int frame, GLint &result);
+
+	const QueryRingStats &get_stats() const { return stats; }
+	void reset_stats();
+
+private:
+	GLenum target;
+	int num_slots;
+	int first_in_flight; //the oldest issued query
+	int num_in_flight;
+	GLuint queries[MAX_QUERY_RING_SLOTS];
+	int issue_frames[MAX_QUERY_RING_SLOTS];
+	QueryRingStats stats;
+};
+
+#endif
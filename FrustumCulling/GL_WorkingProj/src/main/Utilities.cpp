@@ -1,4 +1,5 @@
 #include "Utilities.h"
+#include <string>
 
 
 //---------------------------------------------------------------------------------------------------------------------------------------------------------------------------textures
@@ -217,6 +218,62 @@ char* load_file(const char* file_name)
 }
 
 
+//shader text of data/shaders/<name>.txt: lines '#include "file"' are replaced by that file of shaders folder (code shared by shaders),
+//defines are inserted after #version line (constants shared with c++ code)
+char* load_shader(const char* name, const char* defines)
+{
+	const char *shaders_folder = "data/shaders/";
+	std::string file_name = std::string(shaders_folder) + name;
+	if (file_name.find('.', strlen(shaders_folder)) == std::string::npos)
+		file_name += ".txt";
+
+	char *data = load_file(file_name.c_str());
+	if (!data)
+		return NULL;
+
+	std::string source;
+	const char *line = data;
+	bool version_found = false;
+	while (*line)
+	{
+		const char *line_end = strchr(line, '\n');
+		size_t line_size = line_end ? line_end - line + 1 : strlen(line);
+
+		const char *directive = line + strspn(line, " \t");
+		char include_name[64];
+		if (sscanf(directive, "#include \"%63[^\"]\"", include_name) == 1)
+		{
+			char *include_source = load_shader(include_name, NULL);
+			if (!include_source)
+			{
+				delete[] data;
+				return NULL;
+			}
+			source += include_source;
+			source += '\n';
+			delete[] include_source;
+		}
+		else
+			source.append(line, line_size);
+
+		if (!version_found && !strncmp(line, "#version", 8))
+		{
+			version_found = true;
+			if (line_size && line[line_size - 1] != '\n')
+				source += '\n';
+			if (defines)
+				source += defines;
+		}
+		line += line_size;
+	}
+	delete[] data;
+
+	char *result = new char[source.size() + 1];
+	memcpy(result, source.c_str(), source.size() + 1);
+	return result;
+}
+
+
 void printShaderInfoLog(GLuint obj)
 {
 	int infologLength = 0;
@@ -251,20 +308,15 @@ GLuint createShader(GLenum type, const GLchar* src)
 }
 
 
-GLuint init_shader(const char* vertex_shader_file, const char* frag_shader_file, const char* geometry_shader_file, bool call_link_shader)
+GLuint init_shader(const char* vertex_shader_file, const char* frag_shader_file, const char* geometry_shader_file, bool call_link_shader, const char* defines)
 {
-	char tmp_str[64];
-
 //load vertex shader
-	const char *shaders_folder = "data/shaders/";
-	sprintf(&tmp_str[0], "%s%s.txt", shaders_folder, vertex_shader_file);
-	const char* VS_src = load_file(&tmp_str[0]);
+	const char* VS_src = load_shader(vertex_shader_file, defines);
 	if (!VS_src)
 		return -1;
 
 //load pixel shader
-	sprintf(&tmp_str[0], "%s%s.txt", shaders_folder, frag_shader_file);
-	const char* PS_src = load_file(&tmp_str[0]);
+	const char* PS_src = load_shader(frag_shader_file, defines);
 	if (!PS_src)
 		return -1;
 
@@ -272,8 +324,7 @@ GLuint init_shader(const char* vertex_shader_file, const char* frag_shader_file,
 	char* GS_src = NULL;
 	if (geometry_shader_file)
 	{
-		sprintf(&tmp_str[0], "%s%s.txt", shaders_folder, geometry_shader_file);
-		GS_src = load_file(&tmp_str[0]);
+		GS_src = load_shader(geometry_shader_file, defines);
 		if (!GS_src)
 			return -1;
 	}
@@ -311,6 +362,31 @@ GLuint init_shader(const char* vertex_shader_file, const char* frag_shader_file,
 }
 
 
+GLuint init_compute_shader(const char* compute_shader_file, const char* defines)
+{
+	if (!glDispatchCompute)
+		return -1;
+
+	const char* CS_src = load_shader(compute_shader_file, defines);
+	if (!CS_src)
+		return -1;
+
+	GLuint computeShader = createShader(GL_COMPUTE_SHADER, CS_src);
+	GLuint shaderProgram = glCreateProgram();
+	glAttachShader(shaderProgram, computeShader);
+	link_shader(shaderProgram);
+
+	GLint linked;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		glDeleteProgram(shaderProgram);
+		return -1;
+	}
+	return shaderProgram;
+}
+
+
 void link_shader(GLuint shaderProgram)
 {
 	glLinkProgram(shaderProgram);
@@ -438,7 +514,7 @@ void CheckDebugLog()
 	delete[] messageLog;
 }
 
-void CALLBACK DebugCallback(unsigned int source, unsigned int type, unsigned int id,
+void APIENTRY DebugCallback(unsigned int source, unsigned int type, unsigned int id,
 	unsigned int severity, int length,
 	const char* message, const void* userParam)
 {
@@ -2,14 +2,13 @@
 #define _UTILITIES_H
 
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
-#include <process.h>
-#include <mmsystem.h>
+#include <string.h>
 #include <math.h>
-#include <gl\gl.h>										// Header File For The OpenGL32 Library
-#include <gl\glu.h>										// Header File For The GLu32 Library
 
 #include "../glext/glext.h"
 
@@ -65,13 +64,15 @@ void create_render_element(GLuint &vao_id,
 	GLuint &vbo_id, RenderElementDescription &desc,
 	bool use_ibo, GLuint &ibo_id, int num_indices, int *indices);
 
-//shader
-GLuint init_shader(const char* vertex_shader_file, const char* frag_shader_file, const char* geometry_shader_file = NULL, bool call_link_shader = true);
+//shader, files are taken from data/shaders, see load_shader() about #include & defines
+char* load_shader(const char* name, const char* defines);
+GLuint init_shader(const char* vertex_shader_file, const char* frag_shader_file, const char* geometry_shader_file = NULL, bool call_link_shader = true, const char* defines = NULL);
 void link_shader(GLuint shaderProgram);
+GLuint init_compute_shader(const char* compute_shader_file, const char* defines = NULL); //-1 if compute shaders are not supported or program isn't linked
 
 //debug
 void clearDebugLog();
-void CALLBACK DebugCallback(unsigned int source, unsigned int type, unsigned int id,
+void APIENTRY DebugCallback(unsigned int source, unsigned int type, unsigned int id,
 	unsigned int severity, int length,
 	const char* message, const void* userParam);
 
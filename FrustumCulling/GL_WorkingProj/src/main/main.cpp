@@ -1,65 +1,74 @@
 #include "main.h"
 #include "Utilities.h"
-
-#include <xmmintrin.h>
-#include <mmintrin.h>
-#include <emmintrin.h>
-#include <new.h>  
-
-//AABB - axis-aligned bounding box
-//OBB - oriented Bounding Box
+#include "HiZBuffer.h"
+#include "QueryRing.h"
+#include "InstanceUploadRing.h"
+#include "Profiler.h"
+#include "../culling/Culling.h"
+#include "../culling/BoundsSoA.h"
+#include "../culling/BVH.h"
+#include "../culling/UniformGrid.h"
+#include "../culling/CoherentCulling.h"
+#include "../culling/OcclusionCulling.h"
+#include "../jobs/JobSystem.h"
+#include "../platform/Window.h"
+#include "../Camera/CameraPath.h"
 
 
 //---------------------------------------------------------------------------------------------------------------------------------------------------------------------------data & settings
 //------------screen
-#define SCREEN_WIDTH 1600
-#define SCREEN_HEIGHT 900
-#define SCREEN_DEPTH 32
-
-bool  g_bFullScreen = TRUE;
-HWND  g_hWnd;
-RECT  g_rRect;
-HDC   g_hDC;
-HGLRC g_hRC;
-HINSTANCE g_hInstance;
-
 int window_width;
 int window_height;
 
 
 //------------demo settings
 bool use_multithreading = false;
-const int num_workers = 4;
 
 bool use_gpu_culling = false;
+bool use_hiz_culling = true; //gpu culling also tests objects against hi-z of the previous frame
 bool enable_rendering_objects = true;
 bool culling_enabled = true;
+bool move_objects_enabled = false;
 
 const bool only_culling_measurements = false;
 
-enum CULLING_MODE
-{
-	SIMPLE_SPHERES,
-	SIMPLE_AABB,
-	SIMPLE_OBB,
-
-	SSE_SPHERES,
-	SSE_AABB,
-	SSE_OBB
-};
 CULLING_MODE culling_mode = SIMPLE_SPHERES;
 
 //------------time
 double total_time = 0.0;
+int scene_seed = -1; //random scene, -1 - seed from time
 
 //------------camera
 CCamera camera;
-CFrustum frustum;
+CullingContext culling_context; //frustum planes & view projection matrix, set once per culled frame
 float zNear = 0.1f;
 float zFar = 100.f;
 
 mat4 camera_view_matrix, camera_proj_matrix, camera_view_proj_matrix, saved_inv_view_proj_matrix;
 
+//------------camera path
+//played path moves camera & objects with fixed time step, so runs of different culling modes see the same frames
+CameraPath camera_path;
+bool camera_path_playing = false;
+int camera_path_frame = 0;
+const float CAMERA_PATH_DT = 1.f / 60.f;
+const char *camera_path_record_file = NULL; //camera keys of interactive run are saved to it at shutdown
+double camera_path_next_key_time = 0.0;
+const double CAMERA_PATH_RECORD_INTERVAL = 0.5; //seconds between recorded keys
+
+//------------frame stats
+//per frame csv: culling & draw cpu time, visible objects, bytes uploaded to gpu. Frame waits for gpu while stats are written,
+//so draw time includes gpu work of the frame & frames don't overlap
+FILE *frame_stats_file = NULL;
+int frame_stats_index = 0;
+int frame_upload_bytes = 0;
+int frame_bvh_rebuilds = 0; //refit found bvh quality degraded & rebuilt it
+
+//------------profiler
+//cpu & gpu time of frame stages, the last frames are written to chrome trace at shutdown & by 'P' key
+Profiler profiler;
+const char *trace_file = NULL; //profiler is enabled if it's set
+
 //------------area
 const float AREA_SIZE = 20.f;
 const float half_box_size = 0.05f;
@@ -67,52 +76,25 @@ const vec3 box_max = vec3(half_box_size, half_box_size, half_box_size);
 const vec3 box_min = -vec3(half_box_size, half_box_size, half_box_size);
 const vec3 box_half_size = vec3(half_box_size, half_box_size, half_box_size);
 const float bounding_radius = sqrtf(3.f) * half_box_size;
-
-//------------sse
-#define sse_align 16
-#define ALIGN_SSE __declspec( align( sse_align ) )
-
-ALIGN_SSE struct mat4_sse
-{
-	__m128 col0;
-	__m128 col1;
-	__m128 col2;
-	__m128 col3;
-
-	mat4_sse() {}
-	mat4_sse(mat4 &m)
-	{
-		set(m);
-	}
-	inline void set(mat4 &m)
-	{
-		col0 = _mm_loadu_ps(&m.mat[0]);
-		col1 = _mm_loadu_ps(&m.mat[4]);
-		col2 = _mm_loadu_ps(&m.mat[8]);
-		col3 = _mm_loadu_ps(&m.mat[12]);
-	}
-};
+const vec3 area_min = vec3(-AREA_SIZE, 0.f, -AREA_SIZE); //objects centers are always inside
+const vec3 area_max = vec3(AREA_SIZE, half_box_size, AREA_SIZE);
 
 //------------scene geometry
-ALIGN_SSE struct BSphere
-{
-	vec3 pos;
-	float r;
-};
-
-ALIGN_SSE struct AABB
-{
-	vec4 box_min;
-	vec4 box_max;
-};
-
-
 const int MAX_SCENE_OBJECTS = 100000;
 BSphere *sphere_data = NULL;
 AABB *aabb_data = NULL;
-int *culling_res = NULL;
-mat4_sse *sse_obj_mat = NULL;
-mat4 *obj_mat = NULL;
+BoundsSoA bounds_soa; //the same spheres & aabbs, but structure of arrays
+BVH bvh; //hierarchy over aabb_data
+UniformGrid grid; //uniform grid over aabb_data
+CoherentCulling coherent_culling; //state of SSE_SPHERES_COHERENT mode, spheres are taken from bounds_soa
+OcclusionCulling occlusion_culling; //SSE_AABB_OCCLUSION mode, the nearest visible boxes are occluders
+const int OCCLUSION_WIDTH = 256;
+const int OCCLUSION_HEIGHT = 144;
+const int MAX_OCCLUDERS = 64;
+const float MIN_OCCLUDER_SIZE = 8.f; //pixels of occlusion buffer
+int occluders[MAX_OCCLUDERS];
+uint32_t *visibility_mask = NULL; //culling result, bit per object
+AffineTransform *obj_transforms = NULL; //objects matrices, shared by all obb modes
 
 
 //------------geometry rendering data
@@ -139,8 +121,26 @@ GLuint all_instances_data_vbo = -1;
 
 
 vec4 instance_info[MAX_SCENE_OBJECTS * 2]; //pos + color
-vec4 visible_instance_info[MAX_SCENE_OBJECTS * 2]; //just visible instances data
+PackedInstance packed_instances[MAX_SCENE_OBJECTS]; //instance_info packed for rendering, see Culling.h
 int num_visible_instances = MAX_SCENE_OBJECTS;
+PackedInstance *visible_instances_out = NULL; //mapped tbo, visible instances data are written directly to it
+InstanceUploadRing instance_upload_ring; //persistently mapped tbo slots for cpu culling, glMapBuffer of dips_texture_buffer if gl 4.4 isn't supported
+bool draw_from_upload_ring = false; //visible instances of the frame are in the current slot of instance_upload_ring
+
+//compute shader culling writes visible instances to tbo & their number to indirect draw command, no readback
+GLuint draw_indirect_buffer = -1;
+bool draw_visible_instances_indirect = false; //tbo was filled by compute shader culling
+int num_gpu_culled_objects = MAX_SCENE_OBJECTS;
+const int COMPUTE_CULLING_GROUP_SIZE = 64; //local_size_x of culling_cs
+
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLuint base_vertex;
+	GLuint base_instance;
+};
 
 
 //------------shaders
@@ -148,49 +148,50 @@ Shader ground_shader;
 Shader geometry_shader;
 Shader show_frustum_shader;
 Shader culling_shader;
-GLuint num_visible_instances_query[2];
+Shader culling_compute_shader; //programm_id is -1 if compute shaders are not supported, transform feedback culling is used then
+QueryRing visible_instances_queries; //num visible instances of transform feedback culling, read without waiting for gpu
+const int NUM_VISIBLE_INSTANCES_QUERIES = 4; //frames in flight
+const int QUERY_STATS_FRAMES = 1000; //latency of visible instances count is printed every that many frames
+HiZBuffer hiz_buffer; //depth pyramid of the previous frame for gpu occlusion culling
+vec4 hiz_params; //culling shader uniform: size of mip 0, the last mip, 1 if hi-z is used
 
 int frame_index = 0;
 
 
 //------------multithreading
-//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------threads
-class Worker
-{
-public:
-	Worker();
-	~Worker();
-
-	//worker info
-	HANDLE thread_handle;
-	unsigned thread_id;
-	volatile bool stop_work;
-	HANDLE has_jobs_event;
-	HANDLE jobs_finished_event;
-
-	//make job
-	void doJob();
-	int first_processing_oject;
-	int num_processing_ojects;
-};
-
-Worker workers[num_workers];
-HANDLE thread_handles[num_workers];
+//culling is split to chunks, workers take chunks from job system & steal them from each other
+JobSystem job_system;
+const int CULLING_CHUNK_SIZE = 1024; //bounds & visibility of chunk fit in L1, multiple of CULLING_OBJECTS_ALIGNMENT
+const int NUM_CULLING_CHUNKS = (MAX_SCENE_OBJECTS + CULLING_CHUNK_SIZE - 1) / CULLING_CHUNK_SIZE;
+int chunk_visible_objects[NUM_CULLING_CHUNKS]; //visible objects of chunk, then prefix sum - output offset of chunk
 
-void create_threads();
-void threads_close();
-void process_multithreading_culling();
-void wate_multithreading_culling_done();
+void cull_chunk_job(void *data, int first_processing_oject, int num_processing_ojects, int worker_index);
+void compact_chunk_job(void *data, int first_processing_oject, int num_processing_ojects, int worker_index);
 
 
 void cull_objects(int first_processing_oject, int num_processing_ojects);
+int cull_and_compact(int first_processing_oject, int num_processing_ojects, PackedInstance *out);
+
+
+//------------moving objects
+const int NUM_MOVING_OBJECTS = 1000; //objects moved every frame when moving is enabled
+const float MOVING_SPEED = 1.f;
+
+//only gpu culling reads all_instances_data_vbo, moved instances are uploaded before it by coalesced ranges
+bool instance_dirty[MAX_SCENE_OBJECTS]; //instance_info changed after the last upload
+int num_dirty_instances = 0;
+const int FULL_INSTANCES_UPLOAD_THRESHOLD = MAX_SCENE_OBJECTS / 8; //more dirty instances are uploaded by one call for whole buffer
+
+void set_instance_transform(int i, const mat4 &m);
+void move_objects(float dt);
+void upload_dirty_instances();
 
 
 
 //---------------------------------------------------------------------------------------------------------------------------------------------------------------------------window stuff
 void SizeOpenGLScreen(int width, int height)
 {
-	height = max(height, 1);
+	height = height > 1 ? height : 1;
 	window_width = width;
 	window_height = height;
 	glViewport(0, 0, width, height);
@@ -201,72 +202,7 @@ void CheckGLErrors()
 {
 	GLenum err;
 	while ((err = glGetError()) != GL_NO_ERROR)
-		fprintf(stderr, "OpenGL Error: %s\n", gluErrorString(err));
-}
-
-//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------SSE base
-
-//https://github.com/nsf/sseculling/blob/master/Core/Memory.cpp
-template <typename T>
-inline T *new_sse(size_t size)
-{
-	return static_cast<T*>(_aligned_malloc(sizeof(T)* size, sse_align));
-}
-
-template <typename T>
-inline void delete_sse(T *ptr)
-{
-	_aligned_free(static_cast<void*>(ptr));
-}
-
-template <typename T>
-inline T* new_sse_array(int array_size)
-{
-	T* arr = static_cast<T*>(_aligned_malloc(sizeof(T)* array_size, sse_align));
-	for (size_t i = 0; i < size_t(array_size); i++)
-		new (&arr[i]) T;
-	return arr;
-}
-
-template <typename T>
-inline void delete_sse_array(T *arr, size_t array_size)
-{
-	for (size_t i = 0; i < array_size; i++)
-		arr[i].~T();//destroy all initialized elements
-	_aligned_free(static_cast<void*>(arr));
-}
-
-
-template <typename T>
-inline T *new_sse32(size_t size)
-{
-	return static_cast<T*>(_aligned_malloc(sizeof(T)* size, 32));
-}
-
-
-
-//http://stackoverflow.com/questions/38090188/matrix-multiplication-using-sse
-//https://gist.github.com/rygorous/4172889
-
-__forceinline __m128 sse_mat4_mul_vec4(mat4_sse &m, __m128 v)
-{
-	__m128 xxxx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
-	__m128 yyyy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
-	__m128 zzzz = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
-	__m128 wwww = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
-
-	return _mm_add_ps(
-		_mm_add_ps(_mm_mul_ps(xxxx, m.col0), _mm_mul_ps(yyyy, m.col1)),
-		_mm_add_ps(_mm_mul_ps(zzzz, m.col2), _mm_mul_ps(wwww, m.col3))
-	);
-}
-
-__forceinline void sse_mat4_mul(mat4_sse &dest, mat4_sse &m1, mat4_sse &m2)
-{
-	dest.col0 = sse_mat4_mul_vec4(m1, m2.col0);
-	dest.col1 = sse_mat4_mul_vec4(m1, m2.col1);
-	dest.col2 = sse_mat4_mul_vec4(m1, m2.col2);
-	dest.col3 = sse_mat4_mul_vec4(m1, m2.col3);
+		fprintf(stderr, "OpenGL Error: 0x%x\n", err);
 }
 
 
@@ -280,18 +216,16 @@ void generate_instances()
 	sphere_data = new_sse_array<BSphere>(MAX_SCENE_OBJECTS);
 	aabb_data = new_sse_array<AABB>(MAX_SCENE_OBJECTS);
 
-	culling_res = new_sse<int>(MAX_SCENE_OBJECTS);
-	memset(&culling_res[0], 0, sizeof(int) * MAX_SCENE_OBJECTS);
+	visibility_mask = new_sse<uint32_t>(visibility_words(MAX_SCENE_OBJECTS));
+	memset(&visibility_mask[0], 0, sizeof(uint32_t) * visibility_words(MAX_SCENE_OBJECTS));
 
-	sse_obj_mat = new_sse_array<mat4_sse>(MAX_SCENE_OBJECTS);
-	memset(&sse_obj_mat[0], 0, sizeof(mat4_sse) * MAX_SCENE_OBJECTS);
+	obj_transforms = new_sse_array<AffineTransform>(MAX_SCENE_OBJECTS);
 
-	obj_mat = new mat4[MAX_SCENE_OBJECTS];
+	bounds_soa.init(MAX_SCENE_OBJECTS);
 
 //generate instances data
 	int i;
 	vec3 pos;
-	mat4 obj_transform_mat; //identity by default
 	for (i = 0; i<MAX_SCENE_OBJECTS; i++)
 	{
 		//random position inside area
@@ -299,6 +233,7 @@ void generate_instances()
 
 		instance_info[i * 2 + 0] = vec4(pos, bounding_radius); //pos
 		instance_info[i * 2 + 1] = vec4(rnd01(), rnd01(), rnd01(), 1.f); //color
+		pack_instance(pos, instance_info[i * 2 + 1], packed_instances[i]);
 
 		sphere_data[i].pos = pos;
 		sphere_data[i].r = bounding_radius;
@@ -306,10 +241,16 @@ void generate_instances()
 		aabb_data[i].box_min = vec4(pos - box_half_size, 1.f);
 		aabb_data[i].box_max = vec4(pos + box_half_size, 1.f);
 
-		obj_transform_mat.set_translation(pos);
-		obj_mat[i] = obj_transform_mat;
-		sse_obj_mat[i].set(obj_transform_mat);
+		obj_transforms[i].set_translation(pos);
+
+		bounds_soa.add(sphere_data[i], aabb_data[i]); //objects are never removed, so object id == slot
+		bounds_soa.update_obb(i, obj_transforms[i]);
 	}
+
+	bvh.build(&aabb_data[0], MAX_SCENE_OBJECTS);
+	grid.build(&aabb_data[0], MAX_SCENE_OBJECTS);
+	coherent_culling.init(MAX_SCENE_OBJECTS);
+	occlusion_culling.init(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
 }
 
 
@@ -446,25 +387,40 @@ void create_scene()
 //create texture buffer which will contain visible instances data
 	glGenBuffers(1, &dips_texture_buffer);
 	glBindBuffer(GL_TEXTURE_BUFFER, dips_texture_buffer);
-	glBufferData(GL_TEXTURE_BUFFER, MAX_SCENE_OBJECTS * 2 * sizeof(vec4), &instance_info[0], GL_STATIC_DRAW);
+	glBufferData(GL_TEXTURE_BUFFER, MAX_SCENE_OBJECTS * sizeof(PackedInstance), &packed_instances[0], GL_STATIC_DRAW);
 	glGenTextures(1, &dips_texture_buffer_tex);
 	glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
+//cpu culling writes visible instances straight to persistently mapped memory
+	bool upload_ring = instance_upload_ring.init(MAX_SCENE_OBJECTS * sizeof(PackedInstance), GL_RGB32UI);
+	printf("instances upload: %s\n", upload_ring ? "persistently mapped ring" : "glMapBuffer");
+
 //for gpu culling, vbo with all instances data
 	RenderElementDescription desc;
 	VboElement vbo_elements[2] = { 4,0,GL_FLOAT,   4,sizeof(vec4),GL_FLOAT };
 	desc.init(sizeof(vec4)*2, MAX_SCENE_OBJECTS, (void*)&instance_info[0], GL_STATIC_DRAW, 2, &vbo_elements[0]);
-	create_render_element(all_instances_data_vao, geometry_vbo_id, desc, true, geometry_ibo_id, 0, NULL);
+	create_render_element(all_instances_data_vao, all_instances_data_vbo, desc, true, geometry_ibo_id, 0, NULL);
+
+//for compute shader culling, instances count is written by gpu
+	DrawElementsIndirectCommand draw_command = { 36, 0, 0, 0, 0 };
+	glGenBuffers(1, &draw_indirect_buffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draw_indirect_buffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand), &draw_command, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 }
 
 
 
 void init_shaders()
 {
+	//shaders which pack or unpack PackedInstance, see data/shaders/packed_instance.txt
+	char instance_defines[64];
+	sprintf(instance_defines, "#define INSTANCE_CELL_SIZE %f\n", INSTANCE_CELL_SIZE);
+
 	ground_shader.programm_id = init_shader("ground_vs", "ground_ps");
 	ground_shader.add_uniform("ModelViewProjectionMatrix", 16, &camera_view_proj_matrix.mat[0]);
 
-	geometry_shader.programm_id = init_shader("geometry_vs", "geometry_ps");
+	geometry_shader.programm_id = init_shader("geometry_vs", "geometry_ps", NULL, true, instance_defines);
 	geometry_shader.add_uniform("ModelViewProjectionMatrix", 16, &camera_view_proj_matrix.mat[0]);
 
 	show_frustum_shader.programm_id = init_shader("show_frustum_vs", "show_frustum_ps");
@@ -472,33 +428,42 @@ void init_shaders()
 	show_frustum_shader.add_uniform("ModelViewProjectionMatrix", 16, &camera_view_proj_matrix.mat[0]);
 
 //gpu culling shader
-	culling_shader.programm_id = init_shader("culling_vs", "culling_ps", "culling_gs");
+	culling_shader.programm_id = init_shader("culling_vs", "culling_ps", "culling_gs", true, instance_defines);
 	culling_shader.add_uniform("ModelViewProjectionMatrix", 16, &camera_view_proj_matrix.mat[0]);
-	culling_shader.add_uniform("frustum_planes", 4, &frustum.frustum_planes[0].x, FLOAT_UNIFORM_TYPE, 6);
+	culling_shader.add_uniform("frustum_planes", 4, &culling_context.planes[0].x, FLOAT_UNIFORM_TYPE, 6);
+	culling_shader.add_uniform("HiZViewProjectionMatrix", 16, &hiz_buffer.view_proj.mat[0]);
+	culling_shader.add_uniform("hiz_params", 4, &hiz_params.x);
 
 	//http://steps3d.narod.ru/tutorials/tf3-tutorial.html
 	//https://open.gl/feedback
 
 	//prepare transform feedback
-	const char *vars[] = { "output_instance_data1", "output_instance_data2" };
-	glTransformFeedbackVaryings(culling_shader.programm_id, 2, vars, GL_INTERLEAVED_ATTRIBS);
+	const char *vars[] = { "output_instance_data" }; //PackedInstance
+	glTransformFeedbackVaryings(culling_shader.programm_id, 1, vars, GL_INTERLEAVED_ATTRIBS);
 	link_shader(culling_shader.programm_id); // relink required
 	glUseProgram(0);
 
+//compute shader culling, gl 4.3
+	culling_compute_shader.programm_id = init_compute_shader("culling_cs", instance_defines);
+	if (culling_compute_shader.programm_id != (GLuint)-1)
+	{
+		culling_compute_shader.add_uniform("num_objects", 1, &num_gpu_culled_objects, INT_UNIFORM_TYPE);
+		culling_compute_shader.add_uniform("frustum_planes", 4, &culling_context.planes[0].x, FLOAT_UNIFORM_TYPE, 6);
+		culling_compute_shader.add_uniform("HiZViewProjectionMatrix", 16, &hiz_buffer.view_proj.mat[0]);
+		culling_compute_shader.add_uniform("hiz_params", 4, &hiz_params.x);
+	}
+	printf("gpu culling: %s\n", culling_compute_shader.programm_id != (GLuint)-1 ? "compute shader" : "transform feedback");
+
 //queries for getting feedback from gpu - num visible instances
-	glGenQueries(2, &num_visible_instances_query[0]);
+	visible_instances_queries.init(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, NUM_VISIBLE_INSTANCES_QUERIES);
 }
 
 
-void Init(HWND hWnd)
+void Init()
 {
 	int i, j, k;
 
-	//init gl
-	g_hWnd = hWnd;										// Assign the window handle to a global window handle
-	GetClientRect(g_hWnd, &g_rRect);					// Assign the windows rectangle to a global RECT
-	InitializeOpenGL(g_rRect.right, g_rRect.bottom);	// Init OpenGL with the global rect
-
+	//init gl, context is created by window
 	glext_init();
 	clearDebugLog();
 
@@ -510,19 +475,22 @@ void Init(HWND hWnd)
 	}
 
 	glEnable(GL_DEPTH_TEST);
-	SizeOpenGLScreen(g_rRect.right, g_rRect.bottom);	// Setup the screen translations and viewport
+	int width, height;
+	window_get_size(width, height);
+	SizeOpenGLScreen(width, height);					// Setup the screen translations and viewport
+
+//timing
+	InitTimeOperation();
 
 //rnd
 	rndInit();
-	int rnd_seed = (int)timeGetTime() % 65535;
+	int rnd_seed = scene_seed >= 0 ? scene_seed : (int)(GetTicksTime() / 1000) % 65535;
 	rndSeed(rnd_seed);
 
-//timing
-	InitTimeOperation();
-
 //camera
 	camera.PositionCamera(10.f, 10.f, 10.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f);
 	camera.show_framerate = !only_culling_measurements;
+	camera.user_input = !camera_path_playing;
 
 //shaders
 	init_shaders();
@@ -536,23 +504,48 @@ void Init(HWND hWnd)
 //check errors
 	CheckGLErrors();
 
+//culling kernels
+	init_simd_culling();
+	printf("simd culling: %s\n", simd_level_names[get_simd_level()]);
+
 //multithreading
-	create_threads();
+	job_system.init();
+	printf("job system workers: %d\n", job_system.get_num_workers());
+
+//profiler, job system workers write their scopes
+	if (trace_file)
+		profiler.init(job_system.get_num_workers(), true);
 }
 
 
 void ShutDown()
 {
-	threads_close();
+	job_system.shutdown();
+
+//profiling
+	if (trace_file)
+		profiler.write_trace(trace_file);
+	profiler.clear();
+	if (camera_path_record_file && total_time > camera_path.get_duration())
+		camera_path.add_key((float)total_time, camera.Position(), camera.View()); //the last frame ends recorded path
+	if (camera_path_record_file && camera_path.save(camera_path_record_file))
+		printf("camera path: %d keys saved to %s\n", camera_path.get_num_keys(), camera_path_record_file);
+	if (frame_stats_file)
+		fclose(frame_stats_file);
+	frame_stats_file = NULL;
 
 //clear all data
 	delete_sse_array(sphere_data, MAX_SCENE_OBJECTS);
 	delete_sse_array(aabb_data, MAX_SCENE_OBJECTS);
-	delete_sse(culling_res);
-	delete_sse_array(sse_obj_mat, MAX_SCENE_OBJECTS);
-	if (obj_mat) {
-		delete[]obj_mat; obj_mat = NULL;
-	}
+	bounds_soa.clear();
+	bvh.clear();
+	grid.clear();
+	coherent_culling.clear();
+	occlusion_culling.clear();
+	hiz_buffer.clear();
+	instance_upload_ring.clear();
+	delete_sse(visibility_mask);
+	delete_sse_array(obj_transforms, MAX_SCENE_OBJECTS);
 
 //clear buffers
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wire_box_ibo_id);
@@ -587,6 +580,9 @@ void ShutDown()
 
 	glBindBuffer(GL_ARRAY_BUFFER, all_instances_data_vbo);
 	glDeleteBuffers(1, &all_instances_data_vbo);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glDeleteBuffers(1, &draw_indirect_buffer);
 	glBindVertexArray(all_instances_data_vao);
 	glDeleteBuffers(1, &all_instances_data_vao);
 
@@ -596,382 +592,132 @@ void ShutDown()
 	glDeleteProgram(geometry_shader.programm_id);
 	glDeleteProgram(show_frustum_shader.programm_id);
 	glDeleteProgram(culling_shader.programm_id);
+	if (culling_compute_shader.programm_id != (GLuint)-1)
+		glDeleteProgram(culling_compute_shader.programm_id);
 
 //queries
-	glDeleteQueries(2, &num_visible_instances_query[0]);
+	visible_instances_queries.clear();
 }
 
 
-//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------simple culling
 
-__forceinline bool SphereInFrustum(vec3 &pos, float &radius, vec4 *frustum_planes)
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------culling
+//objects are culled & compacted by chunks, so chunk's bounds & visibility are still in L1 while visible instances are written
+int cull_and_compact(int first_processing_oject, int num_processing_ojects, PackedInstance *out)
 {
-	bool res = true;
-	//test all 6 frustum planes
-	for (int i = 0; i < 6; i++)
+	int num_visible = 0;
+	int end = first_processing_oject + num_processing_ojects;
+	for (int first = first_processing_oject; first < end; first += CULLING_CHUNK_SIZE)
 	{
-		//calculate distance from sphere center to plane.
-		//if distance larger then sphere radius - sphere is outside frustum
-		if (frustum_planes[i].x * pos.x + frustum_planes[i].y * pos.y + frustum_planes[i].z * pos.z + frustum_planes[i].w <= -radius)
-			res = false;
-			//return false; //with flag works faster
-	}
-	return res;
-	//return true;
-}
-
+		int num = end - first < CULLING_CHUNK_SIZE ? end - first : CULLING_CHUNK_SIZE;
+		cull_objects(first, num);
 
-__forceinline bool RightParallelepipedInFrustum(vec4 &Min, vec4 &Max, vec4 *frustum_planes)
-{
-	bool inside = true;
-	//test all 6 frustum planes
-	for (int i = 0; i<6; i++)
-	{
-		//pick closest point to plane and check if it behind the plane
-		//if yes - object outside frustum
-		float d = max(Min.x * frustum_planes[i].x, Max.x * frustum_planes[i].x)
-				+ max(Min.y * frustum_planes[i].y, Max.y * frustum_planes[i].y)
-				+ max(Min.z * frustum_planes[i].z, Max.z * frustum_planes[i].z)
-				+ frustum_planes[i].w;
-		inside &= d > 0;
-		//return false; //with flag works faster
+		uint32_t *block_visibility = &visibility_mask[first / VISIBILITY_WORD_BITS];
+		if (out)
+			num_visible += compact_visible_packed_instances(block_visibility, num, &packed_instances[first], &out[num_visible]);
+		else
+			num_visible += count_visible_objects(block_visibility, num);
 	}
-	return inside;
+	return num_visible;
 }
 
-
-
-__forceinline bool RightParallelepipedInFrustum2(vec4 &Min, vec4 &Max, vec4 *frustum_planes)
+void cull_chunk_job(void *data, int first_processing_oject, int num_processing_ojects, int worker_index)
 {
-	//this is just example of basic idea - how BOX culling works, both AABB and OBB
-		//Min & Max are 2 world space box points. For AABB-drustum culling
-		//We may use transformed (by object matrix) to world space 8 box points. Replace Min & Max in equations and we get OBB-frustum.
-
-	//test all 6 frustum planes
-	for (int i = 0; i<6; i++)
-	{
-		//try to find such plane for which all 8 box points behind it
-			//test all 8 box points against frustum plane
-			//calculate distance from point to plane
-			//if point infront of the plane (dist > 0) - this is not separating plane
-		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Max[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Max[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Max[2] + frustum_planes[i][3]>0)
-			continue;
-		if (frustum_planes[i][0] * Min[0] + frustum_planes[i][1] * Min[1] + frustum_planes[i][2] * Min[2] + frustum_planes[i][3]>0)
-			continue;
-
-		return false;
-	}
-	return true;
+	ProfileScope scope(profiler, "cull chunk", worker_index);
+	cull_objects(first_processing_oject, num_processing_ojects);
+	chunk_visible_objects[first_processing_oject / CULLING_CHUNK_SIZE] = count_visible_objects(&visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], num_processing_ojects);
 }
 
-__forceinline bool OBBInFrustum(const vec3 &Min, const vec3 &Max, mat4 &obj_transform_mat, mat4 &cam_modelview_proj_mat)
+//frustum culling of all objects, then the nearest visible boxes are rasterized & visible objects are tested against them
+void cull_occlusion()
 {
-	//transform all 8 box points to clip space
-	//clip space because we easily can test points outside required unit cube
-		//NOTE: for DirectX we should test z coordinate from 0 to w (-w..w - for OpenGL), look for transformations / clipping box differences
-
-	//matrix to transfrom points to clip space
-	mat4 to_clip_space_mat = cam_modelview_proj_mat * obj_transform_mat;
-
-	//transform all 8 box points to clip space
-	vec4 obb_points[8];
-	obb_points[0] = to_clip_space_mat * vec4(Min[0], Max[1], Min[2], 1.f);
-	obb_points[1] = to_clip_space_mat * vec4(Min[0], Max[1], Max[2], 1.f);
-	obb_points[2] = to_clip_space_mat * vec4(Max[0], Max[1], Max[2], 1.f);
-	obb_points[3] = to_clip_space_mat * vec4(Max[0], Max[1], Min[2], 1.f);
-	obb_points[4] = to_clip_space_mat * vec4(Max[0], Min[1], Min[2], 1.f);
-	obb_points[5] = to_clip_space_mat * vec4(Max[0], Min[1], Max[2], 1.f);
-	obb_points[6] = to_clip_space_mat * vec4(Min[0], Min[1], Max[2], 1.f);
-	obb_points[7] = to_clip_space_mat * vec4(Min[0], Min[1], Min[2], 1.f);
-
-	bool outside = false, outside_positive_plane, outside_negative_plane;
-	//we have 6 frustum planes, which in clip space is unit cube (for GL) with -1..1 range
-	for (int i = 0; i < 3; i++) //3 because we test positive & negative plane at once
+	AABBCenterExtentSoA boxes = bounds_soa.get_aabb_center_extents(0);
+	simd_culling_aabb_center_extent(boxes, MAX_SCENE_OBJECTS, &visibility_mask[0], culling_context);
+
+	occlusion_culling.begin_frame(culling_context);
+	int num_occluders = occlusion_culling.select_occluders(boxes, MAX_SCENE_OBJECTS, &visibility_mask[0], MAX_OCCLUDERS, MIN_OCCLUDER_SIZE, &occluders[0]);
+	for (int i = 0; i < num_occluders; i++)
 	{
-		//if all 8 points outside one of the plane
-		//actually it is vertex normalization xyz / w, then compare if all 8points coordinates < -1 or > 1
-
-		outside_positive_plane =
-			obb_points[0][i] > obb_points[0].w &&
-			obb_points[1][i] > obb_points[1].w &&
-			obb_points[2][i] > obb_points[2].w &&
-			obb_points[3][i] > obb_points[3].w &&
-			obb_points[4][i] > obb_points[4].w &&
-			obb_points[5][i] > obb_points[5].w &&
-			obb_points[6][i] > obb_points[6].w &&
-			obb_points[7][i] > obb_points[7].w;
-
-		outside_negative_plane =
-			 obb_points[0][i] < -obb_points[0].w &&
-			 obb_points[1][i] < -obb_points[1].w &&
-			 obb_points[2][i] < -obb_points[2].w &&
-			 obb_points[3][i] < -obb_points[3].w &&
-			 obb_points[4][i] < -obb_points[4].w &&
-			 obb_points[5][i] < -obb_points[5].w &&
-			 obb_points[6][i] < -obb_points[6].w &&
-			 obb_points[7][i] < -obb_points[7].w;
-
-		outside = outside || outside_positive_plane || outside_negative_plane;
-		//if (outside_positive_plane || outside_negative_plane)
-			//return false;
+		int k = occluders[i];
+		occlusion_culling.add_occluder(vec3(boxes.center_x[k], boxes.center_y[k], boxes.center_z[k]), vec3(boxes.extent_x[k], boxes.extent_y[k], boxes.extent_z[k]));
 	}
-	return !outside;
-	//return true;
-}
-
-
-
-
-void simple_culling_spheres(BSphere *sphere_data, int num_objects, int *culling_res, vec4 *frustum_planes)
-{
-	for (int i = 0; i < num_objects; i++)
-		culling_res[i] = !SphereInFrustum(sphere_data[i].pos, sphere_data[i].r, &frustum_planes[0]);
+	occlusion_culling.update_hiz();
+	occlusion_culling.cull(boxes, MAX_SCENE_OBJECTS, &visibility_mask[0]);
 }
 
-void simple_culling_aabb(AABB *aabb_data, int num_objects, int *culling_res, vec4 *frustum_planes)
+void compact_chunk_job(void *data, int first_processing_oject, int num_processing_ojects, int worker_index)
 {
-	for (int i = 0; i < num_objects; i++)
-		culling_res[i] = !RightParallelepipedInFrustum(aabb_data[i].box_min, aabb_data[i].box_max, &frustum_planes[0]);
+	ProfileScope scope(profiler, "compact chunk", worker_index);
+	int output_offset = chunk_visible_objects[first_processing_oject / CULLING_CHUNK_SIZE];
+	compact_visible_packed_instances(&visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], num_processing_ojects,
+		&packed_instances[first_processing_oject], &visible_instances_out[output_offset]);
 }
 
-void simple_culling_obb(int first_processing_oject, int num_objects, int *culling_res, vec4 *frustum_planes)
-{
-	for (int i = first_processing_oject; i < first_processing_oject + num_objects; i++)
-		culling_res[i] = !OBBInFrustum(box_min, box_max, obj_mat[i], camera_view_proj_matrix);
-
-}
-
-
-//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------sse culling
-
-void sse_culling_spheres(BSphere *sphere_data, int num_objects, int *culling_res, vec4 *frustum_planes)
+void do_cpu_culling()
 {
-	float *sphere_data_ptr = reinterpret_cast<float*>(&sphere_data[0]);
-	int *culling_res_sse = &culling_res[0];
-
-	//to optimize calculations we gather xyzw elements in separate vectors
-	__m128 zero_v = _mm_setzero_ps();
-	__m128 frustum_planes_x[6];
-	__m128 frustum_planes_y[6];
-	__m128 frustum_planes_z[6];
-	__m128 frustum_planes_d[6];
-	int i, j;
-	for (i = 0; i < 6; i++)
-	{
-		frustum_planes_x[i] = _mm_set1_ps(frustum_planes[i].x);
-		frustum_planes_y[i] = _mm_set1_ps(frustum_planes[i].y);
-		frustum_planes_z[i] = _mm_set1_ps(frustum_planes[i].z);
-		frustum_planes_d[i] = _mm_set1_ps(frustum_planes[i].w);
-	}
+	draw_visible_instances_indirect = false;
 
-	//we process 4 objects per step
-	for (i = 0; i < num_objects; i += 4)
+//map gpu buffer first, visible instances data are written directly to it without intermediate array.
+//slot of upload ring is always mapped, only waits for gpu if it's still drawn from
+	visible_instances_out = NULL;
+	draw_from_upload_ring = false;
+	if (enable_rendering_objects)
 	{
-		//load bounding sphere data
-		__m128 spheres_pos_x = _mm_load_ps(sphere_data_ptr);
-		__m128 spheres_pos_y = _mm_load_ps(sphere_data_ptr + 4);
-		__m128 spheres_pos_z = _mm_load_ps(sphere_data_ptr + 8);
-		__m128 spheres_radius = _mm_load_ps(sphere_data_ptr + 12);
-		sphere_data_ptr += 16;
-
-		//but for our calculations we need transpose data, to collect x, y, z and w coordinates in separate vectors
-		_MM_TRANSPOSE4_PS(spheres_pos_x, spheres_pos_y, spheres_pos_z, spheres_radius);
-
-		__m128 spheres_neg_radius = _mm_sub_ps(zero_v, spheres_radius);  // negate all elements
-																		 //http://fastcpp.blogspot.ru/2011/03/changing-sign-of-float-values-using-sse.html
-
-		__m128 intersection_res = _mm_setzero_ps();
-
-		for (j = 0; j < 6; j++) //plane index
+		ProfileScope scope(profiler, "tbo map");
+		if (instance_upload_ring.is_initialized())
 		{
-			//1. calc distance to plane dot(sphere_pos.xyz, plane.xyz) + plane.w
-			//2. if distance < sphere radius, then sphere outside frustum
-			__m128 dot_x = _mm_mul_ps(spheres_pos_x, frustum_planes_x[j]);
-			__m128 dot_y = _mm_mul_ps(spheres_pos_y, frustum_planes_y[j]);
-			__m128 dot_z = _mm_mul_ps(spheres_pos_z, frustum_planes_z[j]);
-
-			__m128 sum_xy = _mm_add_ps(dot_x, dot_y);
-			__m128 sum_zw = _mm_add_ps(dot_z, frustum_planes_d[j]);
-			__m128 distance_to_plane = _mm_add_ps(sum_xy, sum_zw);
-
-			__m128 plane_res = _mm_cmple_ps(distance_to_plane, spheres_neg_radius); //dist < -sphere_r ?
-			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - sphere behind the plane & outside frustum
+			visible_instances_out = (PackedInstance*)instance_upload_ring.begin_frame();
+			draw_from_upload_ring = true;
 		}
-
-		//store result
-		__m128i intersection_res_i = _mm_cvtps_epi32(intersection_res); //convert to integers
-		_mm_store_si128((__m128i *)&culling_res_sse[i], intersection_res_i); //store result in culling_res_sse[]
-	}
-}
-
-
-void sse_culling_aabb(AABB *aabb_data, int num_objects, int *culling_res, vec4 *frustum_planes)
-{
-	float *aabb_data_ptr = reinterpret_cast<float*>(&aabb_data[0]);
-	int *culling_res_sse = &culling_res[0];
-
-	//to optimize calculations we gather xyzw elements in separate vectors
-	__m128 zero_v = _mm_setzero_ps();
-	__m128 frustum_planes_x[6];
-	__m128 frustum_planes_y[6];
-	__m128 frustum_planes_z[6];
-	__m128 frustum_planes_d[6];
-	int i, j;
-	for (i = 0; i < 6; i++)
-	{
-		frustum_planes_x[i] = _mm_set1_ps(frustum_planes[i].x);
-		frustum_planes_y[i] = _mm_set1_ps(frustum_planes[i].y);
-		frustum_planes_z[i] = _mm_set1_ps(frustum_planes[i].z);
-		frustum_planes_d[i] = _mm_set1_ps(frustum_planes[i].w);
-	}
-
-	__m128 zero = _mm_setzero_ps();
-	//we process 4 objects per step
-	for (i = 0; i < num_objects; i += 4)
-	{
-		//load objects data
-		//load aabb min
-		__m128 aabb_min_x = _mm_load_ps(aabb_data_ptr);
-		__m128 aabb_min_y = _mm_load_ps(aabb_data_ptr + 8);
-		__m128 aabb_min_z = _mm_load_ps(aabb_data_ptr + 16);
-		__m128 aabb_min_w = _mm_load_ps(aabb_data_ptr + 24);
-
-		//load aabb max
-		__m128 aabb_max_x = _mm_load_ps(aabb_data_ptr + 4);
-		__m128 aabb_max_y = _mm_load_ps(aabb_data_ptr + 12);
-		__m128 aabb_max_z = _mm_load_ps(aabb_data_ptr + 20);
-		__m128 aabb_max_w = _mm_load_ps(aabb_data_ptr + 28);
-
-		aabb_data_ptr += 32;
-
-		//for now we have points in vectors aabb_min_x..w, but for calculations we need to xxxx yyyy zzzz vectors representation - just transpose data
-		_MM_TRANSPOSE4_PS(aabb_min_x, aabb_min_y, aabb_min_z, aabb_min_w);
-		_MM_TRANSPOSE4_PS(aabb_max_x, aabb_max_y, aabb_max_z, aabb_max_w);
-
-		__m128 intersection_res = _mm_setzero_ps();
-		for (j = 0; j < 6; j++) //plane index
+		else
 		{
-			//this code is similar to what we make in simple culling
-				//pick closest point to plane and check if it begind the plane. if yes - object outside frustum
-
-			//dot product, separate for each coordinate, for min & max aabb points
-			__m128 aabbMin_frustumPlane_x = _mm_mul_ps(aabb_min_x, frustum_planes_x[j]);
-			__m128 aabbMin_frustumPlane_y = _mm_mul_ps(aabb_min_y, frustum_planes_y[j]);
-			__m128 aabbMin_frustumPlane_z = _mm_mul_ps(aabb_min_z, frustum_planes_z[j]);
-
-			__m128 aabbMax_frustumPlane_x = _mm_mul_ps(aabb_max_x, frustum_planes_x[j]);
-			__m128 aabbMax_frustumPlane_y = _mm_mul_ps(aabb_max_y, frustum_planes_y[j]);
-			__m128 aabbMax_frustumPlane_z = _mm_mul_ps(aabb_max_z, frustum_planes_z[j]);
-
-			//we have 8 box points, but we need pick closest point to plane. Just take max
-			__m128 res_x = _mm_max_ps(aabbMin_frustumPlane_x, aabbMax_frustumPlane_x);
-			__m128 res_y = _mm_max_ps(aabbMin_frustumPlane_y, aabbMax_frustumPlane_y);
-			__m128 res_z = _mm_max_ps(aabbMin_frustumPlane_z, aabbMax_frustumPlane_z);
-
-			//dist to plane = dot(aabb_point.xyz, plane.xyz) + plane.w
-			__m128 sum_xy = _mm_add_ps(res_x, res_y);
-			__m128 sum_zw = _mm_add_ps(res_z, frustum_planes_d[j]);
-			__m128 distance_to_plane = _mm_add_ps(sum_xy, sum_zw);
-
-			__m128 plane_res = _mm_cmple_ps(distance_to_plane, zero); //dist from closest point to plane < 0 ?
-			intersection_res = _mm_or_ps(intersection_res, plane_res); //if yes - aabb behind the plane & outside frustum
+			glBindBuffer(GL_TEXTURE_BUFFER, dips_texture_buffer);
+			visible_instances_out = (PackedInstance*)glMapBuffer(GL_TEXTURE_BUFFER, GL_WRITE_ONLY);
 		}
-
-		//store result
-		__m128i intersection_res_i = _mm_cvtps_epi32(intersection_res); //convert to integers
-		_mm_store_si128((__m128i *)&culling_res_sse[i], intersection_res_i); //store result in culling_res_sse[]
 	}
-}
-
 
-void sse_culling_obb(int firs_processing_object, int num_objects, int *culling_res, mat4 &cam_modelview_proj_mat)
-{
-	mat4_sse sse_camera_mat(cam_modelview_proj_mat);
-	mat4_sse sse_clip_space_mat;
-
-//box points in local space
-	__m128 obb_points_sse[8];
-	obb_points_sse[0] = _mm_set_ps(1.f, box_min[2], box_max[1], box_min[0]);
-	obb_points_sse[1] = _mm_set_ps(1.f, box_max[2], box_max[1], box_min[0]);
-	obb_points_sse[2] = _mm_set_ps(1.f, box_max[2], box_max[1], box_max[0]);
-	obb_points_sse[3] = _mm_set_ps(1.f, box_min[2], box_max[1], box_max[0]);
-	obb_points_sse[4] = _mm_set_ps(1.f, box_min[2], box_min[1], box_max[0]);
-	obb_points_sse[5] = _mm_set_ps(1.f, box_max[2], box_min[1], box_max[0]);
-	obb_points_sse[6] = _mm_set_ps(1.f, box_max[2], box_min[1], box_min[0]);
-	obb_points_sse[7] = _mm_set_ps(1.f, box_min[2], box_min[1], box_min[0]);
-
-	ALIGN_SSE int obj_culling_res[4];
-
-	__m128 zero_v = _mm_setzero_ps();
-	int i, j;
+//culling & collecting visible instances
+	Timer timer;
+	if (only_culling_measurements)
+		timer.StartTiming();
 
-	//process one object per step
-	for (i = firs_processing_object; i < firs_processing_object+num_objects; i++)
+	//spatial structures are culled at once, chunks jobs just collect their results
 	{
-	//clip space matrix = camera_view_proj * obj_mat
-		sse_mat4_mul(sse_clip_space_mat, sse_camera_mat, sse_obj_mat[i]);
+		ProfileScope scope(profiler, "structures culling");
+		if (culling_mode == SSE_AABB_BVH)
+			bvh.cull(&visibility_mask[0], culling_context);
+		else if (culling_mode == SSE_AABB_GRID)
+			grid.cull(&visibility_mask[0], culling_context);
+		else if (culling_mode == SSE_SPHERES_COHERENT)
+			coherent_culling.begin_frame(culling_context, area_min, area_max); //chunks are culled by jobs as usual
+		else if (culling_mode == SSE_AABB_OCCLUSION)
+			cull_occlusion();
+	}
 
-		//initially assume that planes are separating
-		//if any axis is separating - we get 0 in certain outside_* place
-		__m128 outside_positive_plane = _mm_set1_ps(-1.f); //NOTE: there should be negative value..
-		__m128 outside_negative_plane = _mm_set1_ps(-1.f); //because _mm_movemask_ps (while storing result) cares abount 'most significant bits' (it is sign of float value)
+	if (use_multithreading)
+	{
+		//workers cull chunks & count visible objects
+		job_system.parallel_for(MAX_SCENE_OBJECTS, CULLING_CHUNK_SIZE, cull_chunk_job, NULL);
 
-		//for all 8 box points
-		for (j = 0; j < 8; j++)
+		//output offsets of chunks are prefix sum of visible counts
+		num_visible_instances = 0;
+		for (int i = 0; i < NUM_CULLING_CHUNKS; i++)
 		{
-		//transform point to clip space
-			__m128 obb_transformed_point = sse_mat4_mul_vec4(sse_clip_space_mat, obb_points_sse[j]);
-
-		//gather w & -w
-			__m128 wwww = _mm_shuffle_ps(obb_transformed_point, obb_transformed_point, _MM_SHUFFLE(3, 3, 3, 3)); //get w
-			__m128 wwww_neg = _mm_sub_ps(zero_v, wwww);  // negate all elements
-
-		//box_point.xyz > box_point.w || box_point.xyz < -box_point.w ?
-		//similar to point normalization: point.xyz /= point.w; And compare: point.xyz > 1 && point.xyz < -1
-			__m128 outside_pos_plane = _mm_cmpge_ps(obb_transformed_point, wwww);
-			__m128 outside_neg_plane = _mm_cmple_ps(obb_transformed_point, wwww_neg);
-
-		//if at least 1 of 8 points in front of the plane - we get 0 in outside_* flag
-			outside_positive_plane = _mm_and_ps(outside_positive_plane, outside_pos_plane);
-			outside_negative_plane = _mm_and_ps(outside_negative_plane, outside_neg_plane);
+			int num_visible = chunk_visible_objects[i];
+			chunk_visible_objects[i] = num_visible_instances;
+			num_visible_instances += num_visible;
 		}
 
-		//all 8 points xyz < -1 or > 1 ?
-		__m128 outside = _mm_or_ps(outside_positive_plane, outside_negative_plane);
-
-		//store result, if any of 3 axes is separating (i.e. outside != 0) - object outside frustum
-		//so, object inside frustum only if outside == 0 (there are no separating axes)
-		culling_res[i] = _mm_movemask_ps(outside) & 0x7; //& 0x7 mask, because we interested only in 3 axes
-	}
-}
-
-
-
-//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------culling
-void do_cpu_culling()
-{
-//culling
-	Timer timer;
-	if (only_culling_measurements)
-		timer.StartTiming();
-	if (use_multithreading)
-	{
-		process_multithreading_culling();
-		wate_multithreading_culling_done();
+		//workers write visible instances of chunks to their offsets
+		if (visible_instances_out)
+			job_system.parallel_for(MAX_SCENE_OBJECTS, CULLING_CHUNK_SIZE, compact_chunk_job, NULL);
 	} else
-		cull_objects(0, MAX_SCENE_OBJECTS);
+	{
+		ProfileScope scope(profiler, "cull & compact");
+		num_visible_instances = cull_and_compact(0, MAX_SCENE_OBJECTS, visible_instances_out);
+	}
+	if (visible_instances_out)
+		frame_upload_bytes += num_visible_instances * (int)sizeof(PackedInstance);
 
 //computing time
 	if (only_culling_measurements)
@@ -986,49 +732,73 @@ void do_cpu_culling()
 			double avg_dt = accumulated_dt / 1000.0;
 			char str[64];
 			sprintf(str, "culling takes: %.2f", float(avg_dt));
-			SetWindowText(g_hWnd, str);
+			window_set_title(str);
 			num_attempts = 0;
 			accumulated_dt = 0.0;
 		}
 	}
 
-//collect & transfer visible instances data to gpu
-	num_visible_instances = 0;
-	for (int i = 0; i < MAX_SCENE_OBJECTS; i++) if (culling_res[i] == 0)
-	{
-		visible_instance_info[num_visible_instances * 2 + 0] = instance_info[i * 2 + 0];
-		visible_instance_info[num_visible_instances * 2 + 1] = instance_info[i * 2 + 1];
-		num_visible_instances++;
-	}
-
-//copy to gpu
-	if (enable_rendering_objects)
+//unlock gpu buffer
+	if (enable_rendering_objects && !draw_from_upload_ring)
 	{
-		//lock buffer & copy visible instances data
-		glBindBuffer(GL_TEXTURE_BUFFER, dips_texture_buffer);
-		float* tbo_data = (float*)glMapBuffer(GL_TEXTURE_BUFFER, GL_WRITE_ONLY);
-
-		//copy instances data
-		memcpy(&tbo_data[0], &visible_instance_info[0], sizeof(vec4)*num_visible_instances * 2);
-
+		ProfileScope scope(profiler, "tbo unmap");
 		glUnmapBuffer(GL_TEXTURE_BUFFER);
 		glBindBuffer(GL_TEXTURE_BUFFER, 0);
 	}
+	visible_instances_out = NULL;
 }
 
 
 
+//visible instances are appended to tbo by atomic counter of indirect draw command, so draw call takes their number without cpu readback & frame delay
+void do_compute_culling()
+{
+	//reset instance count
+	GLuint zero = 0;
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draw_indirect_buffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offsetof(DrawElementsIndirectCommand, instance_count), sizeof(GLuint), &zero);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	culling_compute_shader.bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, all_instances_data_vbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dips_texture_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, draw_indirect_buffer);
+	glDispatchCompute((num_gpu_culled_objects + COMPUTE_CULLING_GROUP_SIZE - 1) / COMPUTE_CULLING_GROUP_SIZE, 1, 1);
+
+	//draw command & tbo fetches of geometry_vs wait for shader writes
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	draw_visible_instances_indirect = true;
+	draw_from_upload_ring = false;
+}
+
 void do_gpu_culling()
 {
-	culling_shader.bind();
+	upload_dirty_instances();
 
-	int cur_frame = frame_index % 2;
-	int prev_frame = (frame_index + 1) % 2;
+	GpuProfileScope gpu_scope(profiler, "gpu culling");
+	hiz_params = vec4(float(hiz_buffer.get_width()), float(hiz_buffer.get_height()), float(hiz_buffer.get_num_levels() - 1),
+		use_hiz_culling && hiz_buffer.is_valid() ? 1.f : 0.f);
+	hiz_buffer.bind(0);
 
-	//prepare feedback & query
+	if (culling_compute_shader.programm_id != (GLuint)-1)
+	{
+		do_compute_culling();
+		return;
+	}
+
+	draw_visible_instances_indirect = false;
+	draw_from_upload_ring = false;
+	culling_shader.bind();
+
+	//prepare feedback & query, query is skipped if all of them are still in flight
 	glEnable(GL_RASTERIZER_DISCARD);
 	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, dips_texture_buffer);
-	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, num_visible_instances_query[cur_frame]);
+	bool query_issued = visible_instances_queries.begin(frame_index);
 	glBeginTransformFeedback(GL_POINTS);
 
 	//render cloud of points which we interprent as objects data
@@ -1038,13 +808,24 @@ void do_gpu_culling()
 
 	//disable all
 	glEndTransformFeedback();
-	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+	if (query_issued)
+		visible_instances_queries.end();
 	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
 	glDisable(GL_RASTERIZER_DISCARD);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-	//get feedback from prev frame
-	num_visible_instances = 0;
-	glGetQueryObjectiv(num_visible_instances_query[prev_frame], GL_QUERY_RESULT, &num_visible_instances);
+	//the newest finished count, previous one is kept while gpu is behind
+	GLint num_visible = 0;
+	if (visible_instances_queries.poll(frame_index, num_visible))
+		num_visible_instances = num_visible;
+
+	const QueryRingStats &stats = visible_instances_queries.get_stats();
+	if (stats.num_results + stats.num_skipped >= QUERY_STATS_FRAMES)
+	{
+		printf("visible instances count latency: avg %.2f, min %d, max %d frames, %d frames without query\n",
+			stats.get_avg_latency(), stats.min_latency, stats.max_latency, stats.num_skipped);
+		visible_instances_queries.reset_stats();
+	}
 
 	//next frame
 	frame_index++;
@@ -1056,140 +837,228 @@ void cull_objects(int first_processing_oject, int num_processing_ojects)
 	switch (culling_mode)
 	{
 	case SIMPLE_SPHERES:
-		simple_culling_spheres(&sphere_data[first_processing_oject], num_processing_ojects, &culling_res[first_processing_oject], &frustum.frustum_planes[0]);
+		simple_culling_spheres(&sphere_data[first_processing_oject], num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
 		break;
 	case SIMPLE_AABB:
-		simple_culling_aabb(&aabb_data[first_processing_oject], num_processing_ojects, &culling_res[first_processing_oject], &frustum.frustum_planes[0]);
+		simple_culling_aabb(&aabb_data[first_processing_oject], num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
 		break;
 	case SIMPLE_OBB:
-		simple_culling_obb(first_processing_oject, num_processing_ojects, &culling_res[0], &frustum.frustum_planes[0]);
+		simple_culling_obb(&obj_transforms[first_processing_oject], num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], box_min, box_max, culling_context);
 		break;
 
 	case SSE_SPHERES:
-		sse_culling_spheres(&sphere_data[first_processing_oject], num_processing_ojects, &culling_res[first_processing_oject], &frustum.frustum_planes[0]);
+		simd_culling_spheres(&sphere_data[first_processing_oject], num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
 		break;
 	case SSE_AABB:
-		sse_culling_aabb(&aabb_data[first_processing_oject], num_processing_ojects, &culling_res[first_processing_oject], &frustum.frustum_planes[0]);
+		simd_culling_aabb(&aabb_data[first_processing_oject], num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
 		break;
 	case SSE_OBB:
-		sse_culling_obb(first_processing_oject, num_processing_ojects, &culling_res[0], camera_view_proj_matrix);
+		simd_culling_obb(&obj_transforms[first_processing_oject], num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], box_min, box_max, culling_context);
 		break;
-	}
-}
 
-//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------threads
-Worker::Worker() : first_processing_oject(0), num_processing_ojects(0)
-{
-	//create 2 events: 1. to signal that we have a job 2.signal that we finished job
-	has_jobs_event = CreateEvent(NULL, false, false, NULL);
-	jobs_finished_event = CreateEvent(NULL, false, true, NULL);
-}
+	case SSE_SPHERES_SOA:
+		simd_culling_spheres_soa(bounds_soa.get_spheres(first_processing_oject), num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
+		break;
+	case SSE_AABB_SOA:
+		simd_culling_aabb_soa(bounds_soa.get_aabbs(first_processing_oject), num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
+		break;
+	case SSE_AABB_CE:
+		simd_culling_aabb_center_extent(bounds_soa.get_aabb_center_extents(first_processing_oject), num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
+		break;
+	case SSE_OBB_SOA:
+		simd_culling_obb_soa(bounds_soa.get_obbs(first_processing_oject), num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], box_min, box_max, culling_context);
+		break;
 
-Worker::~Worker()
-{
-	CloseHandle(has_jobs_event);
-	CloseHandle(jobs_finished_event);
-}
+	case SSE_AABB_BVH:
+	case SSE_AABB_GRID:
+	case SSE_AABB_OCCLUSION:
+		//visibility is already written by bvh.cull / grid.cull / cull_occlusion in do_cpu_culling
+		break;
 
-void Worker::doJob()
-{
-	//make our part of work
-	cull_objects(first_processing_oject, num_processing_ojects);
+	case SSE_SPHERES_COHERENT:
+		coherent_culling.cull(bounds_soa.get_spheres(first_processing_oject), first_processing_oject, num_processing_ojects, &visibility_mask[first_processing_oject / VISIBILITY_WORD_BITS], culling_context);
+		break;
+
+	default:
+		break;
+	}
 }
 
-unsigned __stdcall thread_func(void* arguments)
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------moving objects
+//updates all representations of object bounds. Bvh is only marked, bvh.refit() should be called before culling
+void set_instance_transform(int i, const mat4 &m)
 {
-	printf("In thread...\n");
-	Worker *worker = static_cast<Worker*>(arguments);
+	if (i < 0 || i >= MAX_SCENE_OBJECTS)
+		return;
 
-	//each worker has endless loop untill we signal to quit (stop_work flag)
-	while (true)
-	{
-		//wait for starting jobs
-		//if we have no job - just wait (has_jobs_event event). We do not wasting cpu work. Events designed for this.
-		WaitForSingleObject(worker->has_jobs_event, INFINITE);
+	obj_transforms[i].set(m);
 
-		//if we have signal to break - exit endless loop
-		if (worker->stop_work)
-			break;
+	vec3 pos = m * ((box_min + box_max) * 0.5f); //bounds center
+	sphere_data[i].pos = pos;
+	transform_aabb(box_min, box_max, m, aabb_data[i]);
 
-		//do job
-		worker->doJob();
+	bounds_soa.update_sphere(i, sphere_data[i]);
+	bounds_soa.update_aabb(i, aabb_data[i]);
+	bounds_soa.update_obb(i, obj_transforms[i]);
+	bvh.update_object(i, aabb_data[i]);
+	grid.update_object(i, aabb_data[i]);
+	coherent_culling.invalidate(i);
 
-		//signal that we finished the job
-		SetEvent(worker->jobs_finished_event);
-	}
+	instance_info[i * 2 + 0] = vec4(pos, bounding_radius);
+	pack_instance(pos, instance_info[i * 2 + 1], packed_instances[i]);
 
-	_endthreadex(0);
-	return 0;
+	if (!instance_dirty[i])
+	{
+		instance_dirty[i] = true;
+		num_dirty_instances++;
+	}
 }
 
-void create_threads()
+//random walk of some objects inside area
+void move_objects(float dt)
 {
-	//create the threads
-
-	//split the work into parts between threads
-	int worker_num_processing_ojects = MAX_SCENE_OBJECTS / num_workers;
-	int first_processing_oject = 0;
-
 	int i;
-	for (i = 0; i < num_workers; i++)
+	for (i = 0; i < NUM_MOVING_OBJECTS; i++)
 	{
-		//create threads
-		workers[i].thread_handle = (HANDLE)_beginthreadex(NULL, 0, &thread_func, &workers[i], CREATE_SUSPENDED, &workers[i].thread_id);
-		thread_handles[i] = workers[i].thread_handle;
-
-		//set threads parameters
-		workers[i].first_processing_oject = first_processing_oject;
-		workers[i].num_processing_ojects = worker_num_processing_ojects;
-		first_processing_oject += worker_num_processing_ojects;
+		int object = rndInt(MAX_SCENE_OBJECTS);
+		vec3 pos = vec3(instance_info[object * 2].x, instance_info[object * 2].y, instance_info[object * 2].z);
+		pos.x += rnd(-1.f, 1.f) * MOVING_SPEED * dt;
+		pos.z += rnd(-1.f, 1.f) * MOVING_SPEED * dt;
+		pos.x = pos.x < -AREA_SIZE ? -AREA_SIZE : (pos.x > AREA_SIZE ? AREA_SIZE : pos.x);
+		pos.z = pos.z < -AREA_SIZE ? -AREA_SIZE : (pos.z > AREA_SIZE ? AREA_SIZE : pos.z);
+
+		mat4 m;
+		m.set_translation(pos);
+		set_instance_transform(object, m);
 	}
 
-	//run workers to do their jobs
-	for (int i = 0; i < num_workers; i++)
-		ResumeThread(workers[i].thread_handle);
+	if (bvh.refit(&job_system))
+		frame_bvh_rebuilds++;
 }
 
-void threads_close()
+//instances moved since the last gpu culling, cpu culling modes don't read the vbo & keep them dirty
+void upload_dirty_instances()
 {
-	//signal to stop the work for all threads
-	for (int i = 0; i < num_workers; i++)
+	if (!num_dirty_instances)
+		return;
+
+	ProfileScope scope(profiler, "instances upload");
+	const int instance_size = 2 * (int)sizeof(vec4);
+	glBindBuffer(GL_ARRAY_BUFFER, all_instances_data_vbo);
+	if (num_dirty_instances > FULL_INSTANCES_UPLOAD_THRESHOLD)
 	{
-		workers[i].stop_work = true;
-		SetEvent(workers[i].has_jobs_event);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, MAX_SCENE_OBJECTS * instance_size, &instance_info[0]);
+		frame_upload_bytes += MAX_SCENE_OBJECTS * instance_size;
+		memset(&instance_dirty[0], 0, sizeof(instance_dirty));
 	}
+	else
+	{
+		int i = 0;
+		while (i < MAX_SCENE_OBJECTS)
+		{
+			if (!instance_dirty[i])
+			{
+				i++;
+				continue;
+			}
+
+			int first = i;
+			for (; i < MAX_SCENE_OBJECTS && instance_dirty[i]; i++)
+				instance_dirty[i] = false;
+			glBufferSubData(GL_ARRAY_BUFFER, first * instance_size, (i - first) * instance_size, &instance_info[first * 2]);
+			frame_upload_bytes += (i - first) * instance_size;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	num_dirty_instances = 0;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------profiling runs
+void set_scene_seed(int seed)
+{
+	scene_seed = seed;
+}
+
+bool play_camera_path(const char *file_name)
+{
+	if (!camera_path.load(file_name))
+		return false;
+	camera_path_playing = true;
+	camera_path_frame = 0;
+	camera.user_input = false;
+	printf("camera path: %d keys, %.2f s, %d frames\n", camera_path.get_num_keys(), camera_path.get_duration(),
+		int(camera_path.get_duration() / CAMERA_PATH_DT) + 1);
+	return true;
+}
 
-	//wait all workers to finish current jobs
-	WaitForMultipleObjects(num_workers, &thread_handles[0], true, INFINITE);
+bool is_camera_path_finished()
+{
+	return camera_path_playing && float(camera_path_frame) * CAMERA_PATH_DT > camera_path.get_duration();
+}
 
-	//remove workers
-	//_endthreadex is called automatically when the thread returns from the routine passed as a parameter
+void record_camera_path(const char *file_name)
+{
+	camera_path.clear();
+	camera_path_record_file = file_name;
+}
+
+void enable_profiler(const char *file_name)
+{
+	trace_file = file_name;
 }
 
+bool open_frame_stats(const char *file_name)
+{
+	frame_stats_file = fopen(file_name, "w");
+	if (!frame_stats_file)
+	{
+		fprintf(stderr, "can`t open \"%s\" file\n", file_name);
+		return false;
+	}
+	fprintf(frame_stats_file, "frame,time,mode,isa,threads,cull_ms,visible,upload_bytes,bvh_rebuilds,draw_ms,frame_ms\n");
+	frame_stats_index = 0;
+	return true;
+}
 
-void process_multithreading_culling()
+//culling of the frame for stats & profiler
+const char *get_frame_culling_name()
 {
-	//signal workers that they have the job
-	for (int i = 0; i < num_workers; i++)
-		SetEvent(workers[i].has_jobs_event);
+	if (!culling_enabled)
+		return "NONE";
+	if (use_gpu_culling)
+		return use_hiz_culling ? "GPU_HIZ" : "GPU";
+	return culling_mode_names[culling_mode];
 }
 
-void wate_multithreading_culling_done()
+void write_frame_stats(double cull_ms, double draw_ms, double frame_ms)
 {
-	//wait threads to do their jobs
-	HANDLE wait_events[num_workers];
-	for (int i = 0; i < num_workers; i++)
-		wait_events[i] = workers[i].jobs_finished_event;
-	WaitForMultipleObjects(num_workers, &wait_events[0], true, INFINITE);
+	const char *mode = get_frame_culling_name();
+
+	//compute shader culling leaves visible count only in draw command, frame is finished already, so it doesn't stall
+	int num_visible = enable_rendering_objects ? num_visible_instances : 0;
+	if (enable_rendering_objects && draw_visible_instances_indirect)
+	{
+		GLuint instance_count = 0;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draw_indirect_buffer);
+		glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, offsetof(DrawElementsIndirectCommand, instance_count), sizeof(GLuint), &instance_count);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		num_visible = (int)instance_count;
+	}
+
+	fprintf(frame_stats_file, "%d,%.4f,%s,%s,%d,%.4f,%d,%d,%d,%.4f,%.4f\n", frame_stats_index, total_time, mode, simd_level_names[get_simd_level()],
+		use_multithreading ? job_system.get_num_workers() : 1, cull_ms, num_visible, frame_upload_bytes, frame_bvh_rebuilds, draw_ms, frame_ms);
+	frame_stats_index++;
 }
 
 
 //---------------------------------------------------------------------------------------------------------------------------------------------------------------------------render
 void process_key(int key)
 {
+	int i;
 	switch(key)
 	{
-	case VK_SPACE:
+	case KEY_SPACE:
 		culling_enabled = !culling_enabled;
 		break;
 
@@ -1197,68 +1066,142 @@ void process_key(int key)
 		enable_rendering_objects = !enable_rendering_objects;
 		break;
 
-	case VK_NUMPAD0:
+	case 'M':
+		move_objects_enabled = !move_objects_enabled;
+		break;
+
+	case KEY_NUMPAD0:
 	case '0':
 		use_multithreading = !use_multithreading;
 		use_gpu_culling = false;
 		break;
 
-	case VK_NUMPAD1:
+	case KEY_NUMPAD1:
 	case '1':
 		culling_mode = SIMPLE_SPHERES;
 		use_gpu_culling = false;
 		break;
-	case VK_NUMPAD2:
+	case KEY_NUMPAD2:
 	case '2':
 		culling_mode = SIMPLE_AABB;
 		use_gpu_culling = false;
 		break;
-	case VK_NUMPAD3:
+	case KEY_NUMPAD3:
 	case '3':
 		culling_mode = SIMPLE_OBB;
 		use_gpu_culling = false;
 		break;
 
-	case VK_NUMPAD4:
+	case KEY_NUMPAD4:
 	case '4':
 		culling_mode = SSE_SPHERES;
 		use_gpu_culling = false;
 		break;
-	case VK_NUMPAD5:
+	case KEY_NUMPAD5:
 	case '5':
 		culling_mode = SSE_AABB;
 		use_gpu_culling = false;
 		break;
-	case VK_NUMPAD6:
+	case KEY_NUMPAD6:
 	case '6':
 		culling_mode = SSE_OBB;
 		use_gpu_culling = false;
 		break;
 
-	case VK_NUMPAD7:
+	case KEY_F1:
+		culling_mode = SSE_SPHERES_SOA;
+		use_gpu_culling = false;
+		break;
+	case KEY_F2:
+		culling_mode = SSE_AABB_SOA;
+		use_gpu_culling = false;
+		break;
+	case KEY_F3:
+		culling_mode = SSE_AABB_BVH;
+		use_gpu_culling = false;
+		break;
+	case KEY_F4:
+		culling_mode = SSE_AABB_GRID;
+		use_gpu_culling = false;
+		break;
+	case KEY_F5:
+		culling_mode = SSE_SPHERES_COHERENT;
+		use_gpu_culling = false;
+		break;
+	case KEY_F6:
+		culling_mode = SSE_AABB_CE;
+		use_gpu_culling = false;
+		break;
+	case KEY_F7:
+		culling_mode = SSE_OBB_SOA;
+		use_gpu_culling = false;
+		break;
+	case KEY_F8:
+		culling_mode = SSE_AABB_OCCLUSION;
+		use_gpu_culling = false;
+		break;
+
+	case KEY_NUMPAD7:
 	case '7':
 		use_gpu_culling = !use_gpu_culling;
 		break;
+
+	case KEY_NUMPAD9:
+	case '9':
+		use_hiz_culling = !use_hiz_culling;
+		break;
+
+	case 'P':
+		if (trace_file)
+			profiler.write_trace(trace_file);
+		break;
+
+	case KEY_NUMPAD8:
+	case '8':
+		//switch instruction set used by SSE_* modes
+		for (i = 1; i < NUM_SIMD_LEVELS; i++)
+			if (set_simd_level(SIMD_LEVEL((get_simd_level() + i) % NUM_SIMD_LEVELS)))
+				break;
+		printf("simd culling: %s\n", simd_level_names[get_simd_level()]);
+		break;
 	};
 }
 
 void RenderScene()
 {
 	int i, j, k;
+	Timer frame_timer;
+	frame_timer.StartTiming();
+	frame_upload_bytes = 0;
+	frame_bvh_rebuilds = 0;
+	profiler.begin_frame();
 
 //time
-	static double lastTime = timeGetTime() * 0.001;
+	static double lastTime = GetTimeInSeconds();
 	double timeleft = 0.0;
-	double currentTime = timeGetTime() * 0.001;
+	double currentTime = GetTimeInSeconds();
 	timeleft = currentTime - lastTime;
 	const double min_dt = 1.0f / 20.0;
 	if (timeleft > min_dt) timeleft = min_dt;
+	if (camera_path_playing) timeleft = CAMERA_PATH_DT;
 	lastTime = currentTime;
 	total_time += timeleft;
 
 
 //camera
+	if (camera_path_playing)
+	{
+		vec3 pos, view;
+		camera_path.evaluate(float(camera_path_frame) * CAMERA_PATH_DT, pos, view);
+		camera.PositionCamera(pos.x, pos.y, pos.z, view.x, view.y, view.z, 0.f, 1.f, 0.f);
+		camera_path_frame++;
+	}
 	camera.Update();
+	if (camera_path_record_file && total_time >= camera_path_next_key_time)
+	{
+		camera_path.add_key((float)total_time, camera.Position(), camera.View());
+		camera_path_next_key_time = total_time + CAMERA_PATH_RECORD_INTERVAL;
+	}
 	camera_view_matrix.look_at(camera.Position(), camera.View(), camera.UpVector());
 	camera_proj_matrix.perspective(45.f, (float)window_width / (float)window_height, zNear, zFar);
 	camera_view_proj_matrix = camera_proj_matrix * camera_view_matrix;
@@ -1274,12 +1217,22 @@ void RenderScene()
 	glDisable(GL_BLEND);
 
 
+//moving objects
+	if (move_objects_enabled)
+	{
+		ProfileScope scope(profiler, "move objects");
+		move_objects((float)timeleft);
+	}
+
 //objects culling
+	Timer cull_timer;
+	cull_timer.StartTiming();
 	if (culling_enabled)
 	{
+		ProfileScope scope(profiler, "culling");
 		//prepare camera & frustum
 		saved_inv_view_proj_matrix = camera_view_proj_matrix.inverse();
-		frustum.CalculateFrustum(camera_view_matrix, camera_proj_matrix);
+		culling_context.set(camera_view_proj_matrix);
 
 		//switch between gpu and cpu culling
 		if (use_gpu_culling)
@@ -1287,29 +1240,64 @@ void RenderScene()
 		else
 			do_cpu_culling();
 	}
+	double cull_ms = cull_timer.TimeElapsedInMS();
+	Timer draw_timer;
+	draw_timer.StartTiming();
 
 //render ground (just a plane)
-	ground_shader.bind();
-	glBindVertexArray(ground_vao_id);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
-	glBindVertexArray(0);
+	{
+		ProfileScope scope(profiler, "ground draw");
+		GpuProfileScope gpu_scope(profiler, "ground draw");
+		ground_shader.bind();
+		glBindVertexArray(ground_vao_id);
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+		glBindVertexArray(0);
+	}
 
 
 //geometry (colored boxes)
 	if (enable_rendering_objects)
 	{
+		ProfileScope scope(profiler, "instanced draw");
+		GpuProfileScope gpu_scope(profiler, "instanced draw");
 		glEnable(GL_CULL_FACE);
 		geometry_shader.bind();
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_BUFFER, dips_texture_buffer_tex);
-		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, dips_texture_buffer);
+		if (draw_from_upload_ring)
+			instance_upload_ring.bind_texture_buffer();
+		else
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32UI, dips_texture_buffer);
 
 		glBindVertexArray(geometry_vao_id);
-		glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, NULL, num_visible_instances);
+		if (draw_visible_instances_indirect)
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draw_indirect_buffer);
+			glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
+		else
+			glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, NULL, num_visible_instances);
 		glBindVertexArray(0);
+
+		//slot can be written again when gpu passes this point
+		if (draw_from_upload_ring)
+			instance_upload_ring.end_frame();
 	}
 	
+//hi-z for gpu culling of the next frame, built from depth of objects which passed culling of this frame
+	if (culling_enabled && use_gpu_culling && use_hiz_culling)
+	{
+		ProfileScope scope(profiler, "hi-z build");
+		GpuProfileScope gpu_scope(profiler, "hi-z build");
+		if (hiz_buffer.get_width() != window_width || hiz_buffer.get_height() != window_height)
+			hiz_buffer.init(window_width, window_height);
+		hiz_buffer.build(camera_view_proj_matrix);
+	}
+	else
+		hiz_buffer.invalidate();
+
 //show frustum
 	if (!culling_enabled)
 	{
@@ -1320,6 +1308,17 @@ void RenderScene()
 		glBindVertexArray(0);
 	}
 
-	glFlush();
-	SwapBuffers(g_hDC);
+	{
+		ProfileScope scope(profiler, "swap");
+		glFlush();
+		window_swap_buffers();
+	}
+
+	if (frame_stats_file)
+	{
+		glFinish();
+		double draw_ms = draw_timer.TimeElapsedInMS();
+		write_frame_stats(cull_ms, draw_ms, frame_timer.TimeElapsedInMS());
+	}
+	profiler.end_frame(get_frame_culling_name());
 }
\ No newline at end of file
@@ -2,15 +2,14 @@
 #define _MAIN_H
 
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
-#include <process.h>
-#include <mmsystem.h>
+#include <string.h>
+#include <ctype.h>
 #include <math.h>
-#include <gl\gl.h>										// Header File For The OpenGL32 Library
-#include <gl\glu.h>										// Header File For The GLu32 Library
-//#include <gl\glcorearb.h>
 
 #include "../glext/glext.h"
 
@@ -21,12 +20,6 @@
 #define SCREEN_HEIGHT 900 //900 768//1000								// We want our screen height 600 pixels
 #define SCREEN_DEPTH 32									// We want 16 bits per pixel
 
-extern bool  g_bFullScreen;								// Set full screen as default
-extern HWND  g_hWnd;									// This is the handle for the window
-extern RECT  g_rRect;									// This holds the window dimensions
-extern HDC   g_hDC;										// General HDC - (handle to device context)
-extern HGLRC g_hRC;										// General OpenGL_DC - Our Rendering Context for OpenGL
-extern HINSTANCE g_hInstance;							// This holds our window hInstance
 extern int window_width;
 extern int window_height;
 
@@ -57,8 +50,8 @@ extern int window_height;
 #include "Utilities.h"
 */
 
-#include "../timer/timer.h"
-#include "../random/random.h"
+#include "../Timer/Timer.h"
+#include "../random/Random.h"
 #include "Utilities.h"
 
 #include "../Camera/Camera.h"
@@ -152,43 +145,27 @@ struct Shader
 //------------------------------------------------------------------------------------------------------------------------------------------------------voids
 void CheckDebugLog();
 
-// This is our MAIN() for windows
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hprev, PSTR cmdline, int ishow);
-
-// The window proc which handles all of window's messages.
-LRESULT CALLBACK WinProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
-
-// This controls our main program loop
-WPARAM MainLoop();
-
-// This changes the screen to full screen mode
-void ChangeToFullScreen();
-
-// This is our own function that makes creating a window modular and easy
-HWND CreateMyWindow(LPSTR strWindowName, int width, int height, DWORD dwStyle, bool bFullScreen, HINSTANCE hInstance);
-
-// This allows us to configure our window for OpenGL and back buffering
-bool bSetupPixelFormat(HDC hdc);
-
 // This inits our screen translations and projections
 void SizeOpenGLScreen(int width, int height);
 
-// This sets up OpenGL
-void InitializeOpenGL(int width, int height);
-
-// This initializes the whole program
-void Init(HWND hWnd);
+// This initializes the whole program, gl context of the window should be current
+void Init();
 
 // This draws everything to the screen
 void RenderScene();
 
-// This frees all our memory in our program
-void DeInit();
-
 void ShutDown();
 
 void process_key(int key);
 
+// Profiling runs, called before Init()
+void set_scene_seed(int seed); // -1 - random scene
+bool play_camera_path(const char *file_name); // Camera & objects move with fixed time step, see CameraPath.h
+bool is_camera_path_finished();
+void record_camera_path(const char *file_name); // Camera keys of the run are saved at ShutDown()
+bool open_frame_stats(const char *file_name); // Per frame csv
+void enable_profiler(const char *file_name); // Chrome trace of the last frames is written at ShutDown() & by 'P' key
+
 extern bool opengl_debug_mode_enabled;
 
 #endif
\ No newline at end of file
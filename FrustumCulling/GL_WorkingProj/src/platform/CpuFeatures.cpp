@@ -0,0 +1,76 @@
+#include "CpuFeatures.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------cpuid
+static void cpuid(unsigned info[4], unsigned leaf, unsigned subleaf)
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)&info[0], (int)leaf, (int)subleaf);
+#else
+	__cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+//which registers state os saves on context switch
+static unsigned long long xgetbv0()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+struct CpuFeatures
+{
+	CpuFeatures() : avx2(false), avx512(false)
+	{
+		unsigned info[4]; //eax, ebx, ecx, edx
+		cpuid(info, 0, 0);
+		unsigned max_leaf = info[0];
+		if (max_leaf < 7)
+			return;
+
+		cpuid(info, 1, 0);
+		bool osxsave = (info[2] & (1u << 27)) != 0;
+		bool avx = (info[2] & (1u << 28)) != 0;
+		bool fma = (info[2] & (1u << 12)) != 0;
+		if (!osxsave || !avx)
+			return;
+
+		unsigned long long xcr0 = xgetbv0();
+		bool os_ymm = (xcr0 & 0x6) == 0x6; //xmm & ymm
+		bool os_zmm = (xcr0 & 0xe6) == 0xe6; //xmm, ymm, opmask & zmm
+
+		cpuid(info, 7, 0);
+		avx2 = os_ymm && fma && (info[1] & (1u << 5)) != 0;
+		avx512 = avx2 && os_zmm && (info[1] & (1u << 16)) != 0;
+	}
+
+	bool avx2;
+	bool avx512;
+};
+
+static const CpuFeatures &cpu_features()
+{
+	static CpuFeatures features;
+	return features;
+}
+
+bool cpu_supports_avx2()
+{
+	return cpu_features().avx2;
+}
+
+bool cpu_supports_avx512()
+{
+	return cpu_features().avx512;
+}
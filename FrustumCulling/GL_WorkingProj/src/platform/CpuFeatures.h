@@ -0,0 +1,9 @@
+#ifndef _CPU_FEATURES_H
+#define _CPU_FEATURES_H
+
+//runtime cpu instruction sets detection, both cpu and os (saving of wide registers) should support them
+
+bool cpu_supports_avx2(); //avx2 + fma
+bool cpu_supports_avx512(); //avx512f
+
+#endif
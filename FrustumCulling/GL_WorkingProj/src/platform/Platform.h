@@ -0,0 +1,64 @@
+#ifndef _PLATFORM_H
+#define _PLATFORM_H
+
+//compiler specific stuff, so the culling code may be built both with MSVC and gcc/clang
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+	#include <malloc.h>
+	#include <intrin.h>
+	#define ALIGN_AS(n) __declspec( align( n ) )
+#else
+	#include <mm_malloc.h>
+	#define ALIGN_AS(n) __attribute__(( aligned( n ) ))
+	#ifndef __forceinline
+		#define __forceinline inline __attribute__(( always_inline ))
+	#endif
+#endif
+
+
+//aligned allocation
+inline void *aligned_malloc(size_t size, size_t alignment)
+{
+#ifdef _MSC_VER
+	return _aligned_malloc(size, alignment);
+#else
+	return _mm_malloc(size, alignment);
+#endif
+}
+
+inline void aligned_free(void *ptr)
+{
+#ifdef _MSC_VER
+	_aligned_free(ptr);
+#else
+	_mm_free(ptr);
+#endif
+}
+
+
+//bit scan
+//index of lowest set bit (tzcnt/bsf), value should not be 0
+__forceinline int count_trailing_zeros(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return int(index);
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+__forceinline int count_bits(uint32_t value)
+{
+#ifdef _MSC_VER
+	return int(__popcnt(value));
+#else
+	return __builtin_popcount(value);
+#endif
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _WINDOW_H
+#define _WINDOW_H
+
+//window, opengl context & input of the demo, one backend is compiled:
+//WindowWin32.cpp - win32 window with wgl core profile context,
+//WindowEGL.cpp - offscreen egl pbuffer context for headless linux servers (gpu by EGL_EXT_platform_device or mesa without display),
+//it has no input, its title is printed to stdout
+
+//key codes, the same values as win32 virtual keys. Letters & digits are upper case ascii
+enum WINDOW_KEY
+{
+	KEY_RBUTTON = 0x02,
+	KEY_ESCAPE = 0x1B,
+	KEY_SPACE = 0x20,
+	KEY_NUMPAD0 = 0x60,
+	KEY_NUMPAD1, KEY_NUMPAD2, KEY_NUMPAD3, KEY_NUMPAD4, KEY_NUMPAD5, KEY_NUMPAD6, KEY_NUMPAD7, KEY_NUMPAD8, KEY_NUMPAD9,
+	KEY_F1 = 0x70,
+	KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12,
+};
+
+typedef void(*WindowKeyHandler)(int key);
+
+bool window_create(const char *title, int width, int height, bool fullscreen); //makes gl context current, false if it isn't created
+void window_destroy();
+bool window_is_headless();
+
+bool window_process_events(WindowKeyHandler on_key_down); //false when window is closed, escape closes it
+void window_swap_buffers();
+void window_get_size(int &width, int &height); //drawable size, may change after window_process_events()
+void window_set_title(const char *title);
+void window_set_vsync(bool enabled);
+
+bool window_is_key_down(int key);
+bool window_get_cursor_pos(int &x, int &y); //screen coordinates, false if there is no cursor
+void window_set_cursor_pos(int x, int y);
+
+void *window_get_proc_address(const char *name); //gl functions of the current context
+
+#endif
@@ -0,0 +1,198 @@
+#include "Window.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <string.h>
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------egl context
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLSurface surface = EGL_NO_SURFACE;
+static EGLContext context = EGL_NO_CONTEXT;
+static int surface_width = 0;
+static int surface_height = 0;
+
+static bool has_client_extension(const char *name)
+{
+	const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (!extensions)
+		return false;
+	size_t len = strlen(name);
+	for (const char *p = strstr(extensions, name); p; p = strstr(p + len, name))
+		if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+			return true;
+	return false;
+}
+
+static EGLDisplay init_display(EGLDisplay dpy)
+{
+	EGLint major, minor;
+	if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor))
+		return EGL_NO_DISPLAY;
+	return dpy;
+}
+
+//the first gpu which works without display server, then mesa without any display (llvmpipe if there is no gpu), then default display
+static EGLDisplay open_display()
+{
+	EGLDisplay dpy = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (get_platform_display && has_client_extension("EGL_EXT_platform_device"))
+	{
+		PFNEGLQUERYDEVICESEXTPROC query_devices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+		EGLDeviceEXT devices[8];
+		EGLint num_devices = 0;
+		if (query_devices && query_devices(8, devices, &num_devices))
+			for (int i = 0; i < num_devices && dpy == EGL_NO_DISPLAY; i++)
+				dpy = init_display(get_platform_display(EGL_PLATFORM_DEVICE_EXT, devices[i], NULL));
+	}
+
+	if (dpy == EGL_NO_DISPLAY && get_platform_display && has_client_extension("EGL_MESA_platform_surfaceless"))
+		dpy = init_display(get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL));
+
+	if (dpy == EGL_NO_DISPLAY)
+		dpy = init_display(eglGetDisplay(EGL_DEFAULT_DISPLAY));
+	return dpy;
+}
+
+bool window_create(const char *title, int width, int height, bool fullscreen)
+{
+	window_destroy();
+	if (width <= 0 || height <= 0)
+		return false;
+
+	display = open_display();
+	if (display == EGL_NO_DISPLAY || !eglBindAPI(EGL_OPENGL_API))
+	{
+		fprintf(stderr, "egl: can`t open display\n");
+		window_destroy();
+		return false;
+	}
+
+	//pbuffer is default framebuffer of the context, so the demo renders to framebuffer 0 as with window
+	const EGLint config_attributes[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglChooseConfig(display, config_attributes, &config, 1, &num_configs) || !num_configs)
+	{
+		fprintf(stderr, "egl: no pbuffer config with depth buffer\n");
+		window_destroy();
+		return false;
+	}
+
+	const EGLint surface_attributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	surface = eglCreatePbufferSurface(display, config, surface_attributes);
+	if (surface == EGL_NO_SURFACE)
+	{
+		fprintf(stderr, "egl: can`t create %dx%d pbuffer\n", width, height);
+		window_destroy();
+		return false;
+	}
+
+	//the newest core profile, as wgl context of the window
+	const int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 4 }, { 4, 3 }, { 4, 0 }, { 3, 3 } };
+	for (size_t i = 0; i < sizeof(versions) / sizeof(versions[0]) && context == EGL_NO_CONTEXT; i++)
+	{
+		const EGLint context_attributes[] =
+		{
+			EGL_CONTEXT_MAJOR_VERSION, versions[i][0],
+			EGL_CONTEXT_MINOR_VERSION, versions[i][1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+	}
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+	{
+		fprintf(stderr, "egl: can`t create gl 3.3+ core profile context\n");
+		window_destroy();
+		return false;
+	}
+
+	surface_width = width;
+	surface_height = height;
+	printf("egl: %s, headless %dx%d\n", eglQueryString(display, EGL_VENDOR), width, height);
+	return true;
+}
+
+void window_destroy()
+{
+	if (display != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		if (surface != EGL_NO_SURFACE)
+			eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+	display = EGL_NO_DISPLAY;
+	surface = EGL_NO_SURFACE;
+	context = EGL_NO_CONTEXT;
+	surface_width = surface_height = 0;
+}
+
+bool window_is_headless()
+{
+	return true;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------frame
+bool window_process_events(WindowKeyHandler on_key_down)
+{
+	return context != EGL_NO_CONTEXT;
+}
+
+void window_swap_buffers()
+{
+	eglSwapBuffers(display, surface);
+}
+
+void window_get_size(int &width, int &height)
+{
+	width = surface_width;
+	height = surface_height;
+}
+
+void window_set_title(const char *title)
+{
+	printf("%s\n", title);
+}
+
+void window_set_vsync(bool enabled)
+{
+	eglSwapInterval(display, enabled ? 1 : 0);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------input
+bool window_is_key_down(int key)
+{
+	return false;
+}
+
+bool window_get_cursor_pos(int &x, int &y)
+{
+	return false;
+}
+
+void window_set_cursor_pos(int x, int y)
+{
+}
+
+void *window_get_proc_address(const char *name)
+{
+	return (void*)eglGetProcAddress(name);
+}
@@ -0,0 +1,320 @@
+#include "Window.h"
+
+#include <windows.h>
+#include <stdio.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/wglext.h>
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------window
+static HINSTANCE g_hInstance = NULL;					// This holds our window hInstance
+static HWND g_hWnd = NULL;								// This is the handle for the window
+static HDC g_hDC = NULL;								// General HDC - (handle to device context)
+static HGLRC g_hRC = NULL;								// General OpenGL_DC - Our Rendering Context for OpenGL
+static bool g_bFullScreen = false;
+static RECT g_rRect;									// This holds the window dimensions
+static bool g_bQuit = false;
+static WindowKeyHandler key_handler = NULL;				// process_key() of the app while messages are dispatched
+
+static LRESULT CALLBACK WinProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	LONG    lRet = 0;
+
+	switch (uMsg)
+	{
+	case WM_SIZE:										// If the window is resized
+		if (!g_bFullScreen)								// Do this only if we are NOT in full screen
+			GetClientRect(hWnd, &g_rRect);				// Get the window rectangle
+		break;
+
+
+	case WM_KEYDOWN:
+		switch (wParam) {							// Check if we hit a key
+		case VK_ESCAPE:								// If we hit the escape key
+			PostQuitMessage(0);						// Send a QUIT message to the window
+			break;
+		default:
+			if (key_handler)
+				key_handler((int)wParam);
+			break;
+		}
+		break;
+
+
+	case WM_DESTROY:									// If the window is destroyed
+		PostQuitMessage(0);								// Send a QUIT Message to the window
+		break;
+
+	default:											// Return by default
+		lRet = (long)DefWindowProc(hWnd, uMsg, wParam, lParam);
+		break;
+	}
+	return lRet;										// Return by default
+}
+
+static void ChangeToFullScreen(int width, int height)
+{
+	DEVMODE dmSettings;									// Device Mode variable
+	memset(&dmSettings, 0, sizeof(dmSettings));			// Makes Sure Memory's Cleared
+	if (!EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &dmSettings))
+	{
+		MessageBox(NULL, "Could Not Enum Display Settings", "Error", MB_OK);
+		return;
+	}
+
+	dmSettings.dmPelsWidth = width;						// Selected Screen Width
+	dmSettings.dmPelsHeight = height;					// Selected Screen Height
+	int result = ChangeDisplaySettings(&dmSettings, CDS_FULLSCREEN);
+
+	if (result != DISP_CHANGE_SUCCESSFUL)
+	{
+		MessageBox(NULL, "Display Mode Not Compatible", "Error", MB_OK);
+		PostQuitMessage(0);
+	}
+}
+
+static HWND CreateMyWindow(LPCSTR strWindowName, int width, int height, DWORD dwStyle, bool bFullScreen, HINSTANCE hInstance)
+{
+	HWND hWnd;
+	WNDCLASS wndclass;
+
+	memset(&wndclass, 0, sizeof(WNDCLASS));				// Init the size of the class
+	wndclass.style = CS_HREDRAW | CS_VREDRAW;			// Regular drawing capabilities
+	wndclass.lpfnWndProc = WinProc;						// Pass our function pointer as the window procedure
+	wndclass.hInstance = hInstance;						// Assign our hInstance
+	wndclass.hIcon = LoadIcon(NULL, IDI_APPLICATION);	// General icon
+	wndclass.hCursor = LoadCursor(NULL, IDC_ARROW);		// An arrow for the cursor
+	wndclass.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);	// A white window
+	wndclass.lpszClassName = "Engine";			// Assign the class name
+
+	RegisterClass(&wndclass);							// Register the class
+
+	if (bFullScreen && !dwStyle) 						// Check if we wanted full screen mode
+	{													// Set the window properties for full screen mode
+		dwStyle = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+		ChangeToFullScreen(width, height);				// Go to full screen
+		ShowCursor(FALSE);								// Hide the cursor
+	}
+	else if (!dwStyle)									// Assign styles to the window depending on the choice
+		dwStyle = WS_OVERLAPPEDWINDOW | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+
+	g_hInstance = hInstance;							// Assign our global hInstance to the window's hInstance
+
+	RECT rWindow;
+	rWindow.left = 0;								// Set Left Value To 0
+	rWindow.right = width;							// Set Right Value To Requested Width
+	rWindow.top = 0;								// Set Top Value To 0
+	rWindow.bottom = height;							// Set Bottom Value To Requested Height
+
+	AdjustWindowRect(&rWindow, dwStyle, false);		// Adjust Window To True Requested Size
+
+													// Create the window
+	hWnd = CreateWindow("Engine", strWindowName, dwStyle, 0, 0,
+		rWindow.right - rWindow.left, rWindow.bottom - rWindow.top,
+		NULL, NULL, hInstance, NULL);
+
+	if (!hWnd) return NULL;								// If we could get a handle, return NULL
+
+	ShowWindow(hWnd, SW_SHOWNORMAL);					// Show the window
+	UpdateWindow(hWnd);									// Draw the window
+
+	SetFocus(hWnd);										// Sets Keyboard Focus To The Window
+
+	return hWnd;
+}
+
+static bool bSetupPixelFormat(HDC hdc)
+{
+	int pixelformat;
+	PIXELFORMATDESCRIPTOR pfd;
+	memset(&pfd, 0, sizeof(pfd));
+	pfd.nSize = sizeof(pfd);
+	pfd.nVersion = 1;
+	pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+	pfd.iPixelType = PFD_TYPE_RGBA;
+	pfd.cColorBits = 32;
+	pfd.cDepthBits = 24;
+
+	if ((pixelformat = ChoosePixelFormat(hdc, &pfd)) == FALSE)
+	{
+		MessageBox(NULL, "ChoosePixelFormat failed", "Error", MB_OK);
+		return FALSE;
+	}
+
+	if (SetPixelFormat(hdc, pixelformat, &pfd) == FALSE)
+	{
+		MessageBox(NULL, "SetPixelFormat failed", "Error", MB_OK);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+//legacy context gives max gl version, then core profile context of that version replaces it
+static bool InitializeOpenGL()
+{
+	g_hDC = GetDC(g_hWnd);								// This sets our global HDC
+														// We don't free this hdc until the end of our program
+	if (!bSetupPixelFormat(g_hDC))						// This sets our pixel format/information
+		return false;
+
+	HGLRC legacy_rc = wglCreateContext(g_hDC);			// This creates a rendering context from our hdc
+	wglMakeCurrent(g_hDC, legacy_rc);					// This makes the rendering context we just created the one we want to use
+
+//get max gl version
+	int  major, minor;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	int attributes[] =
+	{
+		WGL_CONTEXT_MAJOR_VERSION_ARB, major,
+		WGL_CONTEXT_MINOR_VERSION_ARB, minor,
+		WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB |
+		WGL_CONTEXT_DEBUG_BIT_ARB,
+		WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+		0
+	};
+
+	PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC)
+		wglGetProcAddress("wglCreateContextAttribsARB");
+
+	//legacy context is used if core profile can't be created
+	g_hRC = legacy_rc;
+	if (NULL == wglCreateContextAttribsARB)
+		return true;
+
+	HGLRC hRC = wglCreateContextAttribsARB(g_hDC, 0, attributes);
+	if (!hRC)
+		return true;
+	if (!wglMakeCurrent(g_hDC, hRC))
+	{
+		wglDeleteContext(hRC);
+		wglMakeCurrent(g_hDC, legacy_rc);
+		return true;
+	}
+	wglDeleteContext(legacy_rc);
+	g_hRC = hRC;
+	return true;
+}
+
+bool window_create(const char *title, int width, int height, bool fullscreen)
+{
+	g_bFullScreen = fullscreen;
+	g_bQuit = false;
+
+	g_hWnd = CreateMyWindow(title, width, height, 0, g_bFullScreen, GetModuleHandle(NULL));
+	if (g_hWnd == NULL)
+		return false;
+	GetClientRect(g_hWnd, &g_rRect);					// Assign the windows rectangle to a global RECT
+
+	if (!InitializeOpenGL())
+	{
+		window_destroy();
+		return false;
+	}
+	return true;
+}
+
+void window_destroy()
+{
+	if (g_hRC)
+	{
+		wglMakeCurrent(NULL, NULL);						// This frees our rendering memory and sets everything back to normal
+		wglDeleteContext(g_hRC);						// Delete our OpenGL Rendering Context
+	}
+
+	if (g_hDC)
+		ReleaseDC(g_hWnd, g_hDC);						// Release our HDC from memory
+
+	if (g_bFullScreen)									// If we were in full screen:
+	{
+		ChangeDisplaySettings(NULL, 0);					// Switch Back To The Desktop
+		ShowCursor(TRUE);								// Show Mouse Pointer
+	}
+
+	if (g_hWnd)
+		DestroyWindow(g_hWnd);
+	UnregisterClass("Engine", g_hInstance);				// Free the window class
+
+	g_hRC = NULL;
+	g_hDC = NULL;
+	g_hWnd = NULL;
+}
+
+bool window_is_headless()
+{
+	return false;
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------frame
+bool window_process_events(WindowKeyHandler on_key_down)
+{
+	MSG msg;
+
+	key_handler = on_key_down;
+	while (!g_bQuit && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (msg.message == WM_QUIT)
+			g_bQuit = true;
+		TranslateMessage(&msg);						// Find out what the message does
+		DispatchMessage(&msg);						// Execute the message
+	}
+	key_handler = NULL;
+	return !g_bQuit;
+}
+
+void window_swap_buffers()
+{
+	SwapBuffers(g_hDC);
+}
+
+void window_get_size(int &width, int &height)
+{
+	width = g_rRect.right - g_rRect.left;
+	height = g_rRect.bottom - g_rRect.top;
+}
+
+void window_set_title(const char *title)
+{
+	SetWindowText(g_hWnd, title);
+}
+
+void window_set_vsync(bool enabled)
+{
+	PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
+	if (wglSwapIntervalEXT) wglSwapIntervalEXT(enabled ? 1 : 0);
+}
+
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------------------------input
+bool window_is_key_down(int key)
+{
+	return (GetKeyState(key) & 0x80) != 0;
+}
+
+bool window_get_cursor_pos(int &x, int &y)
+{
+	POINT pos;
+	if (!GetCursorPos(&pos))
+		return false;
+	x = pos.x;
+	y = pos.y;
+	return true;
+}
+
+void window_set_cursor_pos(int x, int y)
+{
+	SetCursorPos(x, y);
+}
+
+//gl 1.1 functions are exported only by opengl32.dll, wglGetProcAddress returns newer ones
+void *window_get_proc_address(const char *name)
+{
+	void *proc = (void*)wglGetProcAddress(name);
+	if (!proc)
+		proc = (void*)GetProcAddress(GetModuleHandle("opengl32.dll"), name);
+	return proc;
+}
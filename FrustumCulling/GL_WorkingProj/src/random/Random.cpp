@@ -1,12 +1,14 @@
-#include <windows.h>
+#include <stdlib.h>
 #include "Random.h"
 
 //fast random funcs
 float RNDtable[65536];
-static WORD RNDcurrent=0;
+static uint16_t RNDcurrent=0;
 
-void rndInit(void){ srand(0); for(int i=0;i<65536;i++) RNDtable[i]=((float)rand())/32767.0f; }
+void rndInit(void){ srand(0); for(int i=0;i<65536;i++) RNDtable[i]=((float)rand())/(float)RAND_MAX; }
 float rnd(float from,float to) { RNDcurrent++; return from+(to-from)*RNDtable[RNDcurrent]; if (RNDcurrent>=65535) RNDcurrent=0; }
 float rnd01() { RNDcurrent++; return RNDtable[RNDcurrent]; if (RNDcurrent>=65535) RNDcurrent=0; }
+//two table values give 30 bits, one has only 15 with msvc RAND_MAX
+int rndInt(int count) { int hi=(int)(rnd01()*32767.f), lo=(int)(rnd01()*32767.f); int i=(int)((double(hi)*32768.0+lo)/1073741824.0*count); return i<count ? i : count-1; }
 void rndSeed(int seed) { RNDcurrent=seed; if (RNDcurrent>=65535) RNDcurrent=0; }
-float rndTable(WORD index) {return RNDtable[index];}
\ No newline at end of file
+float rndTable(uint16_t index) {return RNDtable[index];}
\ No newline at end of file
@@ -1,12 +1,13 @@
 #ifndef _Random_h
 #define _Random_h
 
-#include <windows.h>
+#include <stdint.h>
 
 void rndInit(void);
 float rnd(float from,float to);
 float rnd01();
+int rndInt(int count); //0..count-1
 void rndSeed(int seed);
-float rndTable(WORD index);
+float rndTable(uint16_t index);
 
 #endif